@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <stdexcept>
+#include "bigdecimal.h"
+
+//10^0 through 10^19, the powers of ten that fit in a limb
+static const uint64_t SMALL_POWERS_OF_TEN[] = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+  100000000UL, 1000000000UL, 10000000000UL, 100000000000UL, 1000000000000UL,
+  10000000000000UL, 100000000000000UL, 1000000000000000UL, 10000000000000000UL,
+  100000000000000000UL, 1000000000000000000UL, 10000000000000000000UL
+};
+
+BigDecimal::BigDecimal() : unscaled(), digits(0) {
+}
+
+BigDecimal::BigDecimal(const BigInt &unscaled, unsigned scale) : unscaled(unscaled), digits(scale) {
+}
+
+BigInt BigDecimal::power_of_ten(unsigned n) {
+  if (n < 20) {
+    return BigInt(SMALL_POWERS_OF_TEN[n]);
+  }
+  return BigInt(SMALL_POWERS_OF_TEN[19]).pow(n / 19) * BigInt(SMALL_POWERS_OF_TEN[n % 19]);
+}
+
+//Truncates with divmod, then moves the quotient one unit away from zero
+//when the mode and the size of the remainder call for it
+BigInt BigDecimal::divide_rounded(const BigInt &num, const BigInt &den, RoundingMode mode) {
+  std::pair<BigInt, BigInt> qr = num.divmod(den);
+  BigInt &q = qr.first;
+  BigInt &r = qr.second;
+  if (r == BigInt()) {
+    return q;
+  }
+
+  bool negative = num.is_negative() != den.is_negative();
+  bool away;
+  if (mode == RoundingMode::DOWN) {
+    away = false;
+  } else if (mode == RoundingMode::UP) {
+    away = true;
+  } else if (mode == RoundingMode::FLOOR) {
+    away = negative;
+  } else if (mode == RoundingMode::CEILING) {
+    away = !negative;
+  } else {
+    //Compare twice the remainder with the divisor to find which half it is in
+    BigInt twice = r.is_negative() ? -r : r;
+    twice <<= 1;
+    int half = twice.compare(den.is_negative() ? -den : den);
+    if (mode == RoundingMode::HALF_UP) {
+      away = half >= 0;
+    } else if (mode == RoundingMode::HALF_DOWN) {
+      away = half > 0;
+    } else {
+      away = half > 0 || (half == 0 && q.is_bit_set(0));
+    }
+  }
+
+  if (away) {
+    q += BigInt(1, negative);
+  }
+  return q;
+}
+
+BigInt BigDecimal::unscaled_at(unsigned scale) const {
+  if (scale == digits) {
+    return unscaled;
+  }
+  return unscaled * power_of_ten(scale - digits);
+}
+
+BigDecimal BigDecimal::with_scale(unsigned scale, RoundingMode mode) const {
+  if (scale >= digits) {
+    return BigDecimal(unscaled_at(scale), scale);
+  }
+  return BigDecimal(divide_rounded(unscaled, power_of_ten(digits - scale), mode), scale);
+}
+
+BigDecimal BigDecimal::operator+(const BigDecimal &rhs) const {
+  BigDecimal result(*this);
+  result += rhs;
+  return result;
+}
+
+BigDecimal BigDecimal::operator-(const BigDecimal &rhs) const {
+  BigDecimal result(*this);
+  result -= rhs;
+  return result;
+}
+
+BigDecimal BigDecimal::operator*(const BigDecimal &rhs) const {
+  return BigDecimal(unscaled * rhs.unscaled, digits + rhs.digits);
+}
+
+//Equal scales add the unscaled values directly; otherwise the operand
+//with fewer digits is scaled up first
+BigDecimal &BigDecimal::operator+=(const BigDecimal &rhs) {
+  if (digits == rhs.digits) {
+    unscaled += rhs.unscaled;
+  } else if (digits > rhs.digits) {
+    unscaled += rhs.unscaled_at(digits);
+  } else {
+    unscaled = unscaled_at(rhs.digits) + rhs.unscaled;
+    digits = rhs.digits;
+  }
+  return *this;
+}
+
+BigDecimal &BigDecimal::operator-=(const BigDecimal &rhs) {
+  if (digits == rhs.digits) {
+    unscaled -= rhs.unscaled;
+  } else if (digits > rhs.digits) {
+    unscaled -= rhs.unscaled_at(digits);
+  } else {
+    unscaled = unscaled_at(rhs.digits) - rhs.unscaled;
+    digits = rhs.digits;
+  }
+  return *this;
+}
+
+BigDecimal &BigDecimal::operator*=(const BigDecimal &rhs) {
+  unscaled *= rhs.unscaled;
+  digits += rhs.digits;
+  return *this;
+}
+
+BigDecimal BigDecimal::operator-() const {
+  return BigDecimal(-unscaled, digits);
+}
+
+//a/10^s divided by b/10^t at scale k is a * 10^(k + t - s) / b, or
+//a / (b * 10^(s - t - k)) when that exponent is negative
+BigDecimal BigDecimal::divide(const BigDecimal &rhs, unsigned scale, RoundingMode mode) const {
+  if (rhs.unscaled == BigInt()) {
+    throw std::invalid_argument("Cannot divide by zero");
+  }
+  long long exponent = (long long) scale + rhs.digits - digits;
+  BigInt num = unscaled;
+  BigInt den = rhs.unscaled;
+  if (exponent >= 0) {
+    num *= power_of_ten(unsigned(exponent));
+  } else {
+    den *= power_of_ten(unsigned(-exponent));
+  }
+  return BigDecimal(divide_rounded(num, den, mode), scale);
+}
+
+BigDecimal BigDecimal::operator/(const BigDecimal &rhs) const {
+  return divide(rhs, std::max(digits, rhs.digits), RoundingMode::HALF_EVEN);
+}
+
+//Values of different signs compare without rescaling
+int BigDecimal::compare(const BigDecimal &rhs) const {
+  if (digits == rhs.digits) {
+    return unscaled.compare(rhs.unscaled);
+  }
+  if (is_negative() != rhs.is_negative()) {
+    return is_negative() ? -1 : 1;
+  }
+  unsigned scale = std::max(digits, rhs.digits);
+  return unscaled_at(scale).compare(rhs.unscaled_at(scale));
+}
+
+//Formats the magnitude with to_dec and inserts the point, padding with
+//zeroes so there is at least one digit before it
+std::string BigDecimal::to_string() const {
+  std::string magnitude = (is_negative() ? -unscaled : unscaled).to_dec();
+  if (magnitude.size() <= digits) {
+    magnitude.insert(0, digits + 1 - magnitude.size(), '0');
+  }
+  if (digits > 0) {
+    magnitude.insert(magnitude.size() - digits, 1, '.');
+  }
+  if (is_negative()) {
+    magnitude.insert(0, 1, '-');
+  }
+  return magnitude;
+}
+
+//Removes the point and parses the remaining digits as one integer
+BigDecimal BigDecimal::from_string(const std::string &str) {
+  size_t point = str.find('.');
+  if (point == std::string::npos) {
+    return BigDecimal(BigInt::from_dec(str), 0);
+  }
+  size_t sign = (!str.empty() && str[0] == '-') ? 1 : 0;
+  if (point == sign || point + 1 == str.size()) {
+    throw std::invalid_argument("Decimal point must have digits on both sides");
+  }
+  std::string joined = str.substr(0, point) + str.substr(point + 1);
+  return BigDecimal(BigInt::from_dec(joined), unsigned(str.size() - point - 1));
+}
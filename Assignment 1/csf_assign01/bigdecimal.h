@@ -0,0 +1,133 @@
+#ifndef BIGDECIMAL_H
+#define BIGDECIMAL_H
+
+#include <string>
+#include "bigint.h"
+
+//! @file
+//! Fixed-point decimal numbers with an arbitrary-precision mantissa.
+
+//! How to round a result that falls between two representable values.
+enum class RoundingMode {
+  DOWN,      //!< toward zero (truncate)
+  UP,        //!< away from zero
+  FLOOR,     //!< toward negative infinity
+  CEILING,   //!< toward positive infinity
+  HALF_UP,   //!< to the nearest value, ties away from zero
+  HALF_DOWN, //!< to the nearest value, ties toward zero
+  HALF_EVEN  //!< to the nearest value, ties to the even neighbour (banker's rounding)
+};
+
+//! Decimal number `unscaled * 10^-scale`, e.g. `12.50` is the unscaled
+//! value 1250 with scale 2. Addition, subtraction and multiplication are
+//! exact: sums have the larger scale of the operands and products the
+//! sum of the scales. Division has to round, so it takes the result
+//! scale and a RoundingMode.
+//!
+//! Values compare by their numeric value, so `1.5 == 1.50`; scale() and
+//! to_string() still tell them apart.
+class BigDecimal {
+private:
+  BigInt unscaled;
+  unsigned digits; // the scale
+
+public:
+  //! Default constructor: 0 with scale 0.
+  BigDecimal();
+
+  //! Constructor from an unscaled value and a scale.
+  //!
+  //! @param unscaled the value times `10^scale`
+  //! @param scale the number of digits after the decimal point
+  BigDecimal(const BigInt &unscaled, unsigned scale = 0);
+
+  //! @return the value times `10^scale()`
+  const BigInt &unscaled_value() const { return unscaled; }
+
+  //! @return the number of digits after the decimal point
+  unsigned scale() const { return digits; }
+
+  //! @return true if the value is negative
+  bool is_negative() const { return unscaled.is_negative(); }
+
+  //! Change the scale. Adding digits is exact; removing digits rounds.
+  //!
+  //! @param scale the new number of digits after the decimal point
+  //! @param mode how to round when digits are removed
+  //! @return this value with the new scale
+  BigDecimal with_scale(unsigned scale, RoundingMode mode = RoundingMode::HALF_EVEN) const;
+
+  //! Exact arithmetic operators. When the scales of the operands are
+  //! equal (the usual case for amounts of one currency), + and - work
+  //! on the unscaled values directly without rescaling.
+  BigDecimal operator+(const BigDecimal &rhs) const;
+  BigDecimal operator-(const BigDecimal &rhs) const;
+  BigDecimal operator*(const BigDecimal &rhs) const;
+  BigDecimal &operator+=(const BigDecimal &rhs);
+  BigDecimal &operator-=(const BigDecimal &rhs);
+  BigDecimal &operator*=(const BigDecimal &rhs);
+
+  //! @return the negation of this value, with the same scale
+  BigDecimal operator-() const;
+
+  //! Division with an explicit result scale and rounding.
+  //!
+  //! @param rhs the divisor
+  //! @param scale the scale of the result
+  //! @param mode how to round the quotient
+  //! @return the rounded quotient
+  //! @throw std::invalid_argument if `rhs` is 0
+  BigDecimal divide(const BigDecimal &rhs, unsigned scale, RoundingMode mode) const;
+
+  //! Division to the larger scale of the operands, rounding half to even.
+  //!
+  //! @throw std::invalid_argument if `rhs` is 0
+  BigDecimal operator/(const BigDecimal &rhs) const;
+
+  //! Compare numeric values, returning negative, 0 or positive if this
+  //! value is less than, equal to or greater than `rhs`.
+  int compare(const BigDecimal &rhs) const;
+
+  bool operator==(const BigDecimal &rhs) const { return compare(rhs) == 0; }
+  bool operator!=(const BigDecimal &rhs) const { return compare(rhs) != 0; }
+  bool operator<(const BigDecimal &rhs) const  { return compare(rhs) < 0; }
+  bool operator<=(const BigDecimal &rhs) const { return compare(rhs) <= 0; }
+  bool operator>(const BigDecimal &rhs) const  { return compare(rhs) > 0; }
+  bool operator>=(const BigDecimal &rhs) const { return compare(rhs) >= 0; }
+
+  //! Format the value with exactly scale() digits after the decimal
+  //! point (and no point if the scale is 0), e.g. `-0.050`.
+  //!
+  //! @return the value in decimal
+  std::string to_string() const;
+
+  //! Parse an optional minus sign, one or more digits, and optionally a
+  //! decimal point followed by one or more digits. The scale of the
+  //! result is the number of digits after the point, so
+  //! `from_string(x.to_string())` gives back `x` exactly.
+  //!
+  //! @param str the string to parse
+  //! @return the value
+  //! @throw std::invalid_argument if the string is not a valid decimal number
+  static BigDecimal from_string(const std::string &str);
+
+  //! @param n an exponent
+  //! @return `10^n`; exponents up to 19 come from a table
+  static BigInt power_of_ten(unsigned n);
+
+  //! Integer division rounded with the given mode; the building block of
+  //! divide() and with_scale(), also used by BigRational.
+  //!
+  //! @param num the dividend
+  //! @param den the divisor
+  //! @param mode how to round the quotient
+  //! @return `num / den`, rounded
+  //! @throw std::invalid_argument if `den` is 0
+  static BigInt divide_rounded(const BigInt &num, const BigInt &den, RoundingMode mode);
+
+private:
+  //! @return the unscaled value of this number at a scale at least scale()
+  BigInt unscaled_at(unsigned scale) const;
+};
+
+#endif // BIGDECIMAL_H
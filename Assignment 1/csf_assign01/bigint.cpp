@@ -1,27 +1,44 @@
 #include <cassert>
 #include "bigint.h"
-#include <sstream> // For std::stringstream
-#include <iomanip> // For std::setfill, std::setw
+#include "limb_ops.h"
+#include "limb_arena.h"
+#include "montgomery.h"
+#include "bigint_view.h"
+#include "radix_powers.h"
 #include <string>  // For std::string
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <cstring>
+#include <cctype>
 
-//Constructor for BigInt with no parameters. Makes an empty uint_64 vector to symbolize 0 and sets the negativity to false.
+//Constructor for BigInt with no parameters. Leaves the uint_64 vector empty to symbolize 0 and sets the negativity to false.
 BigInt::BigInt() {
-  this->magnitude = std::vector<u_int64_t>{};
   this->negative = false;
 }
 
 //Constructor for BigInt with a uint64_t initializer list and predetermined negativity boolean.
+//Leading zero limbs are dropped so the value starts out in normalized form.
 BigInt::BigInt(std::initializer_list<uint64_t> vals, bool negative) {
   this->magnitude = vals;
   this->negative = negative;
+  trim_leading_zeroes();
 }
 
 //Constructor for BigInt with a single uint64_t value and predetermined negativity boolean.
+//0 is stored as an empty magnitude and is never negative.
 BigInt::BigInt(uint64_t val, bool negative) {
-  this->magnitude.push_back(val);
-  this->negative = negative;
+  if(val != 0) {
+    this->magnitude.push_back(val);
+  }
+  this->negative = negative && val != 0;
+}
+
+//Constructor for BigInt from a view. Copies the viewed limbs, which the view has already trimmed.
+BigInt::BigInt(const BigIntView &view) {
+  LimbView limbs = view.get_bit_vector();
+  this->magnitude.assign(limbs.begin(), limbs.end());
+  this->negative = view.is_negative() && !this->magnitude.empty();
 }
 
 //Constructor for BigInt object with another BigInt object passed in as a parameter. It copies the negativity boolean and magnitude vector.
@@ -30,6 +47,13 @@ BigInt::BigInt(const BigInt &other) {
   this->negative = other.negative;
 }
 
+//Move constructor for BigInt. Takes over the other object's magnitude vector without copying it.
+BigInt::BigInt(BigInt &&other) noexcept
+  : magnitude(std::move(other.magnitude))
+  , negative(other.negative) {
+  other.negative = false;
+}
+
 //Destructor for BigInt. Destruction of vector is already handled.
 BigInt::~BigInt() {
 }
@@ -45,13 +69,25 @@ BigInt &BigInt::operator=(const BigInt &rhs) {
   return *this;
 }
 
+//Definition of the move = operator. Takes over the rhs magnitude vector, leaving rhs empty (0).
+BigInt &BigInt::operator=(BigInt &&rhs) noexcept {
+  if (this != &rhs) {
+    this->magnitude = std::move(rhs.magnitude);
+    this->negative = rhs.negative;
+    rhs.magnitude.clear();
+    rhs.negative = false;
+  }
+
+  return *this;
+}
+
 //Returns whether or not the BigInt value is negative.
 bool BigInt::is_negative() const {
   return this->negative;
 }
 
 void BigInt::setNegative(bool is_negative) {
-  this->negative = is_negative;
+  this->negative = is_negative && !this->magnitude.empty();
 }
 
 //Returns the uint64_t value of a certain number at the given index of the magnitude vector. Returns 0 if it is out of the index.
@@ -64,185 +100,402 @@ uint64_t BigInt::get_bits(unsigned index) const {
   }
 }
 
-//Returns the magnitude vector of the BigInt.
-const std::vector<uint64_t> &BigInt::get_bit_vector() const {
-  return this->magnitude;
+//Returns a view of the magnitude vector of the BigInt.
+LimbView BigInt::get_bit_vector() const {
+  return this->magnitude.view();
 }
 
 
-//Converts the BigInt into a hexadecimal number by incorporating a negative sign and the hexadecimal representation of the magnitude vector
+//Converts the BigInt into a hexadecimal string, sized up front so the digits are written in place
 std::string BigInt::to_hex() const {
-  
-  std::stringstream ss;
-  if(negative) { //add negative sign for negative values
-    ss << "-";
+  std::string hex(hex_length(), '\0');
+  to_hex(&hex[0], hex.size());
+  return hex;
+}
+
+//One digit per started group of 4 bits, at least one digit, plus the sign
+size_t BigInt::hex_length() const {
+  size_t bits = limb_bit_length(this->magnitude.data(), this->magnitude.size());
+  if(bits == 0) {
+    return 1;
+  }
+  return (bits + 3) / 4 + (this->negative ? 1 : 0);
+}
+
+//Formats the top limb into a small buffer to drop its leading zeroes,
+//then lets the hex kernel write the remaining limbs straight into out
+size_t BigInt::to_hex(char *out, size_t capacity) const {
+  size_t length = hex_length();
+  if(capacity < length) {
+    throw std::invalid_argument("Buffer too small for hex string");
   }
 
-  bool leading_zero = true;
+  size_t size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  if(size == 0) {
+    out[0] = '0';
+    return 1;
+  }
 
-  //Start from most significant uint64_t in magnitude
-  for(auto it = magnitude.rbegin(); it != magnitude.rend(); ++it) {
-  
-    if(*it == 0 && leading_zero) { //skip leading zeroes
-      continue;
-    }
+  char *p = out;
+  if(this->negative) {
+    *p++ = '-';
+  }
+  char top[16];
+  limb_to_hex(top, this->magnitude.data() + size - 1, 1);
+  size_t top_digits = length - (p - out) - 16 * (size - 1);
+  std::copy(top + 16 - top_digits, top + 16, p);
+  limb_to_hex(p + top_digits, this->magnitude.data(), size - 1);
+  return length;
+}
 
-    if(leading_zero) { //once non-zero encountered
-      ss << std::hex << *it; 
-      leading_zero = false; //stop skipping zeroes
-    } else { //ensure hex formatting & leading zero padding if necessary
-      ss << std::setfill('0') << std::setw(16) << *it;
+//Digit values for every byte, 0xFF for bytes that are not hex digits
+static const uint8_t *hex_digit_values() {
+  static uint8_t values[256];
+  static const bool filled = [] {
+    std::fill(values, values + 256, 0xFF);
+    for(unsigned d = 0; d < 10; ++d) {
+      values['0' + d] = d;
     }
-  
+    for(unsigned d = 0; d < 6; ++d) {
+      values['a' + d] = values['A' + d] = 10 + d;
+    }
+    return true;
+  }();
+  (void) filled;
+  return values;
+}
+
+//Parses 16 digits at a time into limbs, starting from the least significant end
+BigInt BigInt::from_hex(const char *str, size_t len) {
+  size_t start = (len > 0 && str[0] == '-') ? 1 : 0;
+  if(start == len) {
+    throw std::invalid_argument("Hex string has no digits");
   }
 
-  if(leading_zero) { //If all zeroes or empty magnitude vector
-    return "0";
+  const uint8_t *values = hex_digit_values();
+  const char *digits = str + start;
+  size_t digit_count = len - start;
+
+  BigInt result;
+  result.magnitude.resize((digit_count + 15) / 16);
+  uint8_t invalid = 0;
+  for(size_t i = 0; i < result.magnitude.size(); ++i) {
+    size_t end = digit_count - 16 * i;
+    size_t begin = end > 16 ? end - 16 : 0;
+    uint64_t limb = 0;
+    for(size_t pos = begin; pos < end; ++pos) {
+      uint8_t value = values[(unsigned char) digits[pos]];
+      invalid |= value;
+      limb = (limb << 4) | (value & 0xF);
+    }
+    result.magnitude[i] = limb;
   }
+  //Every digit value fits in 4 bits, so any high bit means an invalid character
+  if(invalid & 0xF0) {
+    throw std::invalid_argument("Invalid character in hex string");
+  }
+
+  result.trim_leading_zeroes();
+  result.negative = (start == 1 && !result.magnitude.empty());
+  return result;
+}
 
-  return ss.str();
+//Parses a whole std::string through the pointer and length overload
+BigInt BigInt::from_hex(const std::string &str) {
+  return from_hex(str.data(), str.size());
 }
 
 //This helper method sets a new magnitude vector for the current BigInt
 void BigInt::setMagnitude(const std::vector<uint64_t>& newMagnitude) {
-  magnitude = newMagnitude;
+  magnitude.assign(newMagnitude.data(), newMagnitude.data() + newMagnitude.size());
+  trim_leading_zeroes();
 }
 
 //Returns 1 if LHS is larger, -1 if RHS is larger, 0 if equal
-int BigInt::compare_magnitudes(const BigInt &lhs, const BigInt &rhs) const {
-  BigInt editable_rhs = BigInt(rhs);
-  BigInt editable_lhs = BigInt(lhs);
-  editable_lhs.trim_leading_zeroes();
-  editable_rhs.trim_leading_zeroes();
-
-  const auto &lhs_magnitude = editable_lhs.get_bit_vector();
-  const auto &rhs_magnitude = editable_rhs.get_bit_vector();
-
-  //Compare based on number of significant digits (size of vector)
-  if (lhs_magnitude.size() != rhs_magnitude.size()) {
-    return lhs_magnitude.size() > rhs_magnitude.size() ? 1 : -1;
+int BigInt::compare_magnitudes(const BigInt &lhs, const BigInt &rhs) {
+  //Magnitudes have no leading zero limbs, so the longer one is larger
+  size_t lhs_size = lhs.magnitude.size();
+  size_t rhs_size = rhs.magnitude.size();
+  if (lhs_size != rhs_size) {
+    return lhs_size > rhs_size ? 1 : -1;
   }
-    
+
   //Compare element by element starting from most significant bit
-  for (int i = lhs_magnitude.size() - 1; i >= 0; --i) { 
-    if (lhs_magnitude[i] != rhs_magnitude[i]) {
-      return lhs_magnitude[i] > rhs_magnitude[i] ? 1 : -1;
-    }
+  return limb_cmp(lhs.magnitude.data(), rhs.magnitude.data(), lhs_size);
+}
+
+//This helper method adds the magnitude vector of rhs into the magnitude vector of *this,
+//reusing the existing vector capacity
+void BigInt::add_magnitudes(const BigInt &rhs) {
+  size_t lhs_size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t rhs_size = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
+
+  //The longer operand decides how many limbs are processed; missing limbs are zeroes
+  size_t max_size = std::max(lhs_size, rhs_size);
+  this->magnitude.resize(max_size, 0);
+
+  //rhs may be *this, so its data pointer is only read after the resize
+  uint64_t carry = limb_add(this->magnitude.data(), this->magnitude.data(), max_size, rhs.magnitude.data(), rhs_size);
+
+  if (carry) { //check for any carry, adds if needed
+    this->magnitude.push_back(carry);
   }
 
-  return 0; //equal magnitude
+  if (this->magnitude.empty()) { //0 + 0 is never negative
+    this->negative = false;
+  }
 }
 
-//This helper method adds the magnitude vectors of the left hand and right hand BigInts
-BigInt BigInt::add_magnitudes(const BigInt &lhs, const BigInt &rhs) const {  
-  BigInt result;
-  const auto& lhs_magnitude = lhs.get_bit_vector();
-  const auto& rhs_magnitude = rhs.get_bit_vector();
+//This helper method replaces the magnitude of *this with the difference between the
+//magnitudes of *this and rhs, flipping the sign if rhs had the larger magnitude
+void BigInt::subtract_magnitudes(const BigInt &rhs) {
+  int cmp = compare_magnitudes(*this, rhs);
+  if (cmp == 0) { //equal magnitudes cancel out to 0
+    this->magnitude.clear();
+    this->negative = false;
+    return;
+  }
 
-  size_t max_size = std::max(lhs_magnitude.size(), rhs_magnitude.size()); //max number of digits to be processed
-  std::vector<uint64_t> res_magnitude;
-  res_magnitude.reserve(max_size);
+  size_t lhs_size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t rhs_size = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
 
-  uint64_t carry = 0; //used for grade school algo
-  for (size_t i = 0; i < max_size; ++i) {
-    //access i^th element, if past the size assume it is a 0
-    uint64_t lhs_val = i < lhs_magnitude.size() ? lhs_magnitude[i] : 0;
-    uint64_t rhs_val = i < rhs_magnitude.size() ? rhs_magnitude[i] : 0;
+  if (cmp > 0) { //|*this| - |rhs|
+    this->magnitude.resize(lhs_size);
+    limb_sub(this->magnitude.data(), this->magnitude.data(), lhs_size, rhs.magnitude.data(), rhs_size);
+  } else { //|rhs| - |*this|, written over *this limb by limb
+    this->magnitude.resize(rhs_size, 0);
+    limb_sub(this->magnitude.data(), rhs.magnitude.data(), rhs_size, this->magnitude.data(), lhs_size);
+    this->negative = !this->negative; // adjust sign since the second operand had larger magnitude
+  }
 
-    uint64_t sum = lhs_val + rhs_val + carry;
-    
-    //check if the addition resulted in an overflow
-    carry = (sum < lhs_val) ? 1 : 0;
+  //Remove zeroes at end of vector
+  trim_leading_zeroes();
+}
 
-    //store result of current digit addition
-    res_magnitude.push_back(sum);
+//This helper method adds rhs to *this in place, treating rhs as negative if rhs_negative is set
+void BigInt::add_signed(const BigInt &rhs, bool rhs_negative) {
+  if (this->negative == rhs_negative) { //Same sign, just add their magnitudes
+    add_magnitudes(rhs);
+  } else { // If they have opposite signs, subtract magnitudes, sign follows the larger magnitude
+    subtract_magnitudes(rhs);
   }
+}
 
-  if (carry) { //check for any carry, adds if needed
-    res_magnitude.push_back(carry);
-  }
+// This method carries out the addition of the current BigInt with the right hand side BigInt to return the sum of the BigInt
+BigInt BigInt::operator+(const BigInt &rhs) const & {
+  BigInt result(*this);
+  result += rhs;
+  return result;
+}
+
+//Addition where *this is a temporary: its buffer becomes the result
+BigInt BigInt::operator+(const BigInt &rhs) && {
+  *this += rhs;
+  return std::move(*this);
+}
+
+//Addition where rhs is a temporary: addition commutes, so add into rhs
+BigInt BigInt::operator+(BigInt &&rhs) const & {
+  rhs += *this;
+  return std::move(rhs);
+}
 
-  result.setMagnitude(res_magnitude); //assign result vector to BigInt
+//Addition where both operands are temporaries
+BigInt BigInt::operator+(BigInt &&rhs) && {
+  *this += rhs;
+  return std::move(*this);
+}
+
+//This method carries out the subtraction of the current BigInt with the right hand side BigInt to return the difference of the two.
+BigInt BigInt::operator-(const BigInt &rhs) const & {
+  BigInt result(*this);
+  result -= rhs;
   return result;
 }
 
-//This helper method carries out the subtraction of magnitudes of two different BigInts
-BigInt BigInt::subtract_magnitudes(const BigInt &lhs, const BigInt &rhs) const {
-  BigInt result;
-  const auto &lhs_magnitude = lhs.get_bit_vector();
-  const auto &rhs_magnitude = rhs.get_bit_vector();
-  
-  bool lhs_greater = compare_magnitudes(lhs, rhs) >= 0; //1 if lhs equal/greater, 0 if rhs greater 
-  const auto &larger_mag =  lhs_greater ? lhs_magnitude : rhs_magnitude;
-  const auto &smaller_mag =  lhs_greater ? rhs_magnitude : lhs_magnitude;
+//Subtraction where *this is a temporary: its buffer becomes the result
+BigInt BigInt::operator-(const BigInt &rhs) && {
+  *this -= rhs;
+  return std::move(*this);
+}
 
-  std::vector<uint64_t> res_magnitude;
+//Subtraction where rhs is a temporary: computes -(rhs - *this) in rhs's buffer
+BigInt BigInt::operator-(BigInt &&rhs) const & {
+  rhs -= *this;
+  if(!rhs.is_zero()) {
+    rhs.negative = !rhs.negative;
+  }
+  return std::move(rhs);
+}
+
+//Subtraction where both operands are temporaries
+BigInt BigInt::operator-(BigInt &&rhs) && {
+  *this -= rhs;
+  return std::move(*this);
+}
 
-  uint64_t carry = 0;
-  for (size_t i = 0; i < larger_mag.size(); ++i) {
-    //access i^th element, if past the size assume it is a 0
-    uint64_t first_digit = larger_mag[i];
-    uint64_t second_digit = i < rhs_magnitude.size() ? smaller_mag[i] : 0;
+//Adds rhs to *this in place
+BigInt &BigInt::operator+=(const BigInt &rhs) {
+  add_signed(rhs, rhs.negative);
+  return *this;
+}
 
-    uint64_t diff = first_digit - second_digit - carry; //do subtraction
-    carry = (first_digit < (second_digit + carry)) ? 1 : 0; //determine if carry needed
+//Subtracts rhs from *this in place. To perform a - b, do a + -b without copying b.
+BigInt &BigInt::operator-=(const BigInt &rhs) {
+  add_signed(rhs, !rhs.negative);
+  return *this;
+}
 
-    res_magnitude.push_back(diff); //store difference of operands
+//Multiplies all the values with a product tree
+BigInt BigInt::product(const std::vector<BigInt> &values) {
+  if(values.empty()) {
+    return BigInt(1);
   }
+  return product_range(values.data(), values.size());
+}
 
-  result.setMagnitude(res_magnitude);
+//Multiplies the two halves recursively, on separate threads when the
+//halves are large enough to be worth a thread each
+BigInt BigInt::product_range(const BigInt *values, size_t count) {
+  if(count == 1) {
+    return values[0];
+  }
+  if(count == 2) {
+    return values[0] * values[1];
+  }
 
-  //Remove zeroes at end of vector
-  result.trim_leading_zeroes();
+  size_t total_limbs = 0;
+  for(size_t i = 0; i < count; ++i) {
+    total_limbs += values[i].magnitude.size();
+  }
 
-  if (!lhs_greater) {
-    result = -result; // adjust sign if first operand had smaller magnitude
+  size_t half = count / 2;
+  BigInt halves[2];
+  auto multiply_half = [&](size_t i) {
+    halves[i] = i == 0 ? product_range(values, half) : product_range(values + half, count - half);
+  };
+  if(total_limbs >= limb_parallel_threshold) {
+    limb_parallel_for(2, multiply_half);
+  } else {
+    multiply_half(0);
+    multiply_half(1);
   }
+  return halves[0] * halves[1];
+}
 
-  return result;
+//Multiplies *this by rhs. The product needs its own buffer, which is moved into *this.
+BigInt &BigInt::operator*=(const BigInt &rhs) {
+  *this = *this * rhs;
+  return *this;
 }
 
-// This method carries out the addition of the current BigInt with the right hand side BigInt to return the sum of the BigInt
-BigInt BigInt::operator+(const BigInt &rhs) const {
-  BigInt result;
-  if (this->negative == rhs.negative) { //Same sign, just add their magnitudes
-    result = add_magnitudes(*this, rhs);
-    result.negative = this->negative;
-  } else { // If they have opposite signs, subtract magnitudes, make sure larger - smaller
-    if (compare_magnitudes(*this, rhs) > 0) { // *this has larger magnitude
-      result = subtract_magnitudes(*this, rhs);
-      result.negative = this->negative; // result takes the sign of the larger magnitude
-    } else if(compare_magnitudes(*this, rhs) < 0) { //rhs has larger magnitude
-      result = subtract_magnitudes(rhs, *this);
-      result.negative = rhs.negative;
-    } else { //equal magnitudes
-      return BigInt(); //the sum is the BigInt 0
+//Below the Karatsuba threshold the product rows go straight into the
+//accumulator's limbs; larger or opposite-sign products take a detour
+//through scratch space
+BigInt &BigInt::addmul(const BigInt &a, const BigInt &b) {
+  if(a.is_zero() || b.is_zero()) {
+    return *this;
+  }
+  const BigInt &x = a.magnitude.size() >= b.magnitude.size() ? a : b;
+  const BigInt &y = a.magnitude.size() >= b.magnitude.size() ? b : a;
+  size_t xn = x.magnitude.size();
+  size_t yn = y.magnitude.size();
+  bool product_negative = a.negative != b.negative;
+  bool aliased = &a == this || &b == this;
+
+  if(!aliased && (is_zero() || this->negative == product_negative) && yn < limb_karatsuba_threshold) {
+    //The sum is below B^(max(size, xn + yn) + 1), so no carry leaves the buffer
+    size_t size = std::max(this->magnitude.size(), xn + yn) + 1;
+    this->magnitude.resize(size, 0);
+    uint64_t *r = this->magnitude.data();
+    for(size_t j = 0; j < yn; ++j) {
+      uint64_t carry = limb_addmul_1(r + j, x.magnitude.data(), xn, y.magnitude[j]);
+      for(size_t k = j + xn; carry != 0; ++k) {
+        r[k] += carry;
+        carry = (r[k] < carry) ? 1 : 0;
+      }
     }
+    this->negative = product_negative;
+    trim_leading_zeroes();
+    return *this;
   }
-  return result;
-}
 
-//This method carries out the subtraction of the current BigInt with the right hand side BigInt to return the difference of the two.
-BigInt BigInt::operator-(const BigInt &rhs) const {
+  LimbScratchScope scratch;
+  uint64_t *p = scratch.allocate(xn + yn);
+  limb_mul(p, x.magnitude.data(), xn, y.magnitude.data(), yn);
+  add_signed_limbs(p, limb_normalized_size(p, xn + yn), product_negative);
+  return *this;
+}
 
-  //To perform a - b, do a + -b
-  return *this + -rhs;
+//Same cases as add_signed, for a magnitude given as raw limbs
+void BigInt::add_signed_limbs(const uint64_t *p, size_t pn, bool p_negative) {
+  size_t size = this->magnitude.size();
+  if(is_zero() || this->negative == p_negative) {
+    this->magnitude.resize(std::max(size, pn), 0);
+    uint64_t *r = this->magnitude.data();
+    uint64_t carry = size >= pn ? limb_add(r, r, size, p, pn) : limb_add(r, p, pn, r, size);
+    if(carry) {
+      this->magnitude.push_back(carry);
+    }
+    this->negative = p_negative;
+    return;
+  }
 
+  int cmp = size != pn ? (size > pn ? 1 : -1) : limb_cmp(this->magnitude.data(), p, pn);
+  if(cmp >= 0) { //|*this| - |p|, keeping the sign of *this
+    limb_sub(this->magnitude.data(), this->magnitude.data(), size, p, pn);
+  } else { //|p| - |*this|, written over *this limb by limb
+    this->magnitude.resize(pn, 0);
+    limb_sub(this->magnitude.data(), p, pn, this->magnitude.data(), size);
+    this->negative = p_negative;
+  }
+  trim_leading_zeroes();
 }
 
-//Returns true if the BigInt corresponds to value 0, false otherwise
-bool BigInt::is_zero() const {
-  bool zeroes_only = true;
+//Below this many limb products a dot product stays on one thread,
+//because starting threads would cost more than the work
+static const size_t DOT_PARALLEL_MIN_WORK = 1 << 16;
 
-  if(this->magnitude.size() == 0) { //no magnitude means 0
-    return true;
+//Splits the pairs into one contiguous range per thread when the total
+//work (in limb products) is large enough to pay for the threads
+BigInt BigInt::dot(const std::vector<BigInt> &a, const std::vector<BigInt> &b) {
+  if(a.size() != b.size()) {
+    throw std::invalid_argument("Dot product needs vectors of the same length");
   }
-  for(size_t i = 0; i < this->magnitude.size(); ++i) {
-    if(this->magnitude[i] != 0) {
-      zeroes_only = false; //if we find a nonzero element, cannot be 0
-    }
+  size_t count = a.size();
+  size_t work = 0;
+  for(size_t i = 0; i < count && work < DOT_PARALLEL_MIN_WORK; ++i) {
+    work += a[i].magnitude.size() * b[i].magnitude.size();
+  }
+  size_t ranges = std::min<size_t>(std::max(limb_mul_threads, 1u), count);
+  if(work < DOT_PARALLEL_MIN_WORK || ranges <= 1) {
+    return dot_range(a.data(), b.data(), 0, count);
+  }
+
+  std::vector<BigInt> partials(ranges);
+  limb_parallel_for(ranges, [&](size_t i) {
+    partials[i] = dot_range(a.data(), b.data(), count * i / ranges, count * (i + 1) / ranges);
+  });
+  BigInt result;
+  for(const BigInt &partial : partials) {
+    result += partial;
   }
-  return zeroes_only;
+  return result;
+}
+
+//Positive and negative products go to separate accumulators, so a mix of
+//signs never makes addmul leave its in-place path
+BigInt BigInt::dot_range(const BigInt *a, const BigInt *b, size_t begin, size_t end) {
+  BigInt sums[2];
+  for(size_t i = begin; i < end; ++i) {
+    sums[a[i].negative != b[i].negative].addmul(a[i], b[i]);
+  }
+  return std::move(sums[0]) + sums[1];
+}
+
+//Returns true if the BigInt corresponds to value 0, false otherwise
+bool BigInt::is_zero() const {
+  return this->magnitude.empty(); //0 is the only value with no limbs
 }
 
 //This method returns the negative version of the BigInt by flipping the negative value.
@@ -275,130 +528,248 @@ bool BigInt::is_bit_set(unsigned n) const {
 
 //This function left shifts the magnitude vector by the specified number of iterations
 BigInt BigInt::operator<<(unsigned n) const {
+  BigInt result(*this);
+  result <<= n;
+  return result;
+}
+
+//This function left shifts the magnitude vector in place, growing the vector at most once
+BigInt &BigInt::operator<<=(unsigned n) {
   if(this->negative) {
     throw std::invalid_argument("Left shift not allowed for negative values");
   }
 
-  if(n == 0) { //no shift performed
+  size_t size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  if(n == 0 || size == 0) { //no shift performed, or shifting 0
     return *this;
   }
 
-  BigInt result;
-
   //How many uint64_t's to shift left
-  int shift_index = n / 64;
+  size_t shift_index = n / 64;
 
   //How many bits to shift within a uint64_t 
-  int shift_bits = n % 64; 
+  unsigned shift_bits = n % 64; 
 
-  //Add uint64 0's as a result of left shift
-  result.magnitude.resize(this->magnitude.size() + shift_index, 0);
+  //Room for the new low zero blocks and the bits that spill out of the top block
+  this->magnitude.resize(size + shift_index + 1, 0);
+  uint64_t *limbs = this->magnitude.data();
 
-  // Shift the magnitude blocks
-  uint64_t carry = 0; // Store bits that spill over from lower part
-  for (size_t i = 0; i < this->magnitude.size(); ++i) {
-    uint64_t current = this->magnitude[i];
+  // Shift the bits within the blocks first, then move the blocks up
+  if (shift_bits > 0) {
+    limbs[size] = limb_lshift(limbs, limbs, size, shift_bits);
+  } else {
+    limbs[size] = 0;
+  }
+  if (shift_index > 0) {
+    std::copy_backward(limbs, limbs + size + 1, limbs + size + 1 + shift_index);
+    std::fill(limbs, limbs + shift_index, 0);
+  }
 
-    // Shift the current block left and add carry from the previous block
-    result.magnitude[i + shift_index] = (current << shift_bits) | carry;
+  trim_leading_zeroes();
+  return *this;
+}
 
-    // Calculate new carry (spillover bits that shift out of the current block)
-    carry = (shift_bits > 0) ? (current >> (64 - shift_bits)) : 0;
+//Arithmetic right shift of a copy, rounding toward negative infinity like >>=
+BigInt BigInt::operator>>(unsigned n) const {
+  BigInt result(*this);
+  result >>= n;
+  return result;
+}
+
+//Shifts the magnitude down; a negative value that loses 1 bits moves one further
+//from zero, which is where the two's complement shift rounds it
+BigInt &BigInt::operator>>=(unsigned n) {
+  size_t size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  if(n == 0 || size == 0) {
+    return *this;
   }
 
-  // If there is still a carry left, append it as a new block
-  if (carry > 0) {
-    result.magnitude.push_back(carry);
+  size_t shift_index = n / 64;
+  unsigned shift_bits = n % 64;
+  uint64_t *limbs = this->magnitude.data();
+
+  bool lost_bits = false;
+  if(this->negative) {
+    for(size_t i = 0; i < shift_index && i < size && !lost_bits; ++i) {
+      lost_bits = (limbs[i] != 0);
+    }
+    if(shift_index < size && shift_bits > 0) {
+      lost_bits = lost_bits || (limbs[shift_index] & ((uint64_t(1) << shift_bits) - 1)) != 0;
+    }
   }
 
-  return result;
-}
+  if(shift_index >= size) {
+    this->magnitude.resize(0);
+  } else {
+    std::copy(limbs + shift_index, limbs + size, limbs);
+    this->magnitude.resize(size - shift_index);
+    if(shift_bits > 0) {
+      limb_rshift(limbs, limbs, size - shift_index, shift_bits);
+    }
+  }
 
-//This function carries out the multiplication between the left hand side and the right hand side and returns their product as a BigInt
-BigInt BigInt::operator*(const BigInt &rhs) const {
-  
-  BigInt result;
-  if(this->is_zero() || rhs.is_zero()) { //multiplying 0 yields 0
-    return BigInt();
+  bool was_negative = this->negative;
+  trim_leading_zeroes();
+  if(was_negative && lost_bits) {
+    this->negative = true;
+    *this -= BigInt(1); //-(m + 1)
   }
-  
-  //Use absolute values of operands to be able to left shift
-  BigInt lhs_abs = *this; 
-  BigInt rhs_abs = rhs;
-  if (lhs_abs.negative) lhs_abs.negative = false;
-  if (rhs_abs.negative) rhs_abs.negative = false;
+  return *this;
+}
 
-  BigInt temp = lhs_abs;
-  for (unsigned i = 0; i < rhs_abs.magnitude.size() * 64; ++i) {
-    if (rhs_abs.is_bit_set(i)) {
-      // If the i^th bit is 1, add *this shifted left by i bits to multiply
-      result = result + (temp << i);
+//Applies op to limbs of two's complement operands. A negative value's limbs are
+//~(m - 1), with the borrow of m - 1 carried along; a negative result is turned
+//back into its magnitude ~r + 1 the same way. n covers every limb of both
+//operands plus one limb of sign bits, which is enough for the result.
+template<typename Op>
+static void bitwise_limbs(uint64_t *r, size_t n,
+                          const uint64_t *a, size_t an, bool a_negative,
+                          const uint64_t *b, size_t bn, bool b_negative,
+                          bool r_negative, Op op) {
+  uint64_t a_borrow = a_negative, b_borrow = b_negative, r_carry = r_negative;
+  for(size_t i = 0; i < n; ++i) {
+    uint64_t x = i < an ? a[i] : 0;
+    uint64_t y = i < bn ? b[i] : 0;
+    if(a_negative) {
+      uint64_t next_borrow = (x < a_borrow);
+      x = ~(x - a_borrow);
+      a_borrow = next_borrow;
+    }
+    if(b_negative) {
+      uint64_t next_borrow = (y < b_borrow);
+      y = ~(y - b_borrow);
+      b_borrow = next_borrow;
     }
+    uint64_t z = op(x, y);
+    if(r_negative) {
+      z = ~z + r_carry;
+      r_carry = (z < r_carry);
+    }
+    r[i] = z;
   }
+}
 
-  //if both operands have same sign, result is positive
-  //if mixed signs will be negative
-  result.negative = (this->negative != rhs.negative); 
+//Sizes the result one limb past the longer operand for the sign extension, then runs the op over the limbs
+BigInt BigInt::bitwise(const BigInt &lhs, const BigInt &rhs, BitwiseOp op) {
+  size_t lhs_size = limb_normalized_size(lhs.magnitude.data(), lhs.magnitude.size());
+  size_t rhs_size = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
+  bool lhs_negative = lhs.negative && lhs_size > 0;
+  bool rhs_negative = rhs.negative && rhs_size > 0;
+
+  bool result_negative;
+  switch(op) {
+  case BitwiseOp::AND: result_negative = lhs_negative && rhs_negative; break;
+  case BitwiseOp::OR:  result_negative = lhs_negative || rhs_negative; break;
+  default:             result_negative = lhs_negative != rhs_negative; break;
+  }
+
+  BigInt result;
+  size_t n = std::max(lhs_size, rhs_size) + 1;
+  result.magnitude.resize(n);
+  const uint64_t *a = lhs.magnitude.data(), *b = rhs.magnitude.data();
+  uint64_t *r = result.magnitude.data();
+  switch(op) {
+  case BitwiseOp::AND:
+    bitwise_limbs(r, n, a, lhs_size, lhs_negative, b, rhs_size, rhs_negative, result_negative,
+                  [](uint64_t x, uint64_t y) { return x & y; });
+    break;
+  case BitwiseOp::OR:
+    bitwise_limbs(r, n, a, lhs_size, lhs_negative, b, rhs_size, rhs_negative, result_negative,
+                  [](uint64_t x, uint64_t y) { return x | y; });
+    break;
+  default:
+    bitwise_limbs(r, n, a, lhs_size, lhs_negative, b, rhs_size, rhs_negative, result_negative,
+                  [](uint64_t x, uint64_t y) { return x ^ y; });
+    break;
+  }
+
+  result.trim_leading_zeroes();
+  result.negative = result_negative && !result.magnitude.empty();
   return result;
+}
 
+//Bitwise AND with both operands taken in two's complement
+BigInt BigInt::operator&(const BigInt &rhs) const {
+  return bitwise(*this, rhs, BitwiseOp::AND);
 }
 
-//This function carries out a binary search to divide the lhs by the rhs
-BigInt BigInt::binary_search(const BigInt &lhs, const BigInt &rhs) const {
+//Bitwise OR, negative if either operand is
+BigInt BigInt::operator|(const BigInt &rhs) const {
+  return bitwise(*this, rhs, BitwiseOp::OR);
+}
 
-  BigInt dividend = lhs;
-  dividend.setNegative(false);
+//Bitwise XOR, negative if exactly one operand is
+BigInt BigInt::operator^(const BigInt &rhs) const {
+  return bitwise(*this, rhs, BitwiseOp::XOR);
+}
 
-  BigInt divisor = rhs;
-  divisor.setNegative(false);
+//In-place AND; bitwise() builds the result in a new magnitude, so this assigns it
+BigInt &BigInt::operator&=(const BigInt &rhs) {
+  *this = bitwise(*this, rhs, BitwiseOp::AND);
+  return *this;
+}
 
-  // Binary search for the quotient
-  BigInt lower_bound(0);
-  BigInt upper_bound = dividend + BigInt(1);
+//In-place OR, assigned from bitwise() like &=
+BigInt &BigInt::operator|=(const BigInt &rhs) {
+  *this = bitwise(*this, rhs, BitwiseOp::OR);
+  return *this;
+}
 
-  BigInt quotient;
+//In-place XOR, assigned from bitwise() like &=
+BigInt &BigInt::operator^=(const BigInt &rhs) {
+  *this = bitwise(*this, rhs, BitwiseOp::XOR);
+  return *this;
+}
+
+//~x == -x - 1 == -(x + 1)
+BigInt BigInt::operator~() const {
+  BigInt result = -*this;
+  result -= BigInt(1);
+  return result;
+}
 
-  while (lower_bound + BigInt(1) < upper_bound) {
-    BigInt mid = (lower_bound + upper_bound).div_by_2();  // divide by 2
-    BigInt product = mid * divisor; //see how close to dividend
+//Counts the 1 bits of the magnitude with the limb_popcount kernel
+size_t BigInt::popcount() const {
+  return limb_popcount(this->magnitude.data(), this->magnitude.size());
+}
 
-    if (product == dividend) {
-      return mid;
-    } else if (product < dividend) { //increase lower bound
-      lower_bound = mid;
-    } else { //decrease upper bound
-      upper_bound = mid;
+//Skips zero limbs, then counts the trailing zeroes of the first nonzero one
+size_t BigInt::lowest_set_bit() const {
+  for(size_t i = 0; i < this->magnitude.size(); ++i) {
+    if(this->magnitude[i] != 0) {
+      return 64 * i + __builtin_ctzll(this->magnitude[i]);
     }
   }
-
-  return lower_bound;
-
+  throw std::invalid_argument("0 has no set bits");
 }
 
-//This function divides the Implicit BigInt (this*) by 2
-BigInt BigInt::div_by_2() const {
-  BigInt result;
-  uint64_t carry = 0;
+//This function carries out the multiplication between the left hand side and the right hand side and returns their product as a BigInt
+BigInt BigInt::operator*(const BigInt &rhs) const {
+  //Leading zero limbs do not contribute to the product
+  size_t lhs_size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t rhs_size = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
 
-  // Iterate over the magnitude from the most significant to least significant block
-  for (size_t i = this->magnitude.size(); i > 0; --i) {
-    // Get current block
-    uint64_t current = this->magnitude[i - 1];
+  if(lhs_size == 0 || rhs_size == 0) { //multiplying 0 yields 0
+    return BigInt();
+  }
 
-    // Shift right and incorporate any carry from the previous block
-    result.magnitude.insert(result.magnitude.begin(), (current >> 1) | carry);
+  BigInt result;
+  result.magnitude.resize(lhs_size + rhs_size);
 
-    // Prepare carry for the next iteration, which is the least significant bit
-    carry = (current & 1) ? (1ULL << 63) : 0;  // If LSB is 1, it carries over as MSB
+  //limb_mul picks schoolbook, Karatsuba or Toom-3 based on operand size,
+  //and expects the longer operand first
+  if (lhs_size >= rhs_size) {
+    limb_mul(result.magnitude.data(), this->magnitude.data(), lhs_size, rhs.magnitude.data(), rhs_size);
+  } else {
+    limb_mul(result.magnitude.data(), rhs.magnitude.data(), rhs_size, this->magnitude.data(), lhs_size);
   }
-
-  // Keep same sign as *this
-  result.negative = this->negative;
-  
-  // Trim leading zeroes if necessary
   result.trim_leading_zeroes();
 
+  //if both operands have same sign, result is positive
+  //if mixed signs will be negative
+  result.negative = (this->negative != rhs.negative); 
   return result;
+
 }
 
 //This method removes the leading zeros for an array that do not influence the magnitude
@@ -416,23 +787,854 @@ void BigInt::trim_leading_zeroes() {
 
 //This method divides the BigInt (*this) by the rhs
 BigInt BigInt::operator/(const BigInt &rhs) const {
-  if(rhs.is_zero()) {
+  return divmod(rhs).first;
+}
+
+//This method divides the BigInt (*this) by the rhs, returning the quotient and remainder together
+std::pair<BigInt, BigInt> BigInt::divmod(const BigInt &rhs) const {
+  size_t dividend_size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t divisor_size = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
+
+  if(divisor_size == 0) {
     throw std::invalid_argument("Cannot divide by zero");
   }
 
-  //dividend 0 leads to quotient 0
-  if(this->is_zero()) { 
+  BigInt quotient;
+  BigInt remainder;
+
+  if(dividend_size < divisor_size) { //|dividend| < |divisor|, quotient is 0
+    remainder.magnitude.assign(this->magnitude.begin(), this->magnitude.begin() + dividend_size);
+  } else if(divisor_size >= limb_newton_threshold && dividend_size - divisor_size >= limb_newton_threshold) {
+    //large quotient and divisor: subquadratic Newton division on the magnitudes,
+    //copying an operand only when it is negative
+    BigInt dividend_copy, divisor_copy;
+    const BigInt &abs_dividend = this->negative ? (dividend_copy = -*this) : *this;
+    const BigInt &abs_divisor = rhs.negative ? (divisor_copy = -rhs) : rhs;
+    std::pair<BigInt, BigInt> qr = divmod_newton(abs_dividend, abs_divisor);
+    quotient = std::move(qr.first);
+    remainder = std::move(qr.second);
+  } else if(divisor_size == 1) { //fast path: single limb divisor
+    quotient.magnitude.resize(dividend_size);
+    uint64_t rem = limb_divrem_1(quotient.magnitude.data(), this->magnitude.data(), dividend_size, rhs.magnitude[0]);
+    remainder.magnitude.push_back(rem);
+  } else { //long division
+    quotient.magnitude.resize(dividend_size - divisor_size + 1);
+    remainder.magnitude.resize(divisor_size);
+    limb_divrem(quotient.magnitude.data(), remainder.magnitude.data(),
+                this->magnitude.data(), dividend_size, rhs.magnitude.data(), divisor_size);
+  }
+
+  quotient.trim_leading_zeroes();
+  remainder.trim_leading_zeroes();
+
+  //Truncated division: quotient sign from both operands, remainder sign from the dividend
+  if(!quotient.magnitude.empty()) {
+    quotient.negative = (this->negative != rhs.negative);
+  }
+  if(!remainder.magnitude.empty()) {
+    remainder.negative = this->negative;
+  }
+
+  return { std::move(quotient), std::move(remainder) };
+}
+
+//Counts the bits in the magnitude up to and including the highest set bit
+size_t BigInt::bit_length() const {
+  return limb_bit_length(this->magnitude.data(), this->magnitude.size());
+}
+
+//Drops the low n bits of the magnitude
+BigInt BigInt::magnitude_shr(size_t n) const {
+  size_t size = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t shift_index = n / 64;
+  unsigned shift_bits = n % 64;
+
+  BigInt result;
+  if(shift_index >= size) { //every bit is shifted out
+    return result;
+  }
+  result.magnitude.assign(this->magnitude.data() + shift_index, this->magnitude.data() + size);
+  if(shift_bits > 0) {
+    limb_rshift(result.magnitude.data(), result.magnitude.data(), result.magnitude.size(), shift_bits);
+  }
+  result.trim_leading_zeroes();
+  return result;
+}
+
+//Approximates 2^k / d by computing a reciprocal of half the precision from
+//the top bits of d, then doubling its precision with one Newton step
+//y' = y + y * (2^k - d * y) / 2^k
+BigInt BigInt::newton_reciprocal(const BigInt &d, size_t k) {
+  size_t b = d.bit_length();
+  size_t p = k - b; //the result has about p + 1 bits
+
+  //Short results are cheap to get exactly by long division
+  if(p <= 256 || p < 64 * limb_newton_threshold) {
+    size_t d_size = limb_normalized_size(d.magnitude.data(), d.magnitude.size());
+    size_t n_size = k / 64 + 1;
+    LimbScratchScope scratch;
+    uint64_t *numerator = scratch.allocate_zeroed(n_size);
+    uint64_t *rem = scratch.allocate(d_size);
+    numerator[k / 64] = uint64_t(1) << (k % 64);
+
+    BigInt result;
+    result.magnitude.resize(n_size - d_size + 1);
+    if(d_size == 1) {
+      limb_divrem_1(result.magnitude.data(), numerator, n_size, d.magnitude[0]);
+    } else {
+      limb_divrem(result.magnitude.data(), rem, numerator, n_size, d.magnitude.data(), d_size);
+    }
+    result.trim_leading_zeroes();
+    return result;
+  }
+
+  //Half precision (plus guard bits) from the top bits of d
+  const size_t GUARD_BITS = 64;
+  size_t h = p / 2 + GUARD_BITS;
+  size_t s = b > h + GUARD_BITS ? b - (h + GUARD_BITS) : 0;
+  BigInt y = newton_reciprocal(d.magnitude_shr(s), b - s + h) << unsigned(p - h);
+
+  BigInt error = (BigInt(1) << unsigned(k)) - d * y;
+  BigInt correction = (y * error).magnitude_shr(k);
+  if(error.negative) {
+    y -= correction;
+  } else {
+    y += correction;
+  }
+  return y;
+}
+
+//q = a * (2^A / d) / 2^A with A the bit length of a, off by a few units at most
+std::pair<BigInt, BigInt> BigInt::divmod_newton(const BigInt &a, const BigInt &d) {
+  size_t a_bits = a.bit_length();
+  BigInt quotient = (a * newton_reciprocal(d, a_bits)).magnitude_shr(a_bits);
+  BigInt remainder = a - quotient * d;
+
+  BigInt one(1);
+  while(remainder.negative) {
+    quotient -= one;
+    remainder += d;
+  }
+  while(remainder >= d) {
+    quotient += one;
+    remainder -= d;
+  }
+  return { std::move(quotient), std::move(remainder) };
+}
+
+//Starts from (root of the top half of the bits + 1) * 2^s, which is above the
+//root and close enough that Newton's iteration needs only a couple of steps.
+//From above, x' = ((k - 1) * x + n / x^(k-1)) / k decreases until it reaches the root.
+BigInt BigInt::root_newton(const BigInt &n, unsigned k) {
+  size_t bits = n.bit_length();
+  if(bits == 0) {
+    return BigInt();
+  }
+
+  BigInt x;
+  size_t root_bits = (bits + k - 1) / k;
+  if(root_bits <= 64) {
+    x = BigInt(1) << unsigned(root_bits); //2^ceil(bits/k) is above the root
+  } else {
+    size_t s = root_bits / 2;
+    x = (root_newton(n.magnitude_shr(s * k), k) + BigInt(1)) << unsigned(s);
+  }
+
+  BigInt k_big(k), k_minus_1(k - 1);
+  while(true) {
+    BigInt next = (k_minus_1 * x + n / x.pow(k - 1)) / k_big;
+    if(next >= x) {
+      return x;
+    }
+    x = std::move(next);
+  }
+}
+
+//Integer square root, rounded down
+BigInt BigInt::isqrt() const {
+  if(this->negative) {
+    throw std::invalid_argument("Square root of a negative value");
+  }
+  return root_newton(*this, 2);
+}
+
+//Roots the magnitude and puts the sign back (only odd roots of negative values get here)
+BigInt BigInt::nth_root(unsigned k) const {
+  if(k == 0) {
+    throw std::invalid_argument("Zeroth root is undefined");
+  }
+  if(this->negative && k % 2 == 0) {
+    throw std::invalid_argument("Even root of a negative value");
+  }
+  if(k == 1 || this->is_zero()) {
+    return *this;
+  }
+  //0 < |value| < 2^k, so the root is 1; Newton's steps would compute huge powers
+  if(k >= bit_length()) {
+    return BigInt(1, this->negative);
+  }
+  BigInt magnitude_only(*this);
+  magnitude_only.negative = false;
+  BigInt root = root_newton(magnitude_only, k);
+  return this->negative ? -root : root;
+}
+
+//Returns the remainder of truncated division, which has the sign of the dividend
+BigInt BigInt::operator%(const BigInt &rhs) const {
+  return divmod(rhs).second;
+}
+
+//Returns the remainder shifted into [0, modulus)
+BigInt BigInt::mod(const BigInt &modulus) const {
+  if(modulus.negative || modulus.is_zero()) {
+    throw std::invalid_argument("Modulus must be positive");
+  }
+  BigInt remainder = divmod(modulus).second;
+  if(remainder.negative) {
+    remainder += modulus;
+  }
+  return remainder;
+}
+
+//Squares the magnitude through limb_sqr; the result is never negative
+BigInt BigInt::square() const {
+  if(is_zero()) {
+    return BigInt();
+  }
+  BigInt result;
+  size_t size = this->magnitude.size();
+  result.magnitude.resize(2 * size);
+  limb_sqr(result.magnitude.data(), this->magnitude.data(), size);
+  result.trim_leading_zeroes();
+  return result;
+}
+
+//Raises the value to a power left to right: square for every bit of the
+//exponent below the top one, and multiply in the base for every set bit
+BigInt BigInt::pow(unsigned exponent) const {
+  if(exponent == 0) {
+    return BigInt(1);
+  }
+  BigInt result(*this);
+  for(int bit = 30 - __builtin_clz(exponent); bit >= 0; --bit) {
+    result = result.square();
+    if((exponent >> bit) & 1) {
+      result *= *this;
+    }
+  }
+  return result;
+}
+
+//Modular exponentiation, through a cached Montgomery context when the modulus is odd
+BigInt BigInt::modpow(const BigInt &exponent, const BigInt &modulus) const {
+  if(modulus.negative || modulus.is_zero()) {
+    throw std::invalid_argument("Modulus must be positive");
+  }
+  if(exponent.negative) {
+    throw std::invalid_argument("Exponent must not be negative");
+  }
+
+  if(modulus.magnitude[0] & 1) {
+    thread_local std::unique_ptr<MontgomeryContext> cached;
+    if(!cached || cached->get_modulus() != modulus) {
+      cached.reset(new MontgomeryContext(modulus));
+    }
+    return cached->modpow(*this, exponent);
+  }
+
+  //Even modulus: left-to-right square and multiply, reducing after every step
+  BigInt base = mod(modulus);
+  BigInt result = BigInt(1).mod(modulus);
+  size_t bits = limb_bit_length(exponent.magnitude.data(), exponent.magnitude.size());
+  for(size_t i = bits; i > 0; --i) {
+    result = (result * result).mod(modulus);
+    if(exponent.is_bit_set(unsigned(i - 1))) {
+      result = (result * base).mod(modulus);
+    }
+  }
+  return result;
+}
+
+//Greatest common divisor of the magnitudes, computed by limb_gcd
+BigInt BigInt::gcd(const BigInt &rhs) const {
+  size_t an = limb_normalized_size(this->magnitude.data(), this->magnitude.size());
+  size_t bn = limb_normalized_size(rhs.magnitude.data(), rhs.magnitude.size());
+  if(an == 0 || bn == 0) { //gcd(x, 0) = |x|
+    BigInt result(an == 0 ? rhs : *this);
+    result.negative = false;
+    result.trim_leading_zeroes();
+    return result;
+  }
+
+  BigInt result;
+  result.magnitude.resize(std::min(an, bn));
+  size_t size = limb_gcd(result.magnitude.data(), this->magnitude.data(), an, rhs.magnitude.data(), bn);
+  result.magnitude.resize(size);
+  return result;
+}
+
+//Divides one operand by the gcd before multiplying, so the product is no larger than the result
+BigInt BigInt::lcm(const BigInt &rhs) const {
+  if(this->is_zero() || rhs.is_zero()) {
     return BigInt();
   }
+  BigInt result = (*this / gcd(rhs)) * rhs;
+  result.negative = false;
+  return result;
+}
+
+typedef unsigned __int128 u128;
+
+//Extended Euclid in machine words for a >= b: returns g = gcd(a, b) and sets
+//the magnitudes of s and t with g = s * a + t * b. The cofactors alternate in
+//sign along the sequence, so s is negative after an odd number of steps and
+//t has the opposite sign (t is 0 when b is)
+template<typename Word>
+static Word word_extended_gcd(Word a, Word b, Word &s, Word &t, bool &s_negative) {
+  Word s0 = 1, s1 = 0, t0 = 0, t1 = 1;
+  bool odd = false;
+  while(b != 0) {
+    Word q = a / b;
+    Word r = a - q * b;
+    a = b;
+    b = r;
+    Word s2 = s0 + q * s1;
+    s0 = s1;
+    s1 = s2;
+    Word t2 = t0 + q * t1;
+    t0 = t1;
+    t1 = t2;
+    odd = !odd;
+  }
+  s = s0;
+  t = t0;
+  s_negative = odd;
+  return a;
+}
+
+//Reads a normalized magnitude of at most two limbs
+static u128 to_u128(const LimbVector &magnitude) {
+  u128 value = 0;
+  for(size_t i = magnitude.size(); i > 0; --i) {
+    value = (value << 64) | magnitude[i - 1];
+  }
+  return value;
+}
+
+//Builds a BigInt from a two-limb magnitude and a sign
+static BigInt from_u128(u128 value, bool negative) {
+  return BigInt({ uint64_t(value), uint64_t(value >> 64) }, negative);
+}
+
+//Extended gcd of magnitudes a >= b of at most two limbs, with the cofactors
+//signed; single-limb operands stay in 64-bit arithmetic
+static BigInt small_extended_gcd(u128 a, u128 b, BigInt &s, BigInt &t) {
+  u128 s_mag, t_mag, g;
+  bool s_negative;
+  if((a >> 64) == 0) {
+    uint64_t s64, t64;
+    g = word_extended_gcd<uint64_t>(uint64_t(a), uint64_t(b), s64, t64, s_negative);
+    s_mag = s64;
+    t_mag = t64;
+  } else {
+    g = word_extended_gcd<u128>(a, b, s_mag, t_mag, s_negative);
+  }
+  s = from_u128(s_mag, s_negative);
+  t = from_u128(t_mag, !s_negative);
+  return from_u128(g, false);
+}
+
+//Runs the Euclid sequence on the magnitudes with Lehmer steps where possible,
+//applying the same steps to the cofactor of the larger operand; operands of
+//at most two limbs, and the tail of larger ones, run in machine words
+BigInt BigInt::extended_gcd(const BigInt &rhs, BigInt &x, BigInt &y) const {
+  bool swapped = compare_magnitudes(*this, rhs) < 0;
+  const BigInt &larger = swapped ? rhs : *this;
+  const BigInt &smaller = swapped ? *this : rhs;
+
+  BigInt s0;
+  BigInt t;
+  BigInt g;
+  if(larger.magnitude.size() <= 2) {
+    g = small_extended_gcd(to_u128(larger.magnitude), to_u128(smaller.magnitude), s0, t);
+  } else {
+    //Sets p * u + q * v for a matrix row (p, q) of opposite signs (or one 0)
+    //and consecutive cofactors u, v, which also have opposite signs: both
+    //products have the same sign, so their magnitudes add
+    auto combine = [](const BigInt &u, const BigInt &v, int64_t p, int64_t q) {
+      BigInt r;
+      r.magnitude.resize(std::max(u.magnitude.size(), v.magnitude.size()) + 1, 0);
+      uint64_t *rp = r.magnitude.data();
+      for(int k = 0; k < 2; ++k) {
+        const BigInt &w = k == 0 ? u : v;
+        int64_t c = k == 0 ? p : q;
+        size_t wn = w.magnitude.size();
+        uint64_t carry = wn ? limb_addmul_1(rp, w.magnitude.data(), wn, uint64_t(c < 0 ? -c : c)) : 0;
+        for(size_t i = wn; carry != 0; ++i) {
+          rp[i] += carry;
+          carry = rp[i] < carry;
+        }
+      }
+      bool from_u = p != 0 && !u.is_zero();
+      r.negative = from_u ? (p < 0) != u.negative : (q < 0) != v.negative;
+      r.trim_leading_zeroes();
+      return r;
+    };
+
+    BigInt a(larger);
+    BigInt b(smaller);
+    a.negative = false;
+    b.negative = false;
+
+    //Invariant: a = s0 * a0 (mod b0) and b = s1 * a0 (mod b0)
+    s0 = BigInt(1);
+    BigInt s1;
+    while(!b.is_zero()) {
+      size_t n = a.magnitude.size();
+      size_t bn = b.magnitude.size();
+      if(n <= 2) {
+        BigInt s, u;
+        a = small_extended_gcd(to_u128(a.magnitude), to_u128(b.magnitude), s, u);
+        s0 = s * s0 + u * s1;
+        break;
+      }
+
+      LimbLehmerMatrix m;
+      bool lehmer = false;
+      LimbScratchScope scratch;
+      uint64_t *padded = nullptr;
+      if(bn >= 3 && bn >= limb_lehmer_threshold && n - bn <= 1) {
+        padded = scratch.allocate_zeroed(n);
+        std::copy(b.magnitude.data(), b.magnitude.data() + bn, padded);
+        lehmer = limb_lehmer_matrix(m, a.magnitude.data(), padded, n);
+      }
+
+      if(lehmer) {
+        BigInt next_a, next_b;
+        next_a.magnitude.resize(n);
+        next_b.magnitude.resize(n);
+        limb_lehmer_combine(next_a.magnitude.data(), a.magnitude.data(), padded, n, m.A, m.B);
+        limb_lehmer_combine(next_b.magnitude.data(), a.magnitude.data(), padded, n, m.C, m.D);
+        next_a.trim_leading_zeroes();
+        next_b.trim_leading_zeroes();
+        a = std::move(next_a);
+        b = std::move(next_b);
+        BigInt next_s = combine(s0, s1, m.A, m.B);
+        s1 = combine(s0, s1, m.C, m.D);
+        s0 = std::move(next_s);
+      } else {
+        std::pair<BigInt, BigInt> qr = a.divmod(b);
+        a = std::move(b);
+        b = std::move(qr.second);
+        BigInt next_s = s0 - qr.first * s1;
+        s0 = std::move(s1);
+        s1 = std::move(next_s);
+      }
+    }
+
+    //The cofactor of the smaller operand follows from a0 * s0 + b0 * t = g
+    BigInt a0(larger);
+    a0.negative = false;
+    BigInt b0(smaller);
+    b0.negative = false;
+    t = b0.is_zero() ? BigInt() : (a - a0 * s0) / b0;
+    g = std::move(a);
+  }
+
+  x = swapped ? std::move(t) : std::move(s0);
+  y = swapped ? std::move(s0) : std::move(t);
+  if(this->negative) {
+    x = -x;
+  }
+  if(rhs.negative) {
+    y = -y;
+  }
+  return g;
+}
+
+//The inverse is the cofactor of this value in the extended gcd with the modulus
+BigInt BigInt::mod_inverse(const BigInt &modulus) const {
+  if(modulus.negative || modulus.is_zero()) {
+    throw std::invalid_argument("Modulus must be positive");
+  }
+  BigInt x;
+  BigInt y;
+  BigInt g = mod(modulus).extended_gcd(modulus, x, y);
+  if(g != BigInt(1)) {
+    throw std::invalid_argument("Value is not invertible modulo the modulus");
+  }
+  return x.mod(modulus);
+}
 
-  BigInt result = binary_search(*this, rhs);
-  
-  if(!result.is_zero()) { //adjust sign if nonzero
-    result.negative = (this->negative != rhs.negative); //same sign = positive, different = negative
+//Random limbs, with the bits above the requested count masked off
+BigInt BigInt::random_bits(size_t bits, const RandomSource &random) {
+  BigInt result;
+  size_t limbs = (bits + 63) / 64;
+  result.magnitude.resize(limbs);
+  for(size_t i = 0; i < limbs; ++i) {
+    result.magnitude[i] = random();
   }
+  if(bits % 64 != 0) {
+    result.magnitude[limbs - 1] &= (uint64_t(1) << (bits % 64)) - 1;
+  }
+  result.trim_leading_zeroes();
   return result;
 }
 
+//Rejection sampling: a draw of bit_length(span) bits is below the span
+//more than half the time, and every accepted value is equally likely
+BigInt BigInt::random_range(const BigInt &low, const BigInt &high, const RandomSource &random) {
+  BigInt span = high - low;
+  if(span.negative || span.is_zero()) {
+    throw std::invalid_argument("Range must not be empty");
+  }
+  size_t bits = span.bit_length();
+  BigInt offset;
+  do {
+    offset = random_bits(bits, random);
+  } while(offset >= span);
+  return low + offset;
+}
+
+//Odd primes below this bound are used for sieving in next_prime
+static const uint32_t SIEVE_PRIME_LIMIT = 1 << 16;
+
+//Odd primes below this bound are trial divisors in the primality tests,
+//which removes about 6 in 7 odd composites before any exponentiation
+static const uint32_t TRIAL_PRIME_LIMIT = 1 << 12;
+
+//Most odd candidates examined per sieve window in next_prime. Windows are
+//sized from the bit length to span several average prime gaps (about
+//0.35 odd candidates per bit), up to this many.
+static const size_t SIEVE_WINDOW = 4096;
+
+//The odd primes below SIEVE_PRIME_LIMIT, grouped so that the product of
+//each group fits in a limb: one limb_mod_1 by the product gives a residue
+//from which the residues of the whole group follow with 64-bit arithmetic
+struct SmallPrimeTable {
+  std::vector<uint32_t> primes;
+  std::vector<uint64_t> products;
+  std::vector<size_t> group_ends; //primes of group g are [group_ends[g - 1], group_ends[g])
+  size_t trial_groups;            //groups made only of primes below TRIAL_PRIME_LIMIT
+
+  SmallPrimeTable() {
+    std::vector<bool> composite(SIEVE_PRIME_LIMIT, false);
+    for(uint32_t i = 3; i < SIEVE_PRIME_LIMIT; i += 2) {
+      if(composite[i]) {
+        continue;
+      }
+      primes.push_back(i);
+      for(uint64_t j = uint64_t(i) * i; j < SIEVE_PRIME_LIMIT; j += 2 * i) {
+        composite[j] = true;
+      }
+    }
+
+    trial_groups = 0;
+    uint64_t product = 1;
+    for(size_t i = 0; i < primes.size(); ++i) {
+      //Trial divisors never share a group with sieving primes
+      bool boundary = primes[i] >= TRIAL_PRIME_LIMIT && (i == 0 || primes[i - 1] < TRIAL_PRIME_LIMIT);
+      if(product > UINT64_MAX / primes[i] || (boundary && product > 1)) {
+        products.push_back(product);
+        group_ends.push_back(i);
+        product = 1;
+      }
+      if(boundary) {
+        trial_groups = products.size();
+      }
+      product *= primes[i];
+    }
+    products.push_back(product);
+    group_ends.push_back(primes.size());
+  }
+
+  size_t group_begin(size_t g) const {
+    return g == 0 ? 0 : group_ends[g - 1];
+  }
+};
+
+//The table is built once, on first use, and shared by all threads
+static const SmallPrimeTable &small_primes() {
+  static const SmallPrimeTable table;
+  return table;
+}
+
+//Outcome of the cheap checks that run before any probable prime test
+enum class TrialResult { COMPOSITE, PRIME, UNKNOWN };
+
+//Settles values below 4, even values and values with an odd prime factor
+//below TRIAL_PRIME_LIMIT, which also proves primality below its square
+static TrialResult trial_division(const BigInt &n) {
+  if(n.is_negative() || n.bit_length() <= 1) {
+    return TrialResult::COMPOSITE;
+  }
+  LimbView limbs = n.get_bit_vector();
+  if(limbs.size() == 1 && limbs[0] < 4) {
+    return TrialResult::PRIME;
+  }
+  if((limbs[0] & 1) == 0) {
+    return TrialResult::COMPOSITE;
+  }
+
+  const SmallPrimeTable &table = small_primes();
+  for(size_t g = 0; g < table.trial_groups; ++g) {
+    uint64_t residue = limb_mod_1(limbs.data(), limbs.size(), table.products[g]);
+    for(size_t i = table.group_begin(g); i < table.group_ends[g]; ++i) {
+      if(residue % table.primes[i] == 0) {
+        return (limbs.size() == 1 && limbs[0] == table.primes[i]) ? TrialResult::PRIME : TrialResult::COMPOSITE;
+      }
+    }
+  }
+  if(limbs.size() == 1 && limbs[0] < uint64_t(TRIAL_PRIME_LIMIT) * TRIAL_PRIME_LIMIT) {
+    return TrialResult::PRIME;
+  }
+  return TrialResult::UNKNOWN;
+}
+
+//Jacobi symbol (a/n) for word-sized a and odd n (TAOCP vol. 2, 4.5.4, exercise 23)
+static int jacobi_u64(uint64_t a, uint64_t n) {
+  int result = 1;
+  a %= n;
+  while(a != 0) {
+    while((a & 1) == 0) {
+      a >>= 1;
+      if((n & 7) == 3 || (n & 7) == 5) {
+        result = -result;
+      }
+    }
+    std::swap(a, n);
+    if((a & 3) == 3 && (n & 3) == 3) {
+      result = -result;
+    }
+    a %= n;
+  }
+  return n == 1 ? result : 0;
+}
+
+//Jacobi symbol (a/n) for a small nonzero a and an odd positive n: the signs
+//and factors of two of a come out by the supplementary laws, and reciprocity
+//turns the rest into a symbol of word-sized values after one limb_mod_1
+static int jacobi(int64_t a, const BigInt &n) {
+  LimbView limbs = n.get_bit_vector();
+  uint64_t n_low = limbs[0];
+  uint64_t x = a < 0 ? uint64_t(-a) : uint64_t(a);
+  int result = 1;
+  if(a < 0 && (n_low & 3) == 3) {
+    result = -result;
+  }
+  while((x & 1) == 0) {
+    x >>= 1;
+    if((n_low & 7) == 3 || (n_low & 7) == 5) {
+      result = -result;
+    }
+  }
+  if(x == 1) {
+    return result;
+  }
+  if((x & 3) == 3 && (n_low & 3) == 3) {
+    result = -result;
+  }
+  return result * jacobi_u64(limb_mod_1(limbs.data(), limbs.size(), x), x);
+}
+
+//Halves a value modulo the odd n, for a value in [0, 2n)
+static BigInt half_mod(BigInt value, const BigInt &n) {
+  if(value.is_bit_set(0)) {
+    value += n;
+  }
+  value = value >> 1;
+  if(value >= n) {
+    value -= n;
+  }
+  return value;
+}
+
+//Strong Lucas probable prime test with Selfridge's parameters P = 1 and
+//Q = (1 - D) / 4 for the first D in 5, -7, 9, -11, ... with (D/n) = -1.
+//With n + 1 = d * 2^s, n passes if U_d = 0 or V_(d*2^r) = 0 for some r < s.
+//The sequences are walked up the bits of d with U_2k = U_k V_k,
+//V_2k = V_k^2 - 2 Q^k and U_(k+1) = (U_k + V_k) / 2, V_(k+1) = (D U_k + V_k) / 2.
+//Requires an odd n > 3 that is not a perfect square.
+static bool is_strong_lucas_probable_prime(const BigInt &n) {
+  int64_t d_param = 5;
+  while(true) {
+    int symbol = jacobi(d_param, n);
+    if(symbol == -1) {
+      break;
+    }
+    if(symbol == 0 && n != BigInt(uint64_t(d_param < 0 ? -d_param : d_param))) {
+      return false; //|D| shares a factor with n
+    }
+    d_param = d_param > 0 ? -(d_param + 2) : -d_param + 2;
+  }
+  int64_t q_param = (1 - d_param) / 4;
+  BigInt d_mod = BigInt(uint64_t(d_param < 0 ? -d_param : d_param), d_param < 0).mod(n);
+  BigInt q_mod = BigInt(uint64_t(q_param < 0 ? -q_param : q_param), q_param < 0).mod(n);
+
+  BigInt n_plus_1 = n + BigInt(1);
+  size_t s = n_plus_1.lowest_set_bit();
+  BigInt d = n_plus_1 >> unsigned(s);
+
+  BigInt u(1), v(1), q_k = q_mod; //k = 1
+  for(size_t bit = d.bit_length() - 1; bit > 0; --bit) {
+    u = (u * v).mod(n);
+    v = (v.square() - (q_k << 1)).mod(n);
+    q_k = q_k.square().mod(n);
+    if(d.is_bit_set(unsigned(bit - 1))) {
+      BigInt next_u = half_mod(u + v, n);
+      v = half_mod((d_mod * u + v).mod(n), n);
+      u = std::move(next_u);
+      q_k = (q_k * q_mod).mod(n);
+    }
+  }
+  if(u == BigInt() || v == BigInt()) {
+    return true;
+  }
+  for(size_t r = 1; r < s; ++r) {
+    v = (v.square() - (q_k << 1)).mod(n);
+    if(v == BigInt()) {
+      return true;
+    }
+    q_k = q_k.square().mod(n);
+  }
+  return false;
+}
+
+//The Baillie-PSW tests proper, for an odd value past trial division
+static bool is_bpsw_probable_prime(const BigInt &n) {
+  if(!n.is_strong_probable_prime(BigInt(2))) {
+    return false;
+  }
+  BigInt root = n.isqrt();
+  if(root.square() == n) {
+    return false;
+  }
+  return is_strong_lucas_probable_prime(n);
+}
+
+//Writes n - 1 = d * 2^s, then squares a^d up to s - 1 times looking for -1
+bool BigInt::is_strong_probable_prime(const BigInt &base) const {
+  if(this->negative || !is_bit_set(0) || (this->magnitude.size() == 1 && this->magnitude[0] < 3)) {
+    throw std::invalid_argument("Miller-Rabin needs an odd value greater than 2");
+  }
+  BigInt n_minus_1 = *this - BigInt(1);
+  size_t s = n_minus_1.lowest_set_bit();
+  BigInt x = base.mod(*this);
+  if(x.is_zero()) { //a multiple of n is no evidence either way
+    return true;
+  }
+  x = x.modpow(n_minus_1 >> unsigned(s), *this);
+  if(x == BigInt(1) || x == n_minus_1) {
+    return true;
+  }
+  for(size_t r = 1; r < s; ++r) {
+    x = x.square().mod(*this);
+    if(x == n_minus_1) {
+      return true;
+    }
+    if(x == BigInt(1)) { //1 reached without passing -1: a nontrivial square root of 1
+      return false;
+    }
+  }
+  return false;
+}
+
+//Trial division settles small values and most composites; the rest get
+//rounds with random bases in [2, n - 1)
+bool BigInt::miller_rabin(unsigned rounds, const RandomSource &random) const {
+  TrialResult trial = trial_division(*this);
+  if(trial != TrialResult::UNKNOWN) {
+    return trial == TrialResult::PRIME;
+  }
+  BigInt n_minus_1 = *this - BigInt(1);
+  for(unsigned i = 0; i < rounds; ++i) {
+    if(!is_strong_probable_prime(random_range(BigInt(2), n_minus_1, random))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//Trial division first, then Baillie-PSW for the values it cannot settle
+bool BigInt::is_probable_prime() const {
+  TrialResult trial = trial_division(*this);
+  if(trial != TrialResult::UNKNOWN) {
+    return trial == TrialResult::PRIME;
+  }
+  return is_bpsw_probable_prime(*this);
+}
+
+//Sieves windows of up to SIEVE_WINDOW odd candidates start + 2j: the residue of
+//start modulo each small prime p gives the first j with p | start + 2j,
+//and every p-th candidate from there is crossed out. In a window below
+//SIEVE_PRIME_LIMIT^2 that leaves only primes; above it the survivors
+//still need the Baillie-PSW test.
+BigInt BigInt::next_prime() const {
+  if(*this < BigInt(2)) {
+    return BigInt(2);
+  }
+  BigInt start = *this + BigInt(1);
+  if(!start.is_bit_set(0)) {
+    start += BigInt(1);
+  }
+  if(start == BigInt(3)) {
+    return start;
+  }
+
+  const SmallPrimeTable &table = small_primes();
+  std::vector<uint32_t> residues(table.primes.size());
+  size_t window = std::min(SIEVE_WINDOW, 64 + 4 * start.bit_length());
+  std::vector<bool> crossed(window);
+  const uint64_t proven_limit = uint64_t(SIEVE_PRIME_LIMIT) * SIEVE_PRIME_LIMIT;
+  while(true) {
+    //Windows below SIEVE_PRIME_LIMIT^2 only need the primes up to the root of their end
+    bool small = start.magnitude.size() == 1 && start.magnitude[0] < proven_limit - 2 * window;
+    size_t count = table.primes.size();
+    if(small) {
+      uint64_t end = start.magnitude[0] + 2 * window;
+      count = 0;
+      while(count < table.primes.size() && uint64_t(table.primes[count]) * table.primes[count] <= end) {
+        ++count;
+      }
+    }
+
+    for(size_t g = 0; g < table.products.size() && table.group_begin(g) < count; ++g) {
+      uint64_t residue = limb_mod_1(start.magnitude.data(), start.magnitude.size(), table.products[g]);
+      for(size_t i = table.group_begin(g); i < table.group_ends[g]; ++i) {
+        residues[i] = uint32_t(residue % table.primes[i]);
+      }
+    }
+
+    std::fill(crossed.begin(), crossed.end(), false);
+    for(size_t i = 0; i < count; ++i) {
+      uint64_t p = table.primes[i];
+      //2j = -residue (mod p); p is odd, so halve p - residue or 2p - residue
+      uint64_t neg = residues[i] == 0 ? 0 : p - residues[i];
+      uint64_t j = (neg & 1) ? (neg + p) / 2 : neg / 2;
+      if(small && start.magnitude[0] + 2 * j == p) { //p itself is not crossed out
+        j += p;
+      }
+      for(; j < window; j += p) {
+        crossed[j] = true;
+      }
+    }
+
+    for(size_t j = 0; j < window; ++j) {
+      if(crossed[j]) {
+        continue;
+      }
+      BigInt candidate = start + BigInt(2 * j);
+      if(small) {
+        return candidate;
+      }
+      if(is_bpsw_probable_prime(candidate)) {
+        return candidate;
+      }
+    }
+    start += BigInt(2 * window);
+  }
+}
+
 // This method compares the current BigInt with the right hand side BigInt
 // and returns 1 if the current is larger, 0 if they are equal, and -1 if the rhs is larger.
 int BigInt::compare(const BigInt &rhs) const {
@@ -456,49 +1658,403 @@ int BigInt::compare(const BigInt &rhs) const {
 
 //has_non_zero() is a helper function that checks if there are any non-zero indices in all of the magnitude vectors
 bool BigInt::has_non_zero() const {
-  bool has_nonzero = false;
-  for(size_t i = 0; i < this->magnitude.size(); i++){
-    if(magnitude[i] != 0){
-      has_nonzero = true;
-    } 
-  } 
-  return has_nonzero;
+  return !this->magnitude.empty(); //normalized form: any limb at all is nonzero
+}
+
+//Above this size, conversion splits the number in half with a cached power of
+//the radix so the work is done by big multiplications and divisions instead of
+//one limb at a time
+static const size_t RADIX_RECURSIVE_THRESHOLD_LIMBS = 60;
+
+static const char RADIX_DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+struct RadixDigitTable {
+  uint8_t values[256];
+
+  RadixDigitTable() {
+    std::fill(values, values + 256, 0xFF);
+    for(unsigned i = 0; i < 36; ++i) {
+      values[(unsigned char) RADIX_DIGITS[i]] = uint8_t(i);
+      values[(unsigned char) std::toupper(RADIX_DIGITS[i])] = uint8_t(i);
+    }
+  }
+};
+
+//Maps a character to its digit value in radix 36 (letters in either case), or 0xFF
+static const uint8_t *radix_digit_values() {
+  static const RadixDigitTable table;
+  return table.values;
+}
+
+//Returns log2(radix) for the radices whose digits are groups of bits, 0 otherwise
+static unsigned radix_bits(unsigned radix) {
+  return (radix & (radix - 1)) == 0 ? unsigned(__builtin_ctz(radix)) : 0;
+}
+
+//Rejects radices outside 2-36 for both directions of conversion
+static void check_radix(unsigned radix) {
+  if(radix < 2 || radix > 36) {
+    throw std::invalid_argument("Radix must be between 2 and 36");
+  }
+}
+
+//Converts a chunk of digits that fits in a uint64_t
+static uint64_t parse_radix_chunk(const char *digits, size_t len, unsigned radix) {
+  const uint8_t *values = radix_digit_values();
+  uint64_t value = 0;
+  for(size_t i = 0; i < len; ++i) {
+    value = value * radix + values[(unsigned char) digits[i]];
+  }
+  return value;
+}
+
+//Writes a chunk as exactly `len` digits, right to left. Base 10 gets its own
+//loop so the divisions by a constant compile to multiplications.
+static void write_radix_chunk(char *buf, size_t len, uint64_t chunk, unsigned radix) {
+  if(radix == 10) {
+    for(size_t j = len; j > 0; --j) {
+      buf[j - 1] = char('0' + chunk % 10);
+      chunk /= 10;
+    }
+    return;
+  }
+  for(size_t j = len; j > 0; --j) {
+    buf[j - 1] = RADIX_DIGITS[chunk % radix];
+    chunk /= radix;
+  }
 }
 
 //To Decimal Function That Converts BigInt magnitude vector to a String
 std::string BigInt::to_dec() const {
-  //Return 0 if the BigInt equals 0
-  if(magnitude.size() == 0 || !has_non_zero()){
+  return to_string(10);
+}
+
+//Power-of-two radices read their digits straight out of the bits; other
+//radices convert in chunks, splitting large values with cached powers
+std::string BigInt::to_string(unsigned radix) const {
+  check_radix(radix);
+  if(radix == 16) {
+    return to_hex();
+  }
+  if(is_zero()) {
     return "0";
   }
 
-  //Create string placeholders and BigInt representations of number to be able to execute program
-  std::string dec = ""; 
-  std::string dec_rev = "";
-  BigInt ten = BigInt(10, false);
+  std::string out;
+  if(this->negative) {
+    out.push_back('-');
+  }
+
+  unsigned bits = radix_bits(radix);
+  if(bits != 0) {
+    const uint64_t *limbs = this->magnitude.data();
+    size_t bit_count = bit_length();
+    size_t digits = (bit_count + bits - 1) / bits;
+    size_t start = out.size();
+    out.resize(start + digits);
+    for(size_t i = 0; i < digits; ++i) {
+      size_t bit = i * bits;
+      uint64_t value = limbs[bit / 64] >> (bit % 64);
+      if(bit % 64 + bits > 64 && bit / 64 + 1 < this->magnitude.size()) {
+        value |= limbs[bit / 64 + 1] << (64 - bit % 64);
+      }
+      out[start + digits - 1 - i] = RADIX_DIGITS[value & (radix - 1)];
+    }
+    return out;
+  }
+
   BigInt copy = BigInt(*this);
-  BigInt zero = BigInt(0, false);
+  copy.negative = false;
+  if(copy.magnitude.size() < RADIX_RECURSIVE_THRESHOLD_LIMBS) {
+    copy.append_radix_basecase(out, radix, 0);
+    return out;
+  }
+
+  //Find the smallest cached power chunk^(2^k) larger than the number, then split recursively
+  size_t levels = 1;
+  const BigInt *const *powers = RadixPowers::get(radix, levels);
+  while(*powers[levels - 1] <= copy) {
+    powers = RadixPowers::get(radix, ++levels);
+  }
+  copy.append_radix_recursive(out, radix, powers, levels - 1, 0);
+  return out;
+}
+
+//Converts the magnitude a chunk of digits at a time, using single-limb division by the chunk base
+void BigInt::append_radix_basecase(std::string &out, unsigned radix, size_t pad) const {
+  RadixChunk chunk_info = RadixPowers::chunk(radix);
+  LimbScratchScope scratch;
+  size_t size = this->magnitude.size();
+  uint64_t *quotient = scratch.allocate(size);
+  std::copy(this->magnitude.begin(), this->magnitude.end(), quotient);
+
+  //Chunks come out least significant first. Each chunk takes more than
+  //32 bits off the quotient, so there are at most 2 * size + 1.
+  uint64_t *chunks = scratch.allocate(2 * size + 1);
+  size_t num_chunks = 0;
+  while(size > 0) {
+    chunks[num_chunks++] = limb_divrem_1(quotient, quotient, size, chunk_info.base);
+    size = limb_normalized_size(quotient, size);
+  }
+
+  size_t start = out.size();
+  char buf[64];
+  size_t width = chunk_info.digits;
+  for(size_t i = num_chunks; i > 0; --i) {
+    //Each chunk is zero-padded to its full width, except the most significant
+    write_radix_chunk(buf, width, chunks[i - 1], radix);
+    size_t skip = 0;
+    if(i == num_chunks) {
+      while(skip < width - 1 && buf[skip] == '0') {
+        ++skip;
+      }
+    }
+    out.append(buf + skip, width - skip);
+  }
+
+  //Zero-pad on the left when this is the lower half of a larger number
+  size_t written = out.size() - start;
+  if(pad > written) {
+    out.insert(start, pad - written, '0');
+  }
+}
+
+//Converts the magnitude by splitting it into a high and low half,
+//each converted recursively (the low half zero-padded to its full width)
+void BigInt::append_radix_recursive(std::string &out, unsigned radix, const BigInt *const *powers, size_t level, size_t pad) const {
+  if(level == 0 || this->magnitude.size() < RADIX_RECURSIVE_THRESHOLD_LIMBS) {
+    append_radix_basecase(out, radix, pad);
+    return;
+  }
+
+  const BigInt &split = *powers[level - 1];
+  if(pad == 0 && *this < split) { //no high half and no padding needed
+    append_radix_recursive(out, radix, powers, level - 1, 0);
+    return;
+  }
+
+  size_t low_digits = RadixPowers::chunk(radix).digits << (level - 1);
+  std::pair<BigInt, BigInt> halves = divmod(split);
+  halves.first.append_radix_recursive(out, radix, powers, level - 1, pad > low_digits ? pad - low_digits : 0);
+  halves.second.append_radix_recursive(out, radix, powers, level - 1, low_digits);
+}
+
+//Parses a decimal string, with an optional leading minus sign
+BigInt BigInt::from_dec(const std::string &str) {
+  return from_string(str, 10);
+}
+
+//Radix 16 goes through from_hex; otherwise validates the digits, then packs
+//bits directly for power-of-two radices or converts in chunks (split
+//recursively with cached powers) for the others
+BigInt BigInt::from_string(const std::string &str, unsigned radix) {
+  check_radix(radix);
+  if(radix == 16) {
+    return from_hex(str);
+  }
+  size_t start = (!str.empty() && str[0] == '-') ? 1 : 0;
+  if(start == str.size()) {
+    throw std::invalid_argument("String has no digits");
+  }
+  const uint8_t *values = radix_digit_values();
+  for(size_t i = start; i < str.size(); ++i) {
+    if(values[(unsigned char) str[i]] >= radix) {
+      throw std::invalid_argument("Invalid digit for the radix");
+    }
+  }
+
+  const char *digits = str.data() + start;
+  size_t len = str.size() - start;
+  BigInt result;
+  unsigned bits = radix_bits(radix);
+  if(bits != 0) {
+    result.magnitude.resize((len * bits + 63) / 64, 0);
+    uint64_t *limbs = result.magnitude.data();
+    for(size_t i = 0; i < len; ++i) {
+      uint64_t value = values[(unsigned char) digits[len - 1 - i]];
+      size_t bit = i * bits;
+      limbs[bit / 64] |= value << (bit % 64);
+      if(bit % 64 + bits > 64) {
+        limbs[bit / 64 + 1] |= value >> (64 - bit % 64);
+      }
+    }
+  } else {
+    //Find the level of the largest split, so the powers are fetched once
+    size_t chunk_digits = RadixPowers::chunk(radix).digits;
+    size_t levels = 0;
+    if(len > chunk_digits * RADIX_RECURSIVE_THRESHOLD_LIMBS) {
+      while((chunk_digits << levels) < len) {
+        ++levels;
+      }
+    }
+    const BigInt *const *powers = nullptr;
+    if(levels > 0) {
+      powers = RadixPowers::get(radix, levels);
+    }
+    result = from_radix_digits(digits, len, radix, powers);
+  }
 
-  //Edge Case: Remove any Zeros in the beginning of the magntidue
-  copy.trim_leading_zeroes();
+  result.trim_leading_zeroes();
+  if(start == 1 && !result.magnitude.empty()) {
+    result.negative = true;
+  }
+  return result;
+}
 
-  //Take the mod 10 of the number to get the digit and then divide by 10 continuously until the BigInt equals zero.
-  while(copy.compare(zero) != 0){
-    BigInt division = copy/ten;
-    BigInt mod = copy - ten * division;
-    copy = division;
-    char c = mod.get_bits(0) + '0';
-    dec_rev.push_back(c);
+//Converts a run of digits, either one chunk at a time or by splitting it
+//into a high and low part joined with a cached power of the chunk base
+BigInt BigInt::from_radix_digits(const char *digits, size_t len, unsigned radix, const BigInt *const *powers) {
+  RadixChunk chunk_info = RadixPowers::chunk(radix);
+  if(len <= chunk_info.digits * RADIX_RECURSIVE_THRESHOLD_LIMBS) {
+    BigInt result;
+    //The first chunk takes the leftover digits so the rest are full chunks
+    size_t first = len % chunk_info.digits;
+    if(first == 0) {
+      first = chunk_info.digits;
+    }
+    for(size_t pos = 0; pos < len; pos += (pos == 0 ? first : chunk_info.digits)) {
+      size_t chunk_len = (pos == 0) ? first : chunk_info.digits;
+      uint64_t chunk = parse_radix_chunk(digits + pos, chunk_len, radix);
+      //result = result * radix^chunk_len + chunk
+      uint64_t scale = (chunk_len == chunk_info.digits) ? chunk_info.base : 1;
+      for(size_t i = 0; scale == 1 && i < chunk_len; ++i) {
+        scale *= radix;
+      }
+      uint64_t carry = limb_mul_1(result.magnitude.data(), result.magnitude.data(), result.magnitude.size(), scale);
+      for(size_t i = 0; i < result.magnitude.size() && chunk != 0; ++i) {
+        result.magnitude[i] += chunk;
+        chunk = (result.magnitude[i] < chunk) ? 1 : 0;
+      }
+      carry += chunk;
+      if(carry != 0) {
+        result.magnitude.push_back(carry);
+      }
+    }
+    result.trim_leading_zeroes();
+    return result;
   }
 
-  // Reverse the string to ensure that the largest digit is first
-  for(int i = dec_rev.size() - 1; i >= 0; i--){
-    dec.push_back(dec_rev[i]);
+  //Split off the largest low part of chunk * 2^k digits that leaves a nonempty high part
+  size_t level = 0;
+  while((chunk_info.digits << (level + 1)) < len) {
+    ++level;
   }
+  size_t low_digits = chunk_info.digits << level;
+
+  BigInt high = from_radix_digits(digits, len - low_digits, radix, powers);
+  BigInt low = from_radix_digits(digits + len - low_digits, low_digits, radix, powers);
+  high *= *powers[level];
+  high += low;
+  return high;
+}
+
+//Size of the binary encoding, computed on a view of this value
+size_t BigInt::encoded_size() const {
+  return BigIntView(*this).encoded_size();
+}
+
+//Writes the binary encoding through a view, which skips any leading zero limbs
+size_t BigInt::encode(uint8_t *out, size_t capacity) const {
+  return BigIntView(*this).encode(out, capacity);
+}
+
+//Reads the binary encoding, copying the limbs bytewise so the buffer needs no alignment
+BigInt BigInt::decode(const uint8_t *in, size_t size, size_t *consumed) {
+  bool negative;
+  size_t count;
+  size_t header = BigIntView::decode_header(in, size, negative, count);
+  const uint8_t *limb_bytes = in + header;
 
-  // Add a negative sign if the number string is negative 
-  if(this->negative){
-    dec.insert(dec.begin(), '-');
+  BigInt result;
+  result.magnitude.resize(count);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if(count > 0) {
+    std::memcpy(result.magnitude.data(), limb_bytes, 8 * count);
   }
-  return dec;
-}
\ No newline at end of file
+#else
+  for(size_t i = 0; i < count; ++i) {
+    uint64_t limb = 0;
+    for(unsigned byte = 8; byte > 0; --byte) {
+      limb = (limb << 8) | limb_bytes[8 * i + byte - 1];
+    }
+    result.magnitude[i] = limb;
+  }
+#endif
+  result.trim_leading_zeroes();
+  result.negative = negative && !result.magnitude.empty();
+
+  if(consumed) {
+    *consumed = header + 8 * count;
+  }
+  return result;
+}
+
+//Size of the sort key, computed on a view of this value
+size_t BigInt::sort_key_size() const {
+  return BigIntView(*this).sort_key_size();
+}
+
+//Writes the sort key through a view, like encode
+size_t BigInt::write_sort_key(uint8_t *out, size_t capacity) const {
+  return BigIntView(*this).write_sort_key(out, capacity);
+}
+
+//Writes the key straight into the string's buffer
+std::string BigInt::sort_key() const {
+  BigIntView view(*this);
+  std::string key(view.sort_key_size(), '\0');
+  view.write_sort_key(reinterpret_cast<uint8_t *>(&key[0]), key.size());
+  return key;
+}
+
+//Reads the class byte and the count, then the limbs from the most
+//significant, undoing the complement of negative keys
+BigInt BigInt::from_sort_key(const uint8_t *in, size_t size, size_t *consumed) {
+  if(size < 1) {
+    throw std::invalid_argument("Truncated BigInt sort key");
+  }
+  if(in[0] > 2) {
+    throw std::invalid_argument("Invalid class byte in BigInt sort key");
+  }
+  BigInt result;
+  if(in[0] == 1) {
+    if(consumed) {
+      *consumed = 1;
+    }
+    return result;
+  }
+  if(size < 9) {
+    throw std::invalid_argument("Truncated BigInt sort key");
+  }
+
+  bool negative = (in[0] == 0);
+  uint64_t flip = negative ? UINT64_MAX : 0;
+  auto load = [&](const uint8_t *p) {
+    uint64_t value = 0;
+    for(unsigned byte = 0; byte < 8; ++byte) {
+      value = (value << 8) | p[byte];
+    }
+    return value ^ flip;
+  };
+  uint64_t count = load(in + 1);
+  if(count == 0 || count > (size - 9) / 8) {
+    throw std::invalid_argument(count == 0 ? "Invalid limb count in BigInt sort key" : "Truncated BigInt sort key");
+  }
+
+  result.magnitude.resize(count);
+  for(size_t i = 0; i < count; ++i) {
+    result.magnitude[count - 1 - i] = load(in + 9 + 8 * i);
+  }
+  result.trim_leading_zeroes();
+  result.negative = negative && !result.magnitude.empty();
+
+  if(consumed) {
+    *consumed = 9 + 8 * count;
+  }
+  return result;
+}
+
+//Hashes through a view, so a BigInt and a view of it hash the same
+size_t BigInt::hash() const {
+  return BigIntView(*this).hash();
+}
@@ -1,20 +1,43 @@
 #ifndef BIGINT_H
 #define BIGINT_H
 
+#include <functional>
 #include <initializer_list>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+#include "limb_vector.h"
 
 //! @file
 //! Arbitrary-precision integer data type.
 
+class BigIntView;
+
+//! Source of uniformly distributed 64-bit random words for the random
+//! generation and probabilistic primality functions of BigInt, e.g.
+//! `[&gen] { return gen(); }` for a `std::mt19937_64 gen`. Pass a
+//! generator by reference (or through a lambda like this one) so that
+//! its state advances.
+typedef std::function<uint64_t()> RandomSource;
+
 //! Class representing an arbitrary-precision integer represented as a bit string
-//! (implemented using a vector of `uint64_t` elements) and a boolean flag
-//! to record whether or not the value is negative.
+//! (implemented using a LimbVector of `uint64_t` elements, which keeps small
+//! values inside the object) and a boolean flag to record whether or not the
+//! value is negative.
+//!
+//! Every BigInt is kept in normalized form: the magnitude has no leading
+//! (most significant) zero limbs, so 0 has no limbs at all, and 0 is
+//! never negative. Constructors establish this and every operation
+//! preserves it, which lets compare() and the comparison operators
+//! decide by limb count and then scan limbs in place, without copying
+//! or trimming either operand.
 class BigInt {
 private:
-  std::vector<u_int64_t> magnitude;
+  LimbVector magnitude;
   bool negative;
 
 public:
@@ -25,6 +48,7 @@ public:
   //! Constructor from an `std::initializer_list` of `uint64_t` values
   //! to initialize the BigInt object's bit string, and (optionally)
   //! a boolean value indicating whether the value is negative.
+  //! Leading zero limbs are dropped, and a value of 0 is not negative.
   //!
   //! @param vals `std::initializer_list` of `uint64_t` values,
   //!             in order from less-significant to more-significant
@@ -39,12 +63,23 @@ public:
   //! @param negative if true, the value is negative
   BigInt(uint64_t val, bool negative = false);
 
+  //! Constructor from a BigIntView, copying the viewed limbs.
+  //!
+  //! @param view the value to copy
+  explicit BigInt(const BigIntView &view);
+
   //! Copy constructor.
   //!
   //! @param other another BigInt object that this object should be made
   //!              identical to
   BigInt(const BigInt &other);
 
+  //! Move constructor.
+  //!
+  //! @param other another BigInt object whose value should be moved
+  //!              into this object; it is left equal to 0
+  BigInt(BigInt &&other) noexcept;
+
   //! Destructor.
   ~BigInt();
 
@@ -54,6 +89,12 @@ public:
   //!            identical to
   BigInt &operator=(const BigInt &rhs);
 
+  //! Move assignment operator.
+  //!
+  //! @param rhs another BigInt object whose value should be moved
+  //!            into this object; it is left equal to 0
+  BigInt &operator=(BigInt &&rhs) noexcept;
+
   //! Check whether value is negative.
   //!
   //! @return true if the value is negative, false otherwise
@@ -72,31 +113,59 @@ public:
   //!         containing the bit string)
   uint64_t get_bits(unsigned index) const;
 
-  //! Return a const reference to the underlying vector of
+  //! Return a read-only view of the underlying array of
   //! `uint64_t` values representing the bits of the magnitude of the
   //! overall BigInt value. Note that the values should be in
   //! "little endian" order: element 0 is the lowest 64 bits,
-  //! eleemnt 1 is the next-lowest 64 bits, etc. In theory,
-  //! all you should need to do is return a reference to the
-  //! internal vector the BigInt object keeps its magnitude bits in.
+  //! eleemnt 1 is the next-lowest 64 bits, etc. The view refers to
+  //! the limbs stored in this object (no copy is made), compares equal
+  //! to a `std::vector<uint64_t>` with the same elements, and converts
+  //! to one when a vector is needed.
   //!
-  //! @return const reference to the vector containing the bit string values
+  //! @return view of the array containing the bit string values
   //!         (element at index has the least-significant 64 bits, etc.)
-  const std::vector<uint64_t> &get_bit_vector() const;
+  LimbView get_bit_vector() const;
 
   //! Addition operator.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
   //!            is the implicit receiver object, i.e., `*this`)
   //! @return the BigInt value representing the sum of the operands
-  BigInt operator+(const BigInt &rhs) const;
+  BigInt operator+(const BigInt &rhs) const &;
+
+  //! Addition operators for temporary operands. The result reuses the
+  //! limb buffer of a temporary operand instead of allocating a new one,
+  //! so an expression such as `a + b * c` allocates only for the product.
+  BigInt operator+(const BigInt &rhs) &&;
+  BigInt operator+(BigInt &&rhs) const &;
+  BigInt operator+(BigInt &&rhs) &&;
 
   //! Subtraction operator.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
   //!            is the implicit receiver object, i.e., `*this`)
   //! @return the BigInt value representing the difference of the operands
-  BigInt operator-(const BigInt &rhs) const;
+  BigInt operator-(const BigInt &rhs) const &;
+
+  //! Subtraction operators for temporary operands, which reuse the
+  //! limb buffer of a temporary operand like the addition operators.
+  BigInt operator-(const BigInt &rhs) &&;
+  BigInt operator-(BigInt &&rhs) const &;
+  BigInt operator-(BigInt &&rhs) &&;
+
+  //! Compound addition operator. Adds in place, reusing the
+  //! existing storage of this object where possible.
+  //!
+  //! @param rhs the BigInt value to add to this one
+  //! @return reference to this object
+  BigInt &operator+=(const BigInt &rhs);
+
+  //! Compound subtraction operator. Subtracts in place, reusing the
+  //! existing storage of this object where possible.
+  //!
+  //! @param rhs the BigInt value to subtract from this one
+  //! @return reference to this object
+  BigInt &operator-=(const BigInt &rhs);
 
   //! Unary negation operator.
   //!
@@ -121,6 +190,69 @@ public:
   //! @throw std::invalid_argument if this object represents a negative value
   BigInt operator<<(unsigned n) const;
 
+  //! Compound left shift operator. Shifts in place, growing the
+  //! storage of this object at most once.
+  //!
+  //! @param n number of bits to shift left by
+  //! @return reference to this object
+  //! @throw std::invalid_argument if this object represents a negative value
+  BigInt &operator<<=(unsigned n);
+
+  //! Right shift by n bits. Negative values shift as if stored in
+  //! two's complement (an arithmetic shift), so the result is this
+  //! value divided by `2^n` rounded toward negative infinity
+  //! (e.g. `-5 >> 1` is `-3`).
+  //!
+  //! @param n number of bits to shift right by
+  //! @return BigInt value representing the result of shifting this
+  //!         value right by `n` bits
+  BigInt operator>>(unsigned n) const;
+
+  //! Compound right shift operator. Shifts in place.
+  //!
+  //! @param n number of bits to shift right by
+  //! @return reference to this object
+  BigInt &operator>>=(unsigned n);
+
+  //! Bitwise operators. Operands behave as if stored in two's
+  //! complement with infinitely many sign bits, like the built-in
+  //! signed integer types and Python integers: `-1` has every bit set,
+  //! `x & -1 == x`, and `x ^ -1 == ~x`.
+  //!
+  //! @param rhs the right-hand side BigInt value
+  //! @return the bitwise AND, OR or XOR of the operands
+  BigInt operator&(const BigInt &rhs) const;
+  BigInt operator|(const BigInt &rhs) const;
+  BigInt operator^(const BigInt &rhs) const;
+
+  //! Compound bitwise operators.
+  BigInt &operator&=(const BigInt &rhs);
+  BigInt &operator|=(const BigInt &rhs);
+  BigInt &operator^=(const BigInt &rhs);
+
+  //! Bitwise complement in two's complement, i.e. `-x - 1`.
+  //!
+  //! @return the complement of this value
+  BigInt operator~() const;
+
+  //! @return the number of bits in the magnitude up to and including
+  //!         the highest set bit (0 for 0), i.e. one more than the
+  //!         index of the highest set bit
+  size_t bit_length() const;
+
+  //! @return the number of 1 bits in the magnitude (the sign is ignored,
+  //!         since a negative value has infinitely many 1 bits in two's
+  //!         complement)
+  size_t popcount() const;
+
+  //! Find the lowest set bit. It is the same for a value and its
+  //! negation, so the sign is ignored.
+  //!
+  //! @return the index of the lowest 1 bit, i.e. the number of trailing
+  //!         zero bits
+  //! @throw std::invalid_argument if this value is 0
+  size_t lowest_set_bit() const;
+
   //! Multiplication operator.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
@@ -128,6 +260,47 @@ public:
   //! @return the BigInt value representing the product of the operands
   BigInt operator*(const BigInt &rhs) const;
 
+  //! Multiply a list of values with a balanced product tree, so that
+  //! the operands of every multiplication have similar sizes (which is
+  //! where Karatsuba and Toom-3 pay off). When limb_mul_threads is
+  //! greater than 1, large subtrees are multiplied on separate threads.
+  //!
+  //! @param values the values to multiply
+  //! @return the product of all the values (1 if `values` is empty)
+  static BigInt product(const std::vector<BigInt> &values);
+
+  //! Compound multiplication operator.
+  //!
+  //! @param rhs the BigInt value to multiply this one by
+  //! @return reference to this object
+  BigInt &operator*=(const BigInt &rhs);
+
+  //! Fused multiply-accumulate: add `a * b` to this value. When the
+  //! product has the sign of this value (or this value is 0) and the
+  //! shorter operand is below limb_karatsuba_threshold limbs, the rows of
+  //! the product are added straight into this value's limbs; otherwise
+  //! the product goes to arena scratch space. Either way no temporary
+  //! BigInt is created, and the limbs are only reallocated when the
+  //! accumulator grows.
+  //!
+  //! @param a the first factor (may be this object)
+  //! @param b the second factor (may be this object)
+  //! @return reference to this object
+  BigInt &addmul(const BigInt &a, const BigInt &b);
+
+  //! Dot product: the sum of `a[i] * b[i]`, accumulated with addmul into
+  //! separate accumulators for positive and negative products so every
+  //! step stays on the in-place path. When limb_mul_threads is greater
+  //! than 1 and the work is large enough, the pairs are split into
+  //! contiguous ranges with one pair of accumulators per thread, merged
+  //! at the end.
+  //!
+  //! @param a the first vector
+  //! @param b the second vector
+  //! @return the dot product (0 if the vectors are empty)
+  //! @throw std::invalid_argument if the vectors have different lengths
+  static BigInt dot(const std::vector<BigInt> &a, const std::vector<BigInt> &b);
+
   //! Division operator.
   //! Note that since BigInt objects represent integers, this
   //! operator should return a quotient value with the largest
@@ -150,6 +323,176 @@ public:
   //!        equal to 0
   BigInt operator/(const BigInt &rhs) const;
 
+  //! Division with remainder. The quotient is the same truncated
+  //! quotient returned by operator/, and the remainder satisfies
+  //! `quotient * rhs + remainder == *this`, so it is either 0 or
+  //! has the same sign as the dividend (e.g. `-7 divmod 2` gives
+  //! quotient `-3` and remainder `-1`).
+  //!
+  //! @param rhs the right-hand side BigInt value (the divisor)
+  //! @return the quotient (first) and remainder (second)
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  std::pair<BigInt, BigInt> divmod(const BigInt &rhs) const;
+
+  //! Integer square root.
+  //!
+  //! @return the largest BigInt value whose square is less than or
+  //!         equal to this value
+  //! @throw std::invalid_argument if this value is negative
+  BigInt isqrt() const;
+
+  //! Integer k-th root, rounded toward zero: the result `r` satisfies
+  //! `|r|^k <= |*this| < (|r|+1)^k` and has the sign of this value.
+  //!
+  //! @param k the degree of the root
+  //! @return the k-th root of this value
+  //! @throw std::invalid_argument if `k` is 0, or if this value is
+  //!        negative and `k` is even
+  BigInt nth_root(unsigned k) const;
+
+  //! Remainder operator. Like the `%` operator on built-in integers,
+  //! the remainder goes with the truncated quotient of operator/, so it
+  //! is either 0 or has the same sign as the dividend.
+  //!
+  //! @param rhs the right-hand side BigInt value (the divisor)
+  //! @return the remainder of dividing this value by `rhs`
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  BigInt operator%(const BigInt &rhs) const;
+
+  //! Reduce this value modulo a positive modulus. Unlike operator%,
+  //! the result is never negative (e.g. `-7 mod 3` is `2`).
+  //!
+  //! @param modulus the modulus, which must be positive
+  //! @return the value in the range `[0, modulus)` congruent to this one
+  //! @throw std::invalid_argument if the modulus is not positive
+  BigInt mod(const BigInt &modulus) const;
+
+  //! Square this value with limb_sqr, which computes each cross product
+  //! once and so takes about half to two thirds of the time of `*this * *this`
+  //! through the general multiplication.
+  //!
+  //! @return this value squared
+  BigInt square() const;
+
+  //! Exponentiation by repeated squaring, scanning the exponent from its
+  //! top bit so that every step is a square() and every set bit a
+  //! multiplication by the (small) original value.
+  //!
+  //! @param exponent the power to raise this value to
+  //! @return this value raised to the power `exponent` (1 if `exponent` is 0)
+  BigInt pow(unsigned exponent) const;
+
+  //! Modular exponentiation. Odd moduli use Montgomery multiplication
+  //! (see MontgomeryContext); the context for the most recently used
+  //! modulus is kept per thread, so repeated calls with the same modulus
+  //! skip the setup. Even moduli fall back to reducing with division
+  //! after every step.
+  //!
+  //! @param exponent the exponent, which must not be negative
+  //! @param modulus the modulus, which must be positive
+  //! @return `(*this)^exponent mod modulus`, in the range `[0, modulus)`
+  //! @throw std::invalid_argument if the exponent is negative or the
+  //!        modulus is not positive
+  BigInt modpow(const BigInt &exponent, const BigInt &modulus) const;
+
+  //! Greatest common divisor. Operands of a few limbs use binary GCD;
+  //! larger ones use Lehmer's algorithm, which replaces runs of Euclid
+  //! divisions with 128-bit arithmetic on the leading bits (see
+  //! limb_gcd).
+  //!
+  //! @param rhs the other value (any sign)
+  //! @return the largest value dividing both operands, which is never
+  //!         negative (`gcd(0, 0)` is 0)
+  BigInt gcd(const BigInt &rhs) const;
+
+  //! Least common multiple.
+  //!
+  //! @param rhs the other value (any sign)
+  //! @return the smallest non-negative value divisible by both
+  //!         operands (0 if either is 0)
+  BigInt lcm(const BigInt &rhs) const;
+
+  //! Extended Euclidean algorithm: find cofactors `x` and `y` with
+  //! `*this * x + rhs * y == gcd(*this, rhs)`. The cofactors are the
+  //! small ones the Euclid sequence produces, with `|x| <= |rhs|` and
+  //! `|y| <= |*this|` when both operands are nonzero. If `rhs` is 0 then
+  //! `x` is 1 or -1 (the sign of this value) and `y` is 0, and if only
+  //! this value is 0 then `x` is 0 and `y` is 1 or -1; `gcd(0, 0)` gives
+  //! `x = 1` and `y = 0`.
+  //!
+  //! @param rhs the other value (any sign)
+  //! @param x set to the cofactor of this value
+  //! @param y set to the cofactor of `rhs`
+  //! @return the greatest common divisor, as returned by gcd()
+  BigInt extended_gcd(const BigInt &rhs, BigInt &x, BigInt &y) const;
+
+  //! Modular inverse.
+  //!
+  //! @param modulus the modulus, which must be positive
+  //! @return the value `x` in the range `[0, modulus)` with
+  //!         `*this * x` congruent to 1 modulo `modulus`
+  //! @throw std::invalid_argument if the modulus is not positive, or if
+  //!        this value and the modulus are not coprime
+  BigInt mod_inverse(const BigInt &modulus) const;
+
+  //! Random value with the given number of bits.
+  //!
+  //! @param bits the number of random bits
+  //! @param random the source of random words
+  //! @return a value drawn uniformly from `[0, 2^bits)`
+  static BigInt random_bits(size_t bits, const RandomSource &random);
+
+  //! Random value in a range. Draws values with as many bits as
+  //! `high - low` until one falls in the range, so it takes fewer than
+  //! two draws on average.
+  //!
+  //! @param low the smallest value that can be returned (any sign)
+  //! @param high one more than the largest value that can be returned
+  //! @param random the source of random words
+  //! @return a value drawn uniformly from `[low, high)`
+  //! @throw std::invalid_argument if `high <= low`
+  static BigInt random_range(const BigInt &low, const BigInt &high, const RandomSource &random);
+
+  //! Miller-Rabin test to a single base: check whether this odd value
+  //! `n > 2` is a strong probable prime to base `a`, i.e. with
+  //! `n - 1 = d * 2^s` and `d` odd, `a^d = 1` or `a^(d*2^r) = -1`
+  //! (mod n) for some `r < s`. Every prime passes; a composite passes
+  //! for at most a quarter of the bases.
+  //!
+  //! @param base the base, reduced modulo this value
+  //! @return true if this value is a strong probable prime to the base
+  //! @throw std::invalid_argument if this value is not odd and greater than 2
+  bool is_strong_probable_prime(const BigInt &base) const;
+
+  //! Miller-Rabin test with random bases, after trial division by small
+  //! primes. A composite passes with probability at most `4^-rounds`.
+  //!
+  //! @param rounds the number of random bases to try
+  //! @param random the source of random words for the bases
+  //! @return false if this value is certainly not prime, true if it is
+  //!         prime or passed every round
+  bool miller_rabin(unsigned rounds, const RandomSource &random) const;
+
+  //! Baillie-PSW primality test: trial division by small primes, a
+  //! Miller-Rabin test to base 2 and a strong Lucas test with Selfridge's
+  //! parameters. The two tests fail on different composites, and none
+  //! is known that passes both; the answer is exact below 2^64.
+  //! Negative values, 0 and 1 are not prime.
+  //!
+  //! @return true if this value is (very probably) prime
+  bool is_probable_prime() const;
+
+  //! Find the next prime: the smallest value greater than this one that
+  //! passes is_probable_prime. Candidates are sieved in windows by a
+  //! table of small primes, whose residues are found with one
+  //! single-limb remainder per group of primes, so only candidates
+  //! with no small factor reach the Baillie-PSW test.
+  //!
+  //! @return the smallest probable prime greater than this value
+  BigInt next_prime() const;
+
   //! Compare two BigInt values, returning
   //!   - negative if lhs < rhs
   //!   - 0 if lhs = rhs
@@ -170,6 +513,11 @@ public:
   bool operator>(const BigInt &rhs) const  { return compare(rhs) > 0; }
   bool operator>=(const BigInt &rhs) const { return compare(rhs) >= 0; }
 
+#if __cplusplus >= 202002L
+  //! Three-way comparison, for code built as C++20 or later.
+  std::strong_ordering operator<=>(const BigInt &rhs) const { return compare(rhs) <=> 0; }
+#endif
+
   //! Return a string representing the value of this BigInt, in
   //! lower-case hexadecimal (base-16). Note that there should be a leading
   //! minus sign (`-`) if this value is negative.
@@ -177,6 +525,34 @@ public:
   //! @return the value of this BigInt object in hexadecimal
   std::string to_hex() const;
 
+  //! @return the number of characters to_hex produces for this value,
+  //!         including the minus sign of a negative value
+  size_t hex_length() const;
+
+  //! Write the same characters as to_hex() into a buffer, without a
+  //! terminating null character. Nothing is allocated, which makes this
+  //! the fast way to format many values into one output buffer.
+  //!
+  //! @param out the buffer
+  //! @param capacity the size of the buffer in characters
+  //! @return the number of characters written, i.e. hex_length()
+  //! @throw std::invalid_argument if the buffer is too small
+  size_t to_hex(char *out, size_t capacity) const;
+
+  //! Parse a hexadecimal (base-16) string, the inverse of to_hex.
+  //! The string consists of an optional leading minus sign (`-`)
+  //! followed by one or more hexadecimal digits in either case.
+  //!
+  //! @param str the hexadecimal string to parse
+  //! @return the BigInt value represented by the string
+  //! @throw std::invalid_argument if the string is not a valid
+  //!        hexadecimal integer
+  static BigInt from_hex(const std::string &str);
+
+  //! Parse `len` characters of hexadecimal digits, like
+  //! from_hex(const std::string&), without needing a std::string.
+  static BigInt from_hex(const char *str, size_t len);
+
   //! Return a string representing the value of this BigInt, in
   //! decimal (base-10). Note that there should be a leading
   //! minus sign (`-`) if this value is negative.
@@ -184,16 +560,108 @@ public:
   //! @return the value of this BigInt object in decimal (base-10)
   std::string to_dec() const;
 
+  //! Parse a decimal (base-10) string, the inverse of to_dec.
+  //! The string consists of an optional leading minus sign (`-`)
+  //! followed by one or more decimal digits.
+  //!
+  //! @param str the decimal string to parse
+  //! @return the BigInt value represented by the string
+  //! @throw std::invalid_argument if the string is not a valid
+  //!        decimal integer
+  static BigInt from_dec(const std::string &str);
+
+  //! Return a string representing the value of this BigInt in any radix
+  //! from 2 to 36, using the digits 0-9 and then lower-case letters, with
+  //! a leading minus sign if the value is negative. Radices that are
+  //! powers of two read digits straight out of the bits; the others
+  //! convert in chunks of digits, splitting large values in half with
+  //! powers of the radix that are cached across calls and threads (see
+  //! RadixPowers).
+  //!
+  //! @param radix the radix
+  //! @return the value of this BigInt object in the given radix
+  //! @throw std::invalid_argument if the radix is not between 2 and 36
+  std::string to_string(unsigned radix) const;
+
+  //! Parse a string in any radix from 2 to 36, the inverse of to_string:
+  //! an optional leading minus sign (`-`) followed by one or more digits,
+  //! with letters in either case.
+  //!
+  //! @param str the string to parse
+  //! @param radix the radix
+  //! @return the BigInt value represented by the string
+  //! @throw std::invalid_argument if the radix is not between 2 and 36,
+  //!        or the string is not a valid integer in that radix
+  static BigInt from_string(const std::string &str, unsigned radix);
+
+  //! @return the number of bytes encode() writes for this value
+  size_t encoded_size() const;
+
+  //! Write this value into a buffer in the binary encoding described
+  //! in bigint_view.h (a sign byte, a varint limb count, then the limbs
+  //! in little-endian order).
+  //!
+  //! @param out the buffer
+  //! @param capacity the size of the buffer in bytes
+  //! @return the number of bytes written, i.e. encoded_size()
+  //! @throw std::invalid_argument if the buffer is too small
+  size_t encode(uint8_t *out, size_t capacity) const;
+
+  //! Read a value written by encode(). The buffer may hold more data
+  //! after the value, such as further encoded values, and needs no
+  //! particular alignment.
+  //!
+  //! @param in the start of the encoded value
+  //! @param size the number of bytes available at `in`
+  //! @param consumed if not null, set to the number of bytes the value takes up
+  //! @return the decoded value
+  //! @throw std::invalid_argument if the encoding is malformed or truncated
+  static BigInt decode(const uint8_t *in, size_t size, size_t *consumed = nullptr);
+
+  //! @return the number of bytes write_sort_key() writes for this value
+  size_t sort_key_size() const;
+
+  //! Write the sort key of this value into a buffer. Keys compare
+  //! bytewise in the same order as the values compare (see bigint_view.h
+  //! for the layout), so they can be radix sorted or stored in any
+  //! ordered byte-string index.
+  //!
+  //! @param out the buffer
+  //! @param capacity the size of the buffer in bytes
+  //! @return the number of bytes written, i.e. sort_key_size()
+  //! @throw std::invalid_argument if the buffer is too small
+  size_t write_sort_key(uint8_t *out, size_t capacity) const;
+
+  //! @return the sort key of this value as a string, which compares in
+  //!         the same order as the values
+  std::string sort_key() const;
+
+  //! Read a value written by write_sort_key(). The buffer may hold more
+  //! data after the key.
+  //!
+  //! @param in the start of the key
+  //! @param size the number of bytes available at `in`
+  //! @param consumed if not null, set to the number of bytes the key takes up
+  //! @return the value
+  //! @throw std::invalid_argument if the key is malformed or truncated
+  static BigInt from_sort_key(const uint8_t *in, size_t size, size_t *consumed = nullptr);
+
+  //! Hash the value from its sign and limbs, without formatting or
+  //! copying it. Equal values always hash equally.
+  //!
+  //! @return the hash
+  size_t hash() const;
+
 
 private:
+  friend class MontgomeryContext;
+
+  //! The operation computed by bitwise().
+  enum class BitwiseOp { AND, OR, XOR };
 
   //! Remove leading zeroes from magnitude vector
   void trim_leading_zeroes();
 
-  //! Divide implicit BigInt (*this) by 2
-  //! @return BigInt quotient of dividing BigInt by 2
-  BigInt div_by_2() const;
-
   //! Method that checks if the BigInt object (*this) is equal to 0
   //! @return true if the BigInt object equals 0, false otherwise
   bool is_zero() const;
@@ -210,17 +678,98 @@ private:
   //! @return true if there are any non-zero indices in the function, false otherwise
   bool has_non_zero() const;
 
+  //! Append the digits of this (non-negative) BigInt in the given radix
+  //! to a string, dividing by the radix's chunk base (e.g. 10^19) so each
+  //! single-limb division yields a whole chunk of digits.
+  //! @param out string to append the digits to
+  //! @param radix the radix, from 2 to 36
+  //! @param pad if nonzero, zero-pad the output to exactly this many digits
+  void append_radix_basecase(std::string &out, unsigned radix, size_t pad) const;
+
+  //! Append the digits of this (non-negative) BigInt in the given radix
+  //! by recursively splitting it into halves with *powers[level - 1].
+  //! @param out string to append the digits to
+  //! @param radix the radix, from 2 to 36
+  //! @param powers cached powers where *powers[k] = chunk^(2^k) (see RadixPowers)
+  //! @param level index such that this value is less than *powers[level]
+  //! @param pad if nonzero, zero-pad the output to exactly this many digits
+  void append_radix_recursive(std::string &out, unsigned radix, const BigInt *const *powers, size_t level, size_t pad) const;
+
+  //! Convert a string of validated digits (no sign) to a BigInt by
+  //! recursively splitting it at a multiple of chunk * 2^k digits.
+  //! @param digits pointer to the first digit
+  //! @param len number of digits
+  //! @param radix the radix, from 2 to 36, not a power of two
+  //! @param powers cached powers where *powers[k] = chunk^(2^k), enough for the largest split
+  //! @return the value of the digits
+  static BigInt from_radix_digits(const char *digits, size_t len, unsigned radix, const BigInt *const *powers);
+
+  //! Apply a bitwise operation to the two's complement forms of two
+  //! values, converting the operands and the result on the fly.
+  //! @param lhs the left operand
+  //! @param rhs the right operand
+  //! @param op the operation
+  //! @return the result
+  static BigInt bitwise(const BigInt &lhs, const BigInt &rhs, BitwiseOp op);
+
+  //! Multiply values[0..count) as a balanced product tree.
+  //! @param values pointer to the first value
+  //! @param count number of values, at least 1
+  //! @return the product of the values
+  static BigInt product_range(const BigInt *values, size_t count);
+
+  //! Shift the magnitude right, ignoring the sign.
+  //! @param n number of bits to shift by
+  //! @return the magnitude divided by 2^n, rounded down
+  BigInt magnitude_shr(size_t n) const;
+
+  //! Newton approximation of the reciprocal of a positive value.
+  //! @param d the value, with b significant bits
+  //! @param k the scale, at least b
+  //! @return an approximation of 2^k / d that is off by at most a few units
+  static BigInt newton_reciprocal(const BigInt &d, size_t k);
+
+  //! Divide non-negative values by multiplying with a Newton reciprocal,
+  //! then correct the quotient by the few units it can be off.
+  //! @param a the dividend, at least as large as `d`
+  //! @param d the divisor, positive
+  //! @return the quotient (first) and remainder (second)
+  static std::pair<BigInt, BigInt> divmod_newton(const BigInt &a, const BigInt &d);
+
+  //! Integer k-th root of a non-negative value by Newton iteration,
+  //! started from the root of the value's top bits.
+  //! @param n the value, non-negative
+  //! @param k the degree of the root, at least 2
+  //! @return the largest r with r^k <= n
+  static BigInt root_newton(const BigInt &n, unsigned k);
+
   // Helper function that compares magnitudes of two BigInt objects
-  int compare_magnitudes(const BigInt &lhs, const BigInt &rhs) const;
+  static int compare_magnitudes(const BigInt &lhs, const BigInt &rhs);
+
+  // Helper function that adds the magnitude of rhs into this object's magnitude
+  void add_magnitudes(const BigInt &rhs);
 
-  // Helper function that adds the magnitudes of two BigInt objects
-  BigInt add_magnitudes(const BigInt &lhs, const BigInt &rhs) const;
+  // Helper function that replaces this object's magnitude with the difference of
+  // the magnitudes, flipping the sign if rhs has the larger magnitude
+  void subtract_magnitudes(const BigInt &rhs);
 
-  // Helper function that subtracts the magnitudes of two BigInt objects
-  BigInt subtract_magnitudes(const BigInt &lhs, const BigInt &rhs) const;
+  // Helper function that adds rhs in place, with rhs_negative used as the sign of rhs
+  void add_signed(const BigInt &rhs, bool rhs_negative);
 
-  BigInt binary_search(const BigInt &lhs, const BigInt &rhs) const;
+  // Helper function that adds the value with magnitude p[0..pn) (normalized)
+  // and sign p_negative in place
+  void add_signed_limbs(const uint64_t *p, size_t pn, bool p_negative);
+
+  // Helper function for dot: the sum of a[i] * b[i] for i in [begin, end)
+  static BigInt dot_range(const BigInt *a, const BigInt *b, size_t begin, size_t end);
 
 };
 
+namespace std {
+  //! Hash of a BigInt, for unordered containers.
+  template<> struct hash<BigInt> {
+    size_t operator()(const BigInt &value) const { return value.hash(); }
+  };
+}
+
 #endif // BIGINT_H
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <stdexcept>
+#include "bigint_batch.h"
+#include "bigint_view.h"
+#include "limb_arena.h"
+#include "limb_ops.h"
+
+typedef unsigned __int128 u128;
+
+//Constructor, all limbs start out zero
+BigIntBatch::BigIntBatch(size_t count, size_t width)
+  : value_count(count), limbs_per_value(width), limbs(count * width, 0) {
+}
+
+BigIntBatch::BigIntBatch(const std::vector<BigInt> &values, size_t width)
+  : BigIntBatch(values.size(), width) {
+  for (size_t j = 0; j < values.size(); ++j) {
+    set(j, values[j]);
+  }
+}
+
+//Negative values are stored as 2^(64 * width) - |value|, i.e. the
+//complement of |value| - 1, computed with a running borrow
+void BigIntBatch::set(size_t index, const BigInt &value) {
+  LimbView magnitude = value.get_bit_vector();
+  bool negative = value.is_negative();
+  uint64_t borrow = negative ? 1 : 0;
+  for (size_t i = 0; i < limbs_per_value; ++i) {
+    uint64_t limb = i < magnitude.size() ? magnitude[i] : 0;
+    if (negative) {
+      uint64_t next_borrow = (limb < borrow);
+      limb = ~(limb - borrow);
+      borrow = next_borrow;
+    }
+    limbs[i * value_count + index] = limb;
+  }
+}
+
+//Gathers the limbs of one value into a view
+BigInt BigIntBatch::get(size_t index) const {
+  LimbScratchScope scratch;
+  uint64_t *value = scratch.allocate(limbs_per_value);
+  for (size_t i = 0; i < limbs_per_value; ++i) {
+    value[i] = limbs[i * value_count + index];
+  }
+  return BigInt(BigIntView(value, limbs_per_value));
+}
+
+std::vector<BigInt> BigIntBatch::to_bigints() const {
+  std::vector<BigInt> values;
+  values.reserve(value_count);
+  for (size_t j = 0; j < value_count; ++j) {
+    values.push_back(get(j));
+  }
+  return values;
+}
+
+//Rows are contiguous, so resizing copies or zero-fills whole rows
+BigIntBatch BigIntBatch::resized(size_t width) const {
+  BigIntBatch result(value_count, width);
+  size_t rows = std::min(width, limbs_per_value);
+  std::copy(limbs.begin(), limbs.begin() + rows * value_count, result.limbs.begin());
+  return result;
+}
+
+void BigIntBatch::check_shape(const BigIntBatch &rhs) const {
+  if (value_count != rhs.value_count || limbs_per_value != rhs.limbs_per_value) {
+    throw std::invalid_argument("Batches differ in size or width");
+  }
+}
+
+BigIntBatch BigIntBatch::operator+(const BigIntBatch &rhs) const {
+  BigIntBatch result(*this);
+  result += rhs;
+  return result;
+}
+
+BigIntBatch BigIntBatch::operator-(const BigIntBatch &rhs) const {
+  BigIntBatch result(*this);
+  result -= rhs;
+  return result;
+}
+
+BigIntBatch BigIntBatch::operator*(const BigIntBatch &rhs) const {
+  check_shape(rhs);
+  BigIntBatch result(value_count, limbs_per_value);
+  mul_into(result, *this, rhs);
+  return result;
+}
+
+BigIntBatch &BigIntBatch::operator+=(const BigIntBatch &rhs) {
+  check_shape(rhs);
+  limb_batch_add(limbs.data(), limbs.data(), rhs.limbs.data(), limbs_per_value, value_count);
+  return *this;
+}
+
+BigIntBatch &BigIntBatch::operator-=(const BigIntBatch &rhs) {
+  check_shape(rhs);
+  limb_batch_sub(limbs.data(), limbs.data(), rhs.limbs.data(), limbs_per_value, value_count);
+  return *this;
+}
+
+BigIntBatch &BigIntBatch::operator*=(const BigIntBatch &rhs) {
+  *this = *this * rhs;
+  return *this;
+}
+
+BigIntBatch BigIntBatch::mul_full(const BigIntBatch &rhs) const {
+  if (value_count != rhs.value_count) {
+    throw std::invalid_argument("Batches differ in size");
+  }
+  BigIntBatch result(value_count, limbs_per_value + rhs.limbs_per_value);
+  mul_into(result, *this, rhs);
+  return result;
+}
+
+//Schoolbook multiplication with the values in the innermost loop: each
+//step multiplies a row of a by a row of b and adds into a row of r, so
+//every access is sequential. Partial products above the result width
+//are skipped.
+void BigIntBatch::mul_into(BigIntBatch &r, const BigIntBatch &a, const BigIntBatch &b) {
+  size_t count = r.value_count;
+  LimbScratchScope scratch;
+  uint64_t *carry = scratch.allocate(count);
+
+  for (size_t i = 0; i < a.limbs_per_value && i < r.limbs_per_value; ++i) {
+    std::fill(carry, carry + count, 0);
+    const uint64_t *x = a.limb_row(i);
+    size_t k = 0;
+    for (; k < b.limbs_per_value && i + k < r.limbs_per_value; ++k) {
+      const uint64_t *y = b.limb_row(k);
+      uint64_t *z = r.limb_row(i + k);
+      for (size_t j = 0; j < count; ++j) {
+        u128 t = (u128) x[j] * y[j] + z[j] + carry[j];
+        z[j] = (uint64_t) t;
+        carry[j] = (uint64_t) (t >> 64);
+      }
+    }
+    if (i + k < r.limbs_per_value) {
+      std::copy(carry, carry + count, r.limb_row(i + k));
+    }
+  }
+}
+
+std::vector<int> BigIntBatch::compare(const BigIntBatch &rhs) const {
+  check_shape(rhs);
+  std::vector<int> result(value_count);
+  limb_batch_cmp(result.data(), limbs.data(), rhs.limbs.data(), limbs_per_value, value_count);
+  return result;
+}
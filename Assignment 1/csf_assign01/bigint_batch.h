@@ -0,0 +1,110 @@
+#ifndef BIGINT_BATCH_H
+#define BIGINT_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bigint.h"
+
+//! @file
+//! Structure-of-arrays storage for many integers of the same width.
+
+//! A fixed number of unsigned integers of `width` limbs each, stored
+//! limb-major: limb 0 of every value, then limb 1 of every value, and so
+//! on. Element-wise operations on two batches walk both arrays in order
+//! and handle several values per vector instruction (see limb_batch_add),
+//! with no per-value allocation or dispatch.
+//!
+//! Like FixedInt, arithmetic wraps around modulo `2^(64 * width)`, and
+//! negative values become their two's complement when stored. Use
+//! mul_full, or a batch wide enough for the results, when products or
+//! sums must not wrap.
+class BigIntBatch {
+private:
+  size_t value_count;
+  size_t limbs_per_value;
+  std::vector<uint64_t> limbs; // limb i of value j at [i * value_count + j]
+
+public:
+  //! Constructor: `count` values of `width` limbs, all 0.
+  //!
+  //! @param count the number of values
+  //! @param width the number of limbs per value
+  BigIntBatch(size_t count, size_t width);
+
+  //! Constructor from BigInt values. Values that do not fit in `width`
+  //! limbs are reduced modulo `2^(64 * width)`.
+  //!
+  //! @param values the values
+  //! @param width the number of limbs per value
+  BigIntBatch(const std::vector<BigInt> &values, size_t width);
+
+  //! @return the number of values
+  size_t size() const { return value_count; }
+
+  //! @return the number of limbs per value
+  size_t width() const { return limbs_per_value; }
+
+  //! Store a value, reduced modulo `2^(64 * width)`.
+  //!
+  //! @param index the index of the value to replace
+  //! @param value the new value
+  void set(size_t index, const BigInt &value);
+
+  //! @param index the index of a value
+  //! @return the value as a (non-negative) BigInt
+  BigInt get(size_t index) const;
+
+  //! @return all values as (non-negative) BigInts
+  std::vector<BigInt> to_bigints() const;
+
+  //! Access one limb of every value, for callers with their own kernels.
+  //!
+  //! @param i the limb index (0 for the least significant limb)
+  //! @return pointer to limb `i` of value 0; limb `i` of value `j` is at index `j`
+  uint64_t *limb_row(size_t i) { return limbs.data() + i * value_count; }
+  const uint64_t *limb_row(size_t i) const { return limbs.data() + i * value_count; }
+
+  //! Copy the values into a batch of another width, zero-extending or
+  //! truncating each value.
+  //!
+  //! @param width the new number of limbs per value
+  //! @return the resized batch
+  BigIntBatch resized(size_t width) const;
+
+  //! Element-wise operators. Both batches must have the same size and
+  //! width; results wrap around modulo `2^(64 * width)`.
+  //!
+  //! @throw std::invalid_argument if the batches differ in size or width
+  BigIntBatch operator+(const BigIntBatch &rhs) const;
+  BigIntBatch operator-(const BigIntBatch &rhs) const;
+  BigIntBatch operator*(const BigIntBatch &rhs) const;
+  BigIntBatch &operator+=(const BigIntBatch &rhs);
+  BigIntBatch &operator-=(const BigIntBatch &rhs);
+  BigIntBatch &operator*=(const BigIntBatch &rhs);
+
+  //! Element-wise full product, which never wraps.
+  //!
+  //! @param rhs a batch with the same number of values (any width)
+  //! @return the products, with `width() + rhs.width()` limbs per value
+  //! @throw std::invalid_argument if the batches differ in size
+  BigIntBatch mul_full(const BigIntBatch &rhs) const;
+
+  //! Element-wise comparison.
+  //!
+  //! @param rhs a batch of the same size and width
+  //! @return for each value, -1, 0 or 1 if it is less than, equal to or
+  //!         greater than the value at the same index in `rhs`
+  //! @throw std::invalid_argument if the batches differ in size or width
+  std::vector<int> compare(const BigIntBatch &rhs) const;
+
+private:
+  //! @throw std::invalid_argument unless `rhs` has the same size and width
+  void check_shape(const BigIntBatch &rhs) const;
+
+  //! Set `r` to the element-wise products of `a` and `b` modulo
+  //! `2^(64 * r.width())`. `r` must be all zeroes and not alias `a` or `b`.
+  static void mul_into(BigIntBatch &r, const BigIntBatch &a, const BigIntBatch &b);
+};
+
+#endif // BIGINT_BATCH_H
@@ -0,0 +1,853 @@
+// Benchmark for BigInt multiplication.
+//
+// Times schoolbook, Karatsuba, Toom-3 and NTT multiplication of random
+// n-limb operands and reports the cost in nanoseconds per limb^2,
+// so that the crossover sizes used for limb_karatsuba_threshold,
+// limb_toom3_threshold and limb_ntt_threshold can be read off the
+// table rather than guessed.
+//
+// With the argument "alloc" it instead counts heap allocations per
+// BigInt operation with the scratch arena turned off and on, and with
+// "modpow" it reports modular exponentiations per second. "threads"
+// measures how multiplication and product trees scale from 1 to
+// max_threads threads (default: the number of hardware threads). "div"
+// compares long division with Newton division of a 2n-limb value by an
+// n-limb value, for reading off limb_newton_threshold, and "gcd" does the
+// same for limb_lehmer_threshold with binary GCD and Lehmer's algorithm,
+// next to the time of extended_gcd.
+// "sqr" compares squaring with multiplication of two different operands
+// and reads off limb_sqr_karatsuba_threshold. "prime" reports how many
+// random odd candidates per second is_probable_prime gets through, and
+// the time of next_prime and of one Baillie-PSW test of a prime. "dot"
+// compares sum += a[i] * b[i] with addmul and with BigInt::dot on 1 to
+// max_threads threads.
+// "sort" deduplicates a million values, a quarter of them repeats, by
+// sorting with compare, by radix sorting their sort keys, and with a
+// std::unordered_set using std::hash<BigInt>.
+// "io" compares the binary encoding with hex and decimal strings for
+// saving and loading values. "batch" compares element-wise arithmetic on BigIntBatch with
+// the same operations on vectors of BigInt, and the vector batch kernels
+// with the portable ones.
+//
+// "suite" is the regression suite: it times add, sub, mul, div, shifts,
+// compare, to_hex and to_dec for operands of 1 to max_limbs limbs
+// (default 2^20, about a million) and writes one row per operation and
+// size as CSV or JSON. Given a baseline CSV from an earlier run, it also
+// prints the ratio to the baseline for every row to stderr, marks rows
+// that got slower by more than the tolerance (default 10%), and exits
+// with status 1 if there are any, so it can gate a build.
+//
+// Usage: ./bigint_bench [max_limbs]
+//        ./bigint_bench alloc
+//        ./bigint_bench modpow
+//        ./bigint_bench threads [max_threads]
+//        ./bigint_bench div [max_limbs]
+//        ./bigint_bench gcd [max_limbs]
+//        ./bigint_bench sqr [max_limbs]
+//        ./bigint_bench prime
+//        ./bigint_bench dot [max_threads]
+//        ./bigint_bench sort
+//        ./bigint_bench io
+//        ./bigint_bench batch
+//        ./bigint_bench suite [--max-limbs N] [--format csv|json]
+//                             [--baseline FILE.csv] [--tolerance PERCENT]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "bigint.h"
+#include "bigint_batch.h"
+#include "bigint_view.h"
+#include "limb_arena.h"
+#include "limb_ops.h"
+
+// Every heap allocation in the program goes through these, so the
+// allocation benchmark can count them
+static size_t allocation_count = 0;
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+// Deterministic xorshift generator so runs are comparable
+uint64_t rng_state = 0x9e3779b97f4a7c15UL;
+
+uint64_t next_random() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+std::vector<uint64_t> random_limbs(size_t n) {
+  std::vector<uint64_t> limbs(n);
+  for (size_t i = 0; i < n; ++i) {
+    limbs[i] = next_random();
+  }
+  limbs[n - 1] |= 1; // keep the top limb nonzero
+  return limbs;
+}
+
+// Returns the average time in nanoseconds of one n x n limb_mul call
+// with the given thresholds in effect
+double time_mul(size_t n, size_t karatsuba_threshold, size_t toom3_threshold, size_t ntt_threshold) {
+  size_t saved_karatsuba = limb_karatsuba_threshold;
+  size_t saved_toom3 = limb_toom3_threshold;
+  size_t saved_ntt = limb_ntt_threshold;
+  limb_karatsuba_threshold = karatsuba_threshold;
+  limb_toom3_threshold = toom3_threshold;
+  limb_ntt_threshold = ntt_threshold;
+
+  std::vector<uint64_t> a = random_limbs(n);
+  std::vector<uint64_t> b = random_limbs(n);
+  std::vector<uint64_t> r(2 * n);
+
+  // Repeat until at least 50ms has elapsed so small sizes are measurable
+  using clock = std::chrono::steady_clock;
+  unsigned iterations = 0;
+  clock::time_point start = clock::now();
+  clock::duration elapsed;
+  do {
+    limb_mul(r.data(), a.data(), n, b.data(), n);
+    ++iterations;
+    elapsed = clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(50));
+
+  limb_karatsuba_threshold = saved_karatsuba;
+  limb_toom3_threshold = saved_toom3;
+  limb_ntt_threshold = saved_ntt;
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+BigInt random_bigint(size_t n) {
+  std::vector<uint64_t> limbs = random_limbs(n);
+  return BigInt(BigIntView(limbs.data(), n));
+}
+
+// Runs op repeatedly for at least 50ms and prints the heap allocations
+// and time per call
+template<typename Op>
+void report_allocations(const char *name, Op op) {
+  op(); // warm up, so the arena already holds its chunks
+
+  using clock = std::chrono::steady_clock;
+  size_t allocations_before = allocation_count;
+  unsigned iterations = 0;
+  clock::time_point start = clock::now();
+  clock::duration elapsed;
+  do {
+    op();
+    ++iterations;
+    elapsed = clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(50));
+
+  double allocations = double(allocation_count - allocations_before) / iterations;
+  double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+  std::printf("  %-28s %12.1f %12.2f\n", name, allocations, us);
+}
+
+// Compares heap allocations per operation with the arena off and on
+void run_allocation_bench() {
+  BigInt a64 = random_bigint(64), b64 = random_bigint(64);
+  BigInt a1k = random_bigint(1024), b1k = random_bigint(1024);
+  BigInt n2k = random_bigint(2048), d1k = random_bigint(1000);
+  BigInt c64 = random_bigint(64);
+
+  for (int enabled = 0; enabled <= 1; ++enabled) {
+    LimbArena::set_enabled(enabled);
+    std::printf("arena %s\n", enabled ? "on" : "off");
+    std::printf("  %-28s %12s %12s\n", "operation", "allocs/op", "us/op");
+    report_allocations("mul 64x64 (karatsuba)", [&] { BigInt r = a64 * b64; });
+    report_allocations("mul 1024x1024 (toom-3)", [&] { BigInt r = a1k * b1k; });
+    report_allocations("divmod 2048/1000", [&] { std::pair<BigInt, BigInt> r = n2k.divmod(d1k); });
+    report_allocations("to_dec 1024", [&] { std::string r = a1k.to_dec(); });
+    report_allocations("a + b * c (64 limbs)", [&] { BigInt r = a64 + b64 * c64; });
+  }
+}
+
+// Prints modpow throughput for odd moduli of RSA sizes, with the
+// public exponent 65537 and with a full-length exponent
+void run_modpow_bench() {
+  std::printf("%8s %12s %12s %12s\n", "bits", "exponent", "us/op", "ops/s");
+  for (size_t bits : { 1024, 2048, 3072, 4096 }) {
+    size_t n = bits / 64;
+    BigInt modulus = random_bigint(n);
+    if (!modulus.is_bit_set(0)) {
+      modulus += BigInt(1);
+    }
+    BigInt base = random_bigint(n - 1);
+    BigInt full_exponent = random_bigint(n);
+
+    for (int full = 0; full <= 1; ++full) {
+      const BigInt exponent = full ? full_exponent : BigInt(65537);
+      using clock = std::chrono::steady_clock;
+      unsigned iterations = 0;
+      clock::time_point start = clock::now();
+      clock::duration elapsed;
+      do {
+        BigInt r = base.modpow(exponent, modulus);
+        ++iterations;
+        elapsed = clock::now() - start;
+      } while (elapsed < std::chrono::milliseconds(200));
+
+      double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+      std::printf("%8zu %12s %12.1f %12.0f\n", bits, full ? "full" : "65537", us, 1e6 / us);
+    }
+  }
+}
+
+// Returns the average time in milliseconds of op, run at least 3 times
+template<typename Op>
+double time_ms(Op op) {
+  using clock = std::chrono::steady_clock;
+  unsigned iterations = 0;
+  clock::time_point start = clock::now();
+  clock::duration elapsed;
+  do {
+    op();
+    ++iterations;
+    elapsed = clock::now() - start;
+  } while (iterations < 3 || elapsed < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::milli>(elapsed).count() / iterations;
+}
+
+// Prints the time and speedup over one thread of a large multiplication
+// and of a product tree, for 1 to max_threads threads
+void run_thread_bench(unsigned max_threads) {
+  BigInt a = random_bigint(32768), b = random_bigint(32768);
+  std::vector<BigInt> factors;
+  for (size_t i = 0; i < 8192; ++i) {
+    factors.push_back(random_bigint(8));
+  }
+
+  std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+  std::printf("%8s %14s %9s %14s %9s\n", "threads", "mul 32k ms", "speedup", "tree 8k ms", "speedup");
+  double base_mul = 0, base_tree = 0;
+  for (unsigned threads = 1; threads <= max_threads; ++threads) {
+    limb_mul_threads = threads;
+    double mul = time_ms([&] { BigInt r = a * b; });
+    double tree = time_ms([&] { BigInt r = BigInt::product(factors); });
+    if (threads == 1) {
+      base_mul = mul;
+      base_tree = tree;
+    }
+    std::printf("%8u %14.1f %9.2f %14.1f %9.2f\n", threads, mul, base_mul / mul, tree, base_tree / tree);
+  }
+  limb_mul_threads = 1;
+}
+
+// Prints the time of dividing 2n limbs by n limbs with long division and
+// with Newton division; the threshold is where "newton" first wins
+void run_div_bench(size_t max_limbs) {
+  size_t saved_newton = limb_newton_threshold;
+  std::printf("current threshold: newton=%zu\n", limb_newton_threshold);
+  std::printf("%8s %14s %14s\n", "limbs", "long ms", "newton ms");
+  for (size_t n = 128; n <= max_limbs; n = n * 3 / 2) {
+    BigInt a = random_bigint(2 * n), d = random_bigint(n);
+    limb_newton_threshold = SIZE_MAX;
+    double long_div = time_ms([&] { BigInt q = a / d; });
+    limb_newton_threshold = 1;
+    double newton = time_ms([&] { BigInt q = a / d; });
+    std::printf("%8zu %14.2f %14.2f\n", n, long_div, newton);
+  }
+  limb_newton_threshold = saved_newton;
+}
+
+// Prints the time of a gcd of two n-limb values with binary GCD alone,
+// with Lehmer steps, and with plain Euclid remainders for comparison;
+// limb_lehmer_threshold is where "lehmer" first beats "binary"
+void run_gcd_bench(size_t max_limbs) {
+  size_t saved_lehmer = limb_lehmer_threshold;
+  std::printf("current threshold: lehmer=%zu\n", limb_lehmer_threshold);
+  std::printf("%8s %14s %14s %14s %14s\n", "limbs", "binary us", "lehmer us", "euclid us", "extgcd us");
+  for (size_t n = 1; n <= max_limbs; n = n < 8 ? n + 1 : n * 2) {
+    BigInt a = random_bigint(n), b = random_bigint(n);
+    limb_lehmer_threshold = SIZE_MAX;
+    double binary = time_ms([&] { BigInt g = a.gcd(b); });
+    limb_lehmer_threshold = 3;
+    double lehmer = time_ms([&] { BigInt g = a.gcd(b); });
+    double euclid = time_ms([&] {
+      BigInt x = a, y = b;
+      while (y != BigInt()) {
+        BigInt r = x % y;
+        x = std::move(y);
+        y = std::move(r);
+      }
+    });
+    limb_lehmer_threshold = saved_lehmer;
+    double extended = time_ms([&] {
+      BigInt x, y;
+      BigInt g = a.extended_gcd(b, x, y);
+    });
+    std::printf("%8zu %14.3f %14.3f %14.3f %14.3f\n", n, binary * 1000, lehmer * 1000, euclid * 1000, extended * 1000);
+  }
+  limb_lehmer_threshold = saved_lehmer;
+}
+
+// Prints the time of an n x n product, and of squaring n limbs with
+// schoolbook squaring alone, one level of Karatsuba and the current
+// thresholds; limb_sqr_karatsuba_threshold is where "kara 1lvl" first
+// beats "schoolbook"
+void run_sqr_bench(size_t max_limbs) {
+  size_t saved_sqr = limb_sqr_karatsuba_threshold;
+  std::printf("current threshold: sqr_karatsuba=%zu\n", limb_sqr_karatsuba_threshold);
+  std::printf("%8s %12s %12s %12s %12s %8s\n", "limbs", "mul us", "schoolbook", "kara 1lvl", "auto", "sqr/mul");
+  for (size_t n = 4; n <= max_limbs; n = n < 16 ? n + 4 : n * 3 / 2) {
+    std::vector<uint64_t> a = random_limbs(n), b = random_limbs(n), r(2 * n);
+    double mul = time_ms([&] { limb_mul(r.data(), a.data(), n, b.data(), n); });
+    limb_sqr_karatsuba_threshold = SIZE_MAX;
+    double school = time_ms([&] { limb_sqr(r.data(), a.data(), n); });
+    limb_sqr_karatsuba_threshold = n;
+    double karatsuba_top = time_ms([&] { limb_sqr(r.data(), a.data(), n); });
+    limb_sqr_karatsuba_threshold = saved_sqr;
+    double automatic = time_ms([&] { limb_sqr(r.data(), a.data(), n); });
+    std::printf("%8zu %12.3f %12.3f %12.3f %12.3f %8.2f\n", n, mul * 1000, school * 1000,
+                karatsuba_top * 1000, automatic * 1000, automatic / mul);
+  }
+}
+
+// Prints the time per pair of summing products with a temporary per
+// product, with addmul, and with BigInt::dot on a growing number of
+// threads, for a million pairs of small values and fewer larger ones
+void run_dot_bench(unsigned max_threads) {
+  unsigned saved_threads = limb_mul_threads;
+  size_t shapes[][2] = { {1000000, 1}, {1000000, 2}, {100000, 8}, {10000, 64} };
+  std::printf("%8s %8s %12s %12s", "pairs", "limbs", "a*b ns", "addmul ns");
+  for (unsigned t = 1; t <= max_threads; t *= 2) {
+    char label[32];
+    std::snprintf(label, sizeof(label), "dot ns t=%u", t);
+    std::printf(" %12s", label);
+  }
+  std::printf("\n");
+  for (auto &shape : shapes) {
+    size_t count = shape[0], limbs = shape[1];
+    std::vector<BigInt> a, b;
+    for (size_t i = 0; i < count; ++i) {
+      a.push_back(random_bigint(limbs));
+      b.push_back(i % 3 == 0 ? -random_bigint(limbs) : random_bigint(limbs));
+    }
+    double naive = time_ms([&] {
+      BigInt sum;
+      for (size_t i = 0; i < count; ++i) {
+        sum += a[i] * b[i];
+      }
+    });
+    double fused = time_ms([&] {
+      BigInt sum;
+      for (size_t i = 0; i < count; ++i) {
+        sum.addmul(a[i], b[i]);
+      }
+    });
+    std::printf("%8zu %8zu %12.2f %12.2f", count, limbs, naive * 1e6 / count, fused * 1e6 / count);
+    for (unsigned t = 1; t <= max_threads; t *= 2) {
+      limb_mul_threads = t;
+      double dot = time_ms([&] { BigInt sum = BigInt::dot(a, b); });
+      std::printf(" %12.2f", dot * 1e6 / count);
+    }
+    std::printf("\n");
+  }
+  limb_mul_threads = saved_threads;
+}
+
+// Prints primality test throughput on random odd candidates, which
+// are mostly settled by trial division, and the cost of the sieved
+// next_prime search and of a full test of a prime, for 256- to
+// 4096-bit values
+void run_prime_bench() {
+  RandomSource random = next_random;
+  std::printf("%8s %16s %14s %14s\n", "bits", "candidates/s", "next_prime ms", "prime test ms");
+  for (size_t bits = 256; bits <= 4096; bits *= 2) {
+    const size_t COUNT = 1000;
+    std::vector<BigInt> candidates;
+    for (size_t i = 0; i < COUNT; ++i) {
+      BigInt c = BigInt::random_bits(bits, random) | (BigInt(1) << unsigned(bits - 1)) | BigInt(1);
+      candidates.push_back(c);
+    }
+    double test = time_ms([&] {
+      for (const BigInt &c : candidates) {
+        c.is_probable_prime();
+      }
+    });
+    BigInt start = candidates[0];
+    BigInt prime;
+    double search = time_ms([&] { prime = start.next_prime(); });
+    double full = time_ms([&] { prime.is_probable_prime(); });
+    std::printf("%8zu %16.0f %14.3f %14.3f\n", bits, COUNT / test * 1000, search, full);
+  }
+}
+
+// Prints the time per value of writing and reading back values of
+// several sizes as binary encodings and as decimal strings
+void run_io_bench() {
+  std::printf("%8s %12s %12s %12s %12s %12s %12s\n", "limbs", "encode us", "decode us", "to_hex us", "from_hex us", "to_dec us", "from_dec us");
+  for (size_t n : { 1, 4, 16, 64, 256, 1024 }) {
+    const size_t COUNT = 256;
+    std::vector<BigInt> values;
+    for (size_t i = 0; i < COUNT; ++i) {
+      values.push_back(random_bigint(n));
+    }
+
+    size_t total = 0;
+    for (const BigInt &value : values) {
+      total += value.encoded_size();
+    }
+    std::vector<uint8_t> buf(total);
+    std::vector<std::string> strings(COUNT);
+    double encode = time_ms([&] {
+      size_t pos = 0;
+      for (const BigInt &value : values) {
+        pos += value.encode(buf.data() + pos, buf.size() - pos);
+      }
+    });
+    double decode = time_ms([&] {
+      size_t pos = 0, consumed;
+      for (size_t i = 0; i < COUNT; ++i) {
+        BigInt value = BigInt::decode(buf.data() + pos, buf.size() - pos, &consumed);
+        pos += consumed;
+      }
+    });
+    std::vector<char> text(COUNT * (16 * n + 1));
+    std::vector<size_t> hex_lengths(COUNT);
+    double to_hex = time_ms([&] {
+      size_t pos = 0;
+      for (size_t i = 0; i < COUNT; ++i) {
+        hex_lengths[i] = values[i].to_hex(text.data() + pos, text.size() - pos);
+        pos += hex_lengths[i];
+      }
+    });
+    double from_hex = time_ms([&] {
+      size_t pos = 0;
+      for (size_t i = 0; i < COUNT; ++i) {
+        BigInt value = BigInt::from_hex(text.data() + pos, hex_lengths[i]);
+        pos += hex_lengths[i];
+      }
+    });
+    double to_dec = time_ms([&] {
+      for (size_t i = 0; i < COUNT; ++i) {
+        strings[i] = values[i].to_dec();
+      }
+    });
+    double from_dec = time_ms([&] {
+      for (const std::string &str : strings) {
+        BigInt value = BigInt::from_dec(str);
+      }
+    });
+    double scale = 1000.0 / COUNT; // ms per batch to us per value
+    std::printf("%8zu %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n", n, encode * scale, decode * scale,
+                to_hex * scale, from_hex * scale, to_dec * scale, from_dec * scale);
+  }
+}
+
+// A sort key stored in a shared buffer
+struct SortKey {
+  const uint8_t *bytes;
+  size_t size;
+
+  bool operator<(const SortKey &rhs) const {
+    int cmp = std::memcmp(bytes, rhs.bytes, std::min(size, rhs.size));
+    return cmp < 0 || (cmp == 0 && size < rhs.size);
+  }
+  bool operator==(const SortKey &rhs) const {
+    return size == rhs.size && std::memcmp(bytes, rhs.bytes, size) == 0;
+  }
+};
+
+// MSD radix sort of the n keys at keys, which agree on their first depth
+// bytes; bucket 0 holds the keys that end at depth. Bytes that all the
+// keys share, such as most of the limb count, are skipped without moving
+// anything
+void radix_sort_keys(SortKey *keys, size_t n, size_t depth, SortKey *tmp) {
+  while (n >= 64) {
+    size_t start[258] = { 0 };
+    for (size_t i = 0; i < n; ++i) {
+      ++start[(keys[i].size > depth ? 1 + keys[i].bytes[depth] : 0) + 1];
+    }
+    size_t first = 0;
+    while (start[first + 1] == 0) {
+      ++first;
+    }
+    if (start[first + 1] == n) {
+      if (first == 0) {
+        return; // all the keys are equal
+      }
+      ++depth;
+      continue;
+    }
+    for (size_t b = 1; b < 258; ++b) {
+      start[b] += start[b - 1];
+    }
+    size_t next[257];
+    std::copy(start, start + 257, next);
+    for (size_t i = 0; i < n; ++i) {
+      tmp[next[keys[i].size > depth ? 1 + keys[i].bytes[depth] : 0]++] = keys[i];
+    }
+    std::copy(tmp, tmp + n, keys);
+    for (size_t b = 1; b < 257; ++b) {
+      if (start[b + 1] - start[b] > 1) {
+        radix_sort_keys(keys + start[b], start[b + 1] - start[b], depth + 1, tmp);
+      }
+    }
+    return;
+  }
+  std::sort(keys, keys + n);
+}
+
+// Prints the time to deduplicate values of 1 to 4 limbs, both signs,
+// where every fourth value repeats an earlier one
+void run_sort_bench() {
+  const size_t COUNT = 1 << 20;
+  std::vector<BigInt> values;
+  values.reserve(COUNT);
+  for (size_t i = 0; i < COUNT; ++i) {
+    if (i % 4 == 3) {
+      values.push_back(values[next_random() % i]);
+      continue;
+    }
+    BigInt value = random_bigint(1 + next_random() % 4);
+    values.push_back(next_random() % 2 ? -value : value);
+  }
+
+  size_t unique = 0;
+  double compare_sort = time_ms([&] {
+    std::vector<BigInt> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    unique = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+  });
+  double key_sort = time_ms([&] {
+    size_t total = 0;
+    for (const BigInt &value : values) {
+      total += value.sort_key_size();
+    }
+    std::vector<uint8_t> buf(total);
+    std::vector<SortKey> keys(COUNT), tmp(COUNT);
+    size_t pos = 0;
+    for (size_t i = 0; i < COUNT; ++i) {
+      size_t size = values[i].write_sort_key(buf.data() + pos, buf.size() - pos);
+      keys[i] = { buf.data() + pos, size };
+      pos += size;
+    }
+    radix_sort_keys(keys.data(), COUNT, 0, tmp.data());
+    unique = std::unique(keys.begin(), keys.end()) - keys.begin();
+  });
+  double hash_set = time_ms([&] {
+    std::unordered_set<BigInt> seen(values.begin(), values.end());
+    unique = seen.size();
+  });
+  std::printf("%zu values, %zu unique\n", COUNT, unique);
+  std::printf("%-28s %10.1f ms\n", "std::sort with compare", compare_sort);
+  std::printf("%-28s %10.1f ms\n", "radix sort of sort keys", key_sort);
+  std::printf("%-28s %10.1f ms\n", "unordered_set<BigInt>", hash_set);
+}
+
+// Prints the time per element of adding, multiplying and comparing
+// 65536 pairs of 128- and 256-bit values
+void run_batch_bench() {
+  const size_t COUNT = 65536;
+  std::printf("kernels: %s\n", limb_kernel_name());
+  std::printf("%6s %-10s %14s %14s %14s\n", "bits", "op", "BigInt ns", "portable ns", "batch ns");
+  for (size_t width : { 2, 4 }) {
+    std::vector<BigInt> left, right, out(COUNT);
+    for (size_t j = 0; j < COUNT; ++j) {
+      left.push_back(random_bigint(width));
+      right.push_back(random_bigint(width));
+    }
+    BigIntBatch a(left, width), b(right, width);
+    std::vector<int> order(COUNT);
+
+    auto report = [&](const char *name, double bigint_ms, auto batch_op) {
+      limb_use_portable_kernels(true);
+      double portable_ms = time_ms(batch_op);
+      limb_use_portable_kernels(false);
+      double batch_ms = time_ms(batch_op);
+      double scale = 1e6 / COUNT; // ms per batch to ns per element
+      std::printf("%6zu %-10s %14.2f %14.2f %14.2f\n", 64 * width, name, bigint_ms * scale, portable_ms * scale, batch_ms * scale);
+    };
+    report("add", time_ms([&] { for (size_t j = 0; j < COUNT; ++j) out[j] = left[j] + right[j]; }),
+           [&] { BigIntBatch r = a + b; });
+    report("sub", time_ms([&] { for (size_t j = 0; j < COUNT; ++j) out[j] = left[j] - right[j]; }),
+           [&] { BigIntBatch r = a - b; });
+    report("mul", time_ms([&] { for (size_t j = 0; j < COUNT; ++j) out[j] = left[j] * right[j]; }),
+           [&] { BigIntBatch r = a.mul_full(b); });
+    report("compare", time_ms([&] { for (size_t j = 0; j < COUNT; ++j) order[j] = left[j].compare(right[j]); }),
+           [&] { order = a.compare(b); });
+  }
+}
+
+// One measurement of the regression suite
+struct SuiteResult {
+  std::string op;
+  size_t limbs;
+  double ns;
+};
+
+// Returns the median time in nanoseconds of op over as many runs as fit
+// in about 100ms (at least 3, or 1 for operations slower than that).
+// The median keeps one slow run from looking like a regression.
+template<typename Op>
+double median_ns(Op op) {
+  using clock = std::chrono::steady_clock;
+  std::vector<double> runs;
+  clock::time_point start = clock::now();
+  do {
+    // Batch fast operations so each sample is long enough to time
+    unsigned batch = runs.empty() ? 1 : unsigned(std::min(1e6, std::max(1.0, 1e5 / runs[0])));
+    clock::time_point run_start = clock::now();
+    for (unsigned i = 0; i < batch; ++i) {
+      op();
+    }
+    runs.push_back(std::chrono::duration<double, std::nano>(clock::now() - run_start).count() / batch);
+    if (runs.size() == 1 && runs[0] > 1e8) {
+      break;
+    }
+  } while (runs.size() < 3 || clock::now() - start < std::chrono::milliseconds(100));
+
+  std::sort(runs.begin(), runs.end());
+  return runs[runs.size() / 2];
+}
+
+// Times every operation at sizes 1, 4, 16, ... limbs up to max_limbs
+std::vector<SuiteResult> run_suite(size_t max_limbs) {
+  std::vector<SuiteResult> results;
+  for (size_t n = 1; n <= max_limbs; n *= 4) {
+    BigInt a = random_bigint(n), b = random_bigint(n), a_copy = a;
+    BigInt dividend = random_bigint(2 * n);
+
+    std::pair<const char *, double> timings[] = {
+      { "add", median_ns([&] { BigInt r = a + b; }) },
+      { "sub", median_ns([&] { BigInt r = a - b; }) },
+      { "mul", median_ns([&] { BigInt r = a * b; }) },
+      { "div", median_ns([&] { BigInt r = dividend / b; }) },
+      { "lshift", median_ns([&] { BigInt r = a << 37; }) },
+      { "rshift", median_ns([&] { BigInt r = a >> 37; }) },
+      { "compare", median_ns([&] { volatile int r = a.compare(a_copy); (void) r; }) },
+      { "to_hex", median_ns([&] { std::string r = a.to_hex(); }) },
+      { "to_dec", median_ns([&] { std::string r = a.to_dec(); }) },
+    };
+    for (const auto &timing : timings) {
+      results.push_back(SuiteResult{ timing.first, n, timing.second });
+      std::fprintf(stderr, "%-8s %8zu limbs %16.1f ns\n", timing.first, n, timing.second);
+    }
+  }
+  return results;
+}
+
+void write_csv(const std::vector<SuiteResult> &results) {
+  std::printf("op,limbs,ns_per_op\n");
+  for (const SuiteResult &r : results) {
+    std::printf("%s,%zu,%.1f\n", r.op.c_str(), r.limbs, r.ns);
+  }
+}
+
+void write_json(const std::vector<SuiteResult> &results) {
+  std::printf("{\n  \"kernels\": \"%s\",\n  \"results\": [\n", limb_kernel_name());
+  for (size_t i = 0; i < results.size(); ++i) {
+    std::printf("    { \"op\": \"%s\", \"limbs\": %zu, \"ns_per_op\": %.1f }%s\n",
+                results[i].op.c_str(), results[i].limbs, results[i].ns, i + 1 < results.size() ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+}
+
+// Reads a baseline written with --format csv, keyed by operation and size
+std::map<std::pair<std::string, size_t>, double> read_baseline(const char *path) {
+  std::map<std::pair<std::string, size_t>, double> baseline;
+  std::ifstream in(path);
+  if (!in) {
+    std::fprintf(stderr, "cannot read baseline %s\n", path);
+    std::exit(2);
+  }
+  std::string line;
+  std::getline(in, line); // header
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string op, limbs, ns;
+    if (std::getline(fields, op, ',') && std::getline(fields, limbs, ',') && std::getline(fields, ns)) {
+      baseline[std::make_pair(op, std::strtoul(limbs.c_str(), nullptr, 10))] = std::strtod(ns.c_str(), nullptr);
+    }
+  }
+  return baseline;
+}
+
+// Prints every result next to its baseline and returns the number of
+// results that are slower than the baseline by more than tolerance
+size_t compare_with_baseline(const std::vector<SuiteResult> &results, const char *path, double tolerance) {
+  std::map<std::pair<std::string, size_t>, double> baseline = read_baseline(path);
+  size_t regressions = 0;
+  std::fprintf(stderr, "\n%-8s %8s %16s %16s %8s\n", "op", "limbs", "baseline ns", "ns", "ratio");
+  for (const SuiteResult &r : results) {
+    auto it = baseline.find(std::make_pair(r.op, r.limbs));
+    if (it == baseline.end()) {
+      std::fprintf(stderr, "%-8s %8zu %16s %16.1f %8s\n", r.op.c_str(), r.limbs, "-", r.ns, "new");
+      continue;
+    }
+    double ratio = r.ns / it->second;
+    bool regressed = ratio > 1 + tolerance / 100;
+    regressions += regressed;
+    std::fprintf(stderr, "%-8s %8zu %16.1f %16.1f %8.2f%s\n", r.op.c_str(), r.limbs, it->second, r.ns, ratio,
+                 regressed ? "  REGRESSION" : "");
+  }
+  std::fprintf(stderr, "%zu regression(s) over %.0f%%\n", regressions, tolerance);
+  return regressions;
+}
+
+// Parses the suite options, runs it and reports; returns the exit status
+int run_suite_command(int argc, char **argv) {
+  size_t max_limbs = size_t(1) << 20;
+  const char *format = "csv";
+  const char *baseline = nullptr;
+  double tolerance = 10;
+  for (int i = 2; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--max-limbs") == 0 && has_value) {
+      max_limbs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--format") == 0 && has_value) {
+      format = argv[++i];
+    } else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+      baseline = argv[++i];
+    } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+      tolerance = std::strtod(argv[++i], nullptr);
+    } else {
+      std::fprintf(stderr, "unknown suite option %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (std::strcmp(format, "csv") != 0 && std::strcmp(format, "json") != 0) {
+    std::fprintf(stderr, "unknown format %s (expected csv or json)\n", format);
+    return 2;
+  }
+
+  std::vector<SuiteResult> results = run_suite(max_limbs);
+  if (std::strcmp(format, "json") == 0) {
+    write_json(results);
+  } else {
+    write_csv(results);
+  }
+  if (baseline && compare_with_baseline(results, baseline, tolerance) > 0) {
+    return 1;
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && std::strcmp(argv[1], "suite") == 0) {
+    return run_suite_command(argc, argv);
+  }
+  if (argc > 1 && std::strcmp(argv[1], "alloc") == 0) {
+    run_allocation_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "modpow") == 0) {
+    run_modpow_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "threads") == 0) {
+    unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 2) {
+      max_threads = unsigned(std::strtoul(argv[2], nullptr, 10));
+    }
+    run_thread_bench(max_threads);
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(argv[1], "batch") == 0) {
+    run_batch_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "sort") == 0) {
+    run_sort_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "io") == 0) {
+    run_io_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "div") == 0) {
+    run_div_bench(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16384);
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "dot") == 0) {
+    unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 2) {
+      max_threads = unsigned(std::strtoul(argv[2], nullptr, 10));
+    }
+    run_dot_bench(max_threads);
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "prime") == 0) {
+    run_prime_bench();
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "sqr") == 0) {
+    run_sqr_bench(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16384);
+    return 0;
+  }
+  if (argc > 1 && std::strcmp(argv[1], "gcd") == 0) {
+    run_gcd_bench(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024);
+    return 0;
+  }
+
+  size_t max_limbs = 4096;
+  if (argc > 1) {
+    max_limbs = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  const size_t NEVER = SIZE_MAX;
+  size_t karatsuba_default = limb_karatsuba_threshold;
+  size_t toom3_default = limb_toom3_threshold;
+
+  // The "1 level" columns force their algorithm for the top-level split
+  // only, by setting its threshold to n: Karatsuba runs schoolbook
+  // below it, Toom-3 runs the current Karatsuba threshold below it.
+  // The Karatsuba threshold is where "kara 1lvl" first beats
+  // "schoolbook"; the Toom-3 threshold is where "toom3 1lvl" first
+  // beats "kara all", which uses Karatsuba at every level above the
+  // Karatsuba threshold. The NTT threshold is where "ntt" first beats
+  // "toom3 all".
+  std::printf("kernels: %s\n", limb_kernel_name());
+  std::printf("current thresholds: karatsuba=%zu toom3=%zu ntt=%zu\n", limb_karatsuba_threshold, limb_toom3_threshold, limb_ntt_threshold);
+  std::printf("%8s %12s %12s %12s %12s %12s %12s %12s\n", "limbs", "schoolbook", "kara 1lvl", "kara all", "toom3 1lvl", "toom3 all", "ntt", "auto");
+  std::printf("%8s %12s %12s %12s %12s %12s %12s %12s\n", "", "ns/limb^2", "ns/limb^2", "ns/limb^2", "ns/limb^2", "ns/limb^2", "ns/limb^2", "ns/limb^2");
+
+  // Sizes grow by roughly 1.5x to resolve the crossovers reasonably well
+  for (size_t n = 8; n <= max_limbs; n = n * 3 / 2) {
+    double limbs_sq = double(n) * double(n);
+
+    double school = time_mul(n, NEVER, NEVER, NEVER) / limbs_sq;
+    double karatsuba_top = time_mul(n, n, NEVER, NEVER) / limbs_sq;
+    double karatsuba_all = time_mul(n, karatsuba_default, NEVER, NEVER) / limbs_sq;
+    double toom3_top = time_mul(n, karatsuba_default, n, NEVER) / limbs_sq;
+    double toom3_all = time_mul(n, karatsuba_default, toom3_default, NEVER) / limbs_sq;
+    double ntt = time_mul(n, karatsuba_default, toom3_default, n) / limbs_sq;
+    double automatic = time_mul(n, limb_karatsuba_threshold, limb_toom3_threshold, limb_ntt_threshold) / limbs_sq;
+
+    std::printf("%8zu %12.4f %12.4f %12.4f %12.4f %12.4f %12.4f %12.4f\n", n, school, karatsuba_top, karatsuba_all, toom3_top, toom3_all, ntt, automatic);
+  }
+
+  return 0;
+}
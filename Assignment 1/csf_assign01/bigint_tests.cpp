@@ -1,7 +1,20 @@
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+#include "bigdecimal.h"
 #include "bigint.h"
+#include "bigint_batch.h"
+#include "bigint_view.h"
+#include "fixed_int.h"
+#include "limb_arena.h"
+#include "limb_ops.h"
+#include "montgomery.h"
+#include "radix_powers.h"
+#include "bigrational.h"
 #include "tctest.h"
 
 struct TestObjs {
@@ -58,7 +71,11 @@ void test_default_ctor(TestObjs *objs);
 void test_u64_ctor(TestObjs *objs);
 void test_initlist_ctor(TestObjs *objs);
 void test_copy_ctor(TestObjs *objs);
+void test_move(TestObjs *objs);
+void test_inline_limbs(TestObjs *objs);
 void test_get_bits(TestObjs *objs);
+void test_limb_kernels(TestObjs *objs);
+void test_limb_arena(TestObjs *objs);
 void test_add_1(TestObjs *objs);
 void test_add_2(TestObjs *objs);
 void test_add_3(TestObjs *objs);
@@ -67,20 +84,48 @@ void test_sub_1(TestObjs *objs);
 void test_sub_2(TestObjs *objs);
 void test_sub_3(TestObjs *objs);
 void test_sub_4(TestObjs *objs);
+void test_compound_assign(TestObjs *objs);
+void test_temporary_operands(TestObjs *objs);
 void test_is_bit_set_1(TestObjs *objs);
 void test_is_bit_set_2(TestObjs *objs);
 void test_lshift_1(TestObjs *objs);
 void test_lshift_2(TestObjs *objs);
+void test_rshift(TestObjs *objs);
+void test_bitwise(TestObjs *objs);
 void test_mul_1(TestObjs *objs);
 void test_mul_2(TestObjs *objs);
+void test_mul_3(TestObjs *objs);
+void test_mul_ntt(TestObjs *objs);
+void test_square(TestObjs *objs);
+void test_parallel_mul(TestObjs *objs);
+void test_addmul_dot(TestObjs *objs);
 void test_compare_1(TestObjs *objs);
 void test_compare_2(TestObjs *objs);
+void test_normalized_form(TestObjs *objs);
 void test_div_1(TestObjs *objs);
 void test_div_2(TestObjs *objs);
+void test_divmod(TestObjs *objs);
+void test_div_newton(TestObjs *objs);
+void test_isqrt_nth_root(TestObjs *objs);
+void test_mod_pow(TestObjs *objs);
+void test_modpow(TestObjs *objs);
+void test_gcd(TestObjs *objs);
+void test_primes(TestObjs *objs);
+void test_fixed_int(TestObjs *objs);
+void test_bigdecimal(TestObjs *objs);
+void test_bigrational(TestObjs *objs);
+void test_bigint_batch(TestObjs *objs);
 void test_to_hex_1(TestObjs *objs);
 void test_to_hex_2(TestObjs *objs);
+void test_from_hex(TestObjs *objs);
 void test_to_dec_1(TestObjs *objs);
 void test_to_dec_2(TestObjs *objs);
+void test_to_dec_3(TestObjs *objs);
+void test_from_dec(TestObjs *objs);
+void test_radix_strings(TestObjs *objs);
+void test_encode_decode(TestObjs *objs);
+void test_bigint_view(TestObjs *objs);
+void test_sort_key(TestObjs *objs);
 void hw1_constructors_equals_tests(TestObjs *objs);
 void hw1_get_bits_get_bit_vector_tests(TestObjs *objs);
 void hw_1_unary_is_negative_tests(TestObjs *objs);
@@ -105,7 +150,11 @@ int main(int argc, char **argv) {
   TEST(test_u64_ctor);
   TEST(test_initlist_ctor);
   TEST(test_copy_ctor);
+  TEST(test_move);
+  TEST(test_inline_limbs);
   TEST(test_get_bits);
+  TEST(test_limb_kernels);
+  TEST(test_limb_arena);
   TEST(test_add_1);
   TEST(test_add_2);
   TEST(test_add_3);
@@ -114,20 +163,48 @@ int main(int argc, char **argv) {
   TEST(test_sub_2);
   TEST(test_sub_3);
   TEST(test_sub_4);
+  TEST(test_compound_assign);
+  TEST(test_temporary_operands);
   TEST(test_is_bit_set_1);
   TEST(test_is_bit_set_2);
   TEST(test_lshift_1);
   TEST(test_lshift_2);
+  TEST(test_rshift);
+  TEST(test_bitwise);
   TEST(test_mul_1);
   TEST(test_mul_2);
+  TEST(test_mul_3);
+  TEST(test_mul_ntt);
+  TEST(test_square);
+  TEST(test_parallel_mul);
+  TEST(test_addmul_dot);
   TEST(test_compare_1);
   TEST(test_compare_2);
+  TEST(test_normalized_form);
   TEST(test_div_1);
   TEST(test_div_2);
+  TEST(test_divmod);
+  TEST(test_div_newton);
+  TEST(test_isqrt_nth_root);
+  TEST(test_mod_pow);
+  TEST(test_modpow);
+  TEST(test_gcd);
+  TEST(test_primes);
+  TEST(test_fixed_int);
+  TEST(test_bigdecimal);
+  TEST(test_bigrational);
+  TEST(test_bigint_batch);
   TEST(test_to_hex_1);
   TEST(test_to_hex_2);
+  TEST(test_from_hex);
   TEST(test_to_dec_1);
   TEST(test_to_dec_2);
+  TEST(test_to_dec_3);
+  TEST(test_from_dec);
+  TEST(test_radix_strings);
+  TEST(test_encode_decode);
+  TEST(test_bigint_view);
+  TEST(test_sort_key);
 
   //! The following tests were the student-made to test various edge cases
   //! They do not contain tests that were previously written with the provided code.
@@ -148,6 +225,16 @@ int main(int argc, char **argv) {
 }
 
 
+// Build a BigInt with n pseudo-random limbs (deterministic for a given seed)
+BigInt random_bigint(size_t n, uint64_t seed) {
+  BigInt result;
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    result = result + (BigInt(seed ^ (seed >> 29)) << (64 * i));
+  }
+  return result;
+}
+
 // All initialization of test fixture objects should be done
 // in the TestObjs constructor.
 TestObjs::TestObjs()
@@ -283,6 +370,73 @@ void test_copy_ctor(TestObjs *objs) {
   ASSERT(!copy.is_negative());
 }
 
+void test_move(TestObjs *objs) {
+  BigInt source(objs->really_big_number);
+  const uint64_t *limbs = source.get_bit_vector().data();
+
+  BigInt moved(std::move(source));
+  check_contents(moved, {4UL, 7UL, 6UL, 9UL, 0UL, 3UL, 1UL, 2UL, 5UL});
+  ASSERT(moved.get_bit_vector().data() == limbs); // storage was taken over, not copied
+  ASSERT(source == objs->zero);
+
+  BigInt assigned;
+  assigned = std::move(moved);
+  check_contents(assigned, {4UL, 7UL, 6UL, 9UL, 0UL, 3UL, 1UL, 2UL, 5UL});
+  ASSERT(assigned.get_bit_vector().data() == limbs);
+  ASSERT(moved == objs->zero);
+
+  BigInt negative(objs->negative_two_pow_64);
+  BigInt negative_moved(std::move(negative));
+  ASSERT(negative_moved.is_negative());
+  ASSERT(!negative.is_negative());
+}
+
+// Check whether a BigInt's limbs are stored inside the object itself
+bool limbs_are_inline(const BigInt &val) {
+  const char *limbs = reinterpret_cast<const char *>(val.get_bit_vector().data());
+  const char *object = reinterpret_cast<const char *>(&val);
+  return limbs >= object && limbs < object + sizeof(BigInt);
+}
+
+void test_inline_limbs(TestObjs *objs) {
+  // values of up to LimbVector::INLINE_LIMBS limbs stay in the object
+  ASSERT(limbs_are_inline(objs->one));
+  ASSERT(limbs_are_inline(objs->two_pow_64));
+  ASSERT(!limbs_are_inline(objs->really_big_number));
+
+  BigInt sum = objs->u64_max;
+  for (int i = 0; i < 100; ++i) {
+    sum += objs->u64_max;
+  }
+  ASSERT(limbs_are_inline(sum));
+
+  BigInt product = objs->u64_max * objs->u64_max;
+  ASSERT(limbs_are_inline(product));
+  check_contents(product, { 0x0000000000000001UL, 0xFFFFFFFFFFFFFFFEUL });
+
+  // spilling to the heap and back through copies and moves
+  BigInt big = objs->one << 300;
+  ASSERT(!limbs_are_inline(big));
+  BigInt copy = big;
+  ASSERT(copy == big);
+  ASSERT(copy.get_bit_vector().data() != big.get_bit_vector().data());
+
+  BigInt small = objs->three;
+  small = big;
+  ASSERT(small == big);
+  small = std::move(copy);
+  ASSERT(small == big);
+  big = objs->nine;
+  ASSERT(big == objs->nine);
+  check_contents(small, { 0UL, 0UL, 0UL, 0UL, 1UL << 44 });
+
+  // the view compares and converts like the vector it replaces
+  std::vector<uint64_t> limbs = objs->two_pow_64_plus_hex.get_bit_vector();
+  ASSERT(limbs.size() == 2 && limbs[0] == 257UL && limbs[1] == 1UL);
+  ASSERT(objs->two_pow_64_plus_hex.get_bit_vector() == limbs);
+  ASSERT(objs->two_pow_64_plus_hex.get_bit_vector() != objs->two_pow_64.get_bit_vector());
+}
+
 void test_get_bits(TestObjs *objs) {
   ASSERT(0UL == objs->zero.get_bits(0));
   ASSERT(0UL == objs->zero.get_bits(1));
@@ -297,6 +451,109 @@ void test_get_bits(TestObjs *objs) {
   ASSERT(1UL == objs->two_pow_64.get_bits(1));
 }
 
+void test_limb_kernels(TestObjs *) {
+  // the CPU-specific kernels must agree with the portable ones,
+  // including long carry/borrow chains through all-ones limbs
+
+  const size_t n = 37;
+  uint64_t a[n], b[n];
+  uint64_t seed = 12345;
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    a[i] = (i % 5 == 1) ? 0xFFFFFFFFFFFFFFFFUL : seed;
+    b[i] = (i % 3 == 0) ? 0xFFFFFFFFFFFFFFFFUL : seed >> 7;
+  }
+
+  uint64_t results[2][8][n + 1];
+  char hex[2][16 * n];
+  for (int portable = 0; portable < 2; ++portable) {
+    limb_use_portable_kernels(portable);
+    uint64_t (*r)[n + 1] = results[portable];
+    r[0][n] = limb_add_n(r[0], a, b, n);
+    r[1][n] = limb_sub_n(r[1], a, b, n);
+    r[2][n] = limb_sub_n(r[2], b, a, n);
+    r[3][n] = limb_mul_1(r[3], a, n, b[5]);
+    std::copy(b, b + n, r[4]);
+    r[4][n] = limb_addmul_1(r[4], a, n, 0xFFFFFFFFFFFFFFFFUL);
+    std::copy(b, b + n, r[5]);
+    r[5][n] = limb_submul_1(r[5], a, n, a[2]);
+    r[6][n] = limb_lshift(r[6], a, n, 13);
+    r[7][n] = limb_rshift(r[7], a, n, 63);
+    limb_to_hex(hex[portable], a, n);
+  }
+  limb_use_portable_kernels(false);
+
+  for (int k = 0; k < 8; ++k) {
+    ASSERT(std::equal(results[0][k], results[0][k] + n + 1, results[1][k]));
+  }
+  ASSERT(std::equal(hex[0], hex[0] + 16 * n, hex[1]));
+  ASSERT(std::string(hex[0], 16) == BigInt(a[n - 1]).to_hex());
+  ASSERT(results[0][0][n] == 1); // carry out of the top limb
+  ASSERT(results[0][2][n] == 1); // borrow out of the top limb
+
+  // the multiply-accumulate kernels unroll by 4, so check every length
+  // up to a few unrolled iterations, with the largest multiplier
+  for (size_t len = 1; len <= 13; ++len) {
+    uint64_t sums[2][2][n];
+    uint64_t carries[2][2];
+    for (int portable = 0; portable < 2; ++portable) {
+      limb_use_portable_kernels(portable);
+      std::copy(b, b + len, sums[portable][0]);
+      carries[portable][0] = limb_addmul_1(sums[portable][0], a, len, 0xFFFFFFFFFFFFFFFFUL);
+      std::copy(a, a + len, sums[portable][1]);
+      carries[portable][1] = limb_submul_1(sums[portable][1], b, len, 0xFFFFFFFFFFFFFFFFUL);
+    }
+    limb_use_portable_kernels(false);
+    for (int k = 0; k < 2; ++k) {
+      ASSERT(std::equal(sums[0][k], sums[0][k] + len, sums[1][k]));
+      ASSERT(carries[0][k] == carries[1][k]);
+    }
+  }
+}
+
+void test_limb_arena(TestObjs *) {
+  // released scratch space is handed out again
+  LimbArena &arena = LimbArena::local();
+  uint64_t *first;
+  {
+    LimbScratchScope scope;
+    first = scope.allocate(100);
+    uint64_t *zeroed = scope.allocate_zeroed(50);
+    ASSERT(zeroed == first + 100);
+    ASSERT(std::count(zeroed, zeroed + 50, 0UL) == 50);
+    {
+      LimbScratchScope inner;
+      ASSERT(inner.allocate(10) == first + 150);
+    }
+    ASSERT(scope.allocate(10) == first + 150);
+  }
+  {
+    LimbScratchScope scope;
+    ASSERT(scope.allocate(100) == first);
+  }
+
+  // repeated large operations stop growing the arena after the first one
+  BigInt left = random_bigint(600, 3);
+  BigInt right = random_bigint(500, 4);
+  BigInt product = left * right;
+  size_t reserved = arena.reserved_limbs();
+  ASSERT(reserved > 0);
+  ASSERT(left * right == product);
+  ASSERT(arena.reserved_limbs() == reserved);
+
+  // results do not depend on whether the arena is used
+  LimbArena::set_enabled(false);
+  BigInt heap_product = left * right;
+  std::pair<BigInt, BigInt> heap_qr = product.divmod(right + BigInt(1));
+  std::string heap_dec = product.to_dec();
+  LimbArena::set_enabled(true);
+
+  ASSERT(heap_product == product);
+  std::pair<BigInt, BigInt> qr = product.divmod(right + BigInt(1));
+  ASSERT(heap_qr.first == qr.first && heap_qr.second == qr.second);
+  ASSERT(heap_dec == product.to_dec());
+}
+
 void test_add_1(TestObjs *objs) {
   // very basic tests for addition
 
@@ -421,6 +678,94 @@ void test_sub_4(TestObjs *) {
   }
 }
 
+void test_compound_assign(TestObjs *objs) {
+  BigInt val = objs->u64_max;
+  val += objs->one;
+  check_contents(val, {0UL, 1UL});
+
+  val -= objs->one;
+  check_contents(val, {0xFFFFFFFFFFFFFFFFUL});
+  ASSERT(!val.is_negative());
+
+  val -= objs->two_pow_64;
+  check_contents(val, {1UL});
+  ASSERT(val.is_negative());
+
+  val += objs->three;
+  check_contents(val, {2UL});
+  ASSERT(!val.is_negative());
+
+  val *= objs->negative_nine;
+  check_contents(val, {18UL});
+  ASSERT(val.is_negative());
+
+  val -= val;
+  ASSERT(val == objs->zero);
+  ASSERT(!val.is_negative());
+
+  // aliasing: adding a value to itself doubles it
+  BigInt doubled = objs->two_pow_64;
+  doubled += doubled;
+  ASSERT(doubled == objs->two_pow_65);
+
+  BigInt shifted = objs->three;
+  shifted <<= 63;
+  check_contents(shifted, {0x8000000000000000UL, 1UL});
+  shifted <<= 128;
+  check_contents(shifted, {0UL, 0UL, 0x8000000000000000UL, 1UL});
+
+  BigInt negative = objs->negative_three;
+  try {
+    negative <<= 1;
+    FAIL("left shifting a negative value should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  // accumulating in place matches the plain operators
+  BigInt sum, expected;
+  for (unsigned i = 0; i < 50; ++i) {
+    BigInt term = random_bigint(i % 7 + 1, i);
+    if (i % 3 == 0) {
+      sum -= term;
+      expected = expected - term;
+    } else {
+      sum += term;
+      expected = expected + term;
+    }
+  }
+  ASSERT(sum == expected);
+}
+
+void test_temporary_operands(TestObjs *objs) {
+  // the operators that reuse a temporary operand give the same results
+  // as the ones that copy, for every sign combination
+  BigInt values[] = { objs->zero, objs->three, objs->negative_nine, objs->two_pow_64,
+                      -objs->two_pow_65, objs->really_big_number };
+  for (const BigInt &a : values) {
+    for (const BigInt &b : values) {
+      BigInt sum = a + b;
+      BigInt difference = a - b;
+
+      ASSERT(BigInt(a) + b == sum);
+      ASSERT(a + BigInt(b) == sum);
+      ASSERT(BigInt(a) + BigInt(b) == sum);
+      ASSERT(BigInt(a) - b == difference);
+      ASSERT(a - BigInt(b) == difference);
+      ASSERT(BigInt(a) - BigInt(b) == difference);
+      ASSERT(!(a - BigInt(a)).is_negative());
+    }
+  }
+
+  // a chained expression that only allocates for the product
+  BigInt a = random_bigint(20, 1), b = random_bigint(30, 2), c = random_bigint(25, 3);
+  BigInt expected = b * c;
+  expected += a;
+  ASSERT(a + b * c == expected);
+  ASSERT(b * c + a == expected);
+  ASSERT(a - b * c == -(expected - a - a));
+}
+
 void test_is_bit_set_1(TestObjs *objs) {
   // some basic tests for is_bit_set
 
@@ -512,6 +857,113 @@ void test_lshift_2(TestObjs *) {
   }
 }
 
+// BigInt with the value of a signed 64-bit integer
+static BigInt from_int64(int64_t value) {
+  return value < 0 ? BigInt(uint64_t(0) - uint64_t(value), true) : BigInt(uint64_t(value));
+}
+
+void test_rshift(TestObjs *objs) {
+  // small values against the built-in arithmetic shift
+  const int64_t values[] = { 0, 1, -1, 5, -5, 8, -8, 1000003, -1000003, INT64_MAX, INT64_MIN + 1 };
+  for (int64_t value : values) {
+    for (unsigned n : { 0, 1, 2, 3, 17, 62, 63 }) {
+      ASSERT((from_int64(value) >> n) == from_int64(value >> n));
+    }
+    ASSERT((from_int64(value) >> 64) == from_int64(value < 0 ? -1 : 0));
+    ASSERT((from_int64(value) >> 1000) == from_int64(value < 0 ? -1 : 0));
+  }
+
+  // large values: shifting right undoes shifting left, and negative
+  // values round toward negative infinity
+  BigInt big = random_bigint(9, 41);
+  for (unsigned n : { 1, 63, 64, 65, 128, 300, 575, 576, 700 }) {
+    BigInt power = BigInt(1) << n;
+    ASSERT(((big << n) >> n) == big);
+    ASSERT((big >> n) == big / power);
+    BigInt floor_quotient = (-big) / power;
+    if (floor_quotient * power != -big) {
+      floor_quotient -= objs->one;
+    }
+    ASSERT((-big >> n) == floor_quotient);
+    ASSERT((-(big << n) >> n) == -big);
+  }
+
+  BigInt value = objs->two_pow_64_plus_one;
+  value >>= 64;
+  ASSERT(value == objs->one);
+  value = -objs->two_pow_64_plus_one;
+  value >>= 64;
+  ASSERT(value == BigInt(2, true));
+}
+
+void test_bitwise(TestObjs *objs) {
+  // small values against the built-in two's complement operators
+  const int64_t values[] = { 0, 1, -1, 2, -2, 12345, -12345, 0x5555555555555555, -0x5555555555555555, INT64_MAX, INT64_MIN + 1 };
+  for (int64_t x : values) {
+    BigInt a = from_int64(x);
+    ASSERT(~a == from_int64(~x));
+    for (int64_t y : values) {
+      BigInt b = from_int64(y);
+      ASSERT((a & b) == from_int64(x & y));
+      ASSERT((a | b) == from_int64(x | y));
+      ASSERT((a ^ b) == from_int64(x ^ y));
+    }
+  }
+
+  // operands of different lengths and signs, where carries and borrows
+  // of the two's complement conversion cross limb boundaries
+  BigInt big[] = { random_bigint(6, 51), random_bigint(3, 52), (BigInt(1) << 256) - objs->one, BigInt(1) << 192,
+                   objs->u64_max, objs->zero };
+  for (const BigInt &x : big) {
+    for (const BigInt &y : big) {
+      for (int signs = 0; signs < 4; ++signs) {
+        BigInt a = (signs & 1) ? -x : x;
+        BigInt b = (signs & 2) ? -y : y;
+        BigInt both = a & b, either = a | b, exactly_one = a ^ b;
+        ASSERT(both + either == a + b);
+        ASSERT(either - both == exactly_one);
+        ASSERT((a ^ b ^ b) == a);
+        ASSERT((a & ~b) == (a ^ both));
+        ASSERT(~(a | b) == (~a & ~b));
+        ASSERT((a & -objs->one) == a);
+      }
+    }
+  }
+
+  // the result of two negatives can need one more limb than either operand
+  BigInt low = -(objs->u64_max);                  // ...1111 0000...0001
+  BigInt lower = -(objs->u64_max - objs->one);    // ...1111 0000...0010
+  ASSERT((low & lower) == -(BigInt(1) << 64));
+
+  BigInt value = objs->u64_max;
+  value &= objs->nine;
+  ASSERT(value == objs->nine);
+  value |= objs->three;
+  ASSERT(value == BigInt(11));
+  value ^= objs->negative_three;
+  ASSERT(value == BigInt(10, true));
+
+  // bit counting
+  ASSERT(objs->zero.bit_length() == 0);
+  ASSERT(objs->one.bit_length() == 1);
+  ASSERT(objs->negative_nine.bit_length() == 4);
+  ASSERT(objs->two_pow_64_plus_one.bit_length() == 65);
+  ASSERT(objs->multiple_zeros.bit_length() == 0);
+  ASSERT(objs->zero.popcount() == 0);
+  ASSERT(objs->u64_max.popcount() == 64);
+  ASSERT(objs->negative_nine.popcount() == 2);
+  ASSERT(((BigInt(1) << 1000) - objs->one).popcount() == 1000);
+  ASSERT(objs->one.lowest_set_bit() == 0);
+  ASSERT(BigInt(12, true).lowest_set_bit() == 2);
+  ASSERT((BigInt(1) << 200).lowest_set_bit() == 200);
+  try {
+    objs->zero.lowest_set_bit();
+    FAIL("0 has no lowest set bit");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
 void test_mul_1(TestObjs *objs) {
   // some very basic multiplication tests
 
@@ -540,6 +992,257 @@ void test_mul_2(TestObjs *) {
   }
 }
 
+void test_mul_3(TestObjs *) {
+  // Karatsuba and Toom-3 products must match schoolbook products,
+  // for balanced and lopsided operands
+
+  size_t saved_karatsuba = limb_karatsuba_threshold;
+  size_t saved_toom3 = limb_toom3_threshold;
+  size_t sizes[][2] = { {40, 40}, {97, 60}, {300, 300}, {301, 170}, {700, 45}, {520, 390} };
+
+  for (auto &size : sizes) {
+    BigInt left = random_bigint(size[0], size[0]);
+    BigInt right = -random_bigint(size[1], size[1] + 1);
+
+    limb_karatsuba_threshold = SIZE_MAX;
+    limb_toom3_threshold = SIZE_MAX;
+    BigInt expected = left * right;
+
+    // default thresholds
+    limb_karatsuba_threshold = saved_karatsuba;
+    limb_toom3_threshold = saved_toom3;
+    BigInt result1 = left * right;
+
+    // lowest thresholds, so every level of the recursion is exercised
+    limb_karatsuba_threshold = 4;
+    limb_toom3_threshold = 12;
+    BigInt result2 = right * left;
+
+    limb_karatsuba_threshold = saved_karatsuba;
+    limb_toom3_threshold = saved_toom3;
+
+    ASSERT(expected.is_negative());
+    ASSERT(expected.get_bit_vector().size() == size[0] + size[1]);
+    ASSERT(result1 == expected);
+    ASSERT(result2 == expected);
+  }
+
+  {
+    // (2^6400 - 1)^2 = 2^12800 - 2^6401 + 1
+    BigInt all_ones = (BigInt(1) << 6400) - BigInt(1);
+    BigInt result = all_ones * all_ones;
+    ASSERT(result == (BigInt(1) << 12800) - (BigInt(1) << 6401) + BigInt(1));
+  }
+}
+
+void test_mul_ntt(TestObjs *) {
+  // NTT products must match Toom-3 products exactly, including for
+  // all-ones operands, where every coefficient is as large as possible
+  size_t saved_ntt = limb_ntt_threshold;
+  size_t sizes[][2] = { {1, 1}, {2, 1}, {17, 5}, {300, 300}, {1000, 999}, {1500, 37}, {2049, 2048} };
+
+  for (auto &size : sizes) {
+    BigInt left = random_bigint(size[0], size[0] + 7);
+    BigInt right = random_bigint(size[1], size[1] + 8);
+    BigInt ones = (BigInt(1) << unsigned(64 * size[0])) - BigInt(1);
+
+    limb_ntt_threshold = SIZE_MAX;
+    BigInt expected = left * right;
+    BigInt expected_square = ones * ones;
+    BigInt expected_mixed = ones * right;
+
+    limb_ntt_threshold = 1;
+    ASSERT(left * right == expected);
+    ASSERT(ones * ones == expected_square);
+    ASSERT(ones * right == expected_mixed);
+  }
+
+  limb_ntt_threshold = saved_ntt;
+
+  // a product picked by the default thresholds
+  BigInt big = random_bigint(limb_ntt_threshold + 10, 77);
+  BigInt product = big * big;
+  limb_ntt_threshold = SIZE_MAX;
+  ASSERT(big * big == product);
+  limb_ntt_threshold = saved_ntt;
+}
+
+void test_square(TestObjs *objs) {
+  ASSERT(objs->zero.square() == objs->zero);
+  ASSERT(objs->negative_nine.square() == BigInt(81));
+  ASSERT(objs->u64_max.square() == objs->u64_max * BigInt(objs->u64_max));
+  check_contents(objs->two_pow_64.square(), {0UL, 0UL, 1UL});
+
+  // squares at every level of the recursion must match schoolbook
+  // products of two separate copies
+  size_t saved_sqr = limb_sqr_karatsuba_threshold;
+  size_t saved_karatsuba = limb_karatsuba_threshold;
+  size_t saved_toom3 = limb_toom3_threshold;
+  size_t saved_ntt = limb_ntt_threshold;
+  size_t sizes[] = { 1, 2, 3, 5, 33, 48, 49, 130, 301, 700 };
+  for (size_t n : sizes) {
+    BigInt val = random_bigint(n, n + 11);
+    BigInt ones = (BigInt(1) << unsigned(64 * n)) - BigInt(1);
+    BigInt sparse = (BigInt(1) << unsigned(64 * n - 1)) + BigInt(1);
+
+    limb_karatsuba_threshold = SIZE_MAX;
+    limb_toom3_threshold = SIZE_MAX;
+    limb_ntt_threshold = SIZE_MAX;
+    BigInt expected[] = { val * BigInt(val), ones * BigInt(ones), sparse * BigInt(sparse) };
+    limb_karatsuba_threshold = saved_karatsuba;
+    limb_toom3_threshold = saved_toom3;
+
+    const BigInt *inputs[] = { &val, &ones, &sparse };
+    for (size_t i = 0; i < 3; ++i) {
+      // default thresholds, then the lowest ones, then the NTT
+      ASSERT(inputs[i]->square() == expected[i]);
+      ASSERT((-*inputs[i]).square() == expected[i]);
+      ASSERT(*inputs[i] * *inputs[i] == expected[i]);
+      limb_sqr_karatsuba_threshold = 4;
+      limb_toom3_threshold = 12;
+      ASSERT(inputs[i]->square() == expected[i]);
+      limb_sqr_karatsuba_threshold = saved_sqr;
+      limb_toom3_threshold = saved_toom3;
+      limb_ntt_threshold = 1;
+      ASSERT(inputs[i]->square() == expected[i]);
+      limb_ntt_threshold = SIZE_MAX;
+    }
+    limb_ntt_threshold = saved_ntt;
+  }
+
+  // pow squares its way up and multiplies in the base
+  BigInt base = random_bigint(3, 9);
+  BigInt expected = objs->one;
+  for (unsigned k = 0; k <= 40; ++k) {
+    ASSERT(base.pow(k) == expected);
+    ASSERT((-base).pow(k) == ((k & 1) ? -expected : expected));
+    expected = expected * base;
+  }
+}
+
+void test_parallel_mul(TestObjs *objs) {
+  // products computed on several threads match the single-threaded ones
+  size_t saved_toom3 = limb_toom3_threshold;
+  size_t saved_parallel = limb_parallel_threshold;
+  unsigned saved_threads = limb_mul_threads;
+
+  BigInt left = random_bigint(900, 11);
+  BigInt right = -random_bigint(700, 12);
+  std::vector<BigInt> factors;
+  for (unsigned i = 0; i < 37; ++i) {
+    factors.push_back(random_bigint(i % 9 + 1, i + 100));
+  }
+  factors[5] = -factors[5];
+
+  BigInt expected = left * right;
+  BigInt expected_product(1);
+  for (const BigInt &factor : factors) {
+    expected_product *= factor;
+  }
+  ASSERT(BigInt::product(factors) == expected_product);
+
+  // low thresholds so that nested Toom-3 levels run in parallel too
+  limb_toom3_threshold = 64;
+  limb_parallel_threshold = 64;
+  for (unsigned threads : { 2, 3, 8 }) {
+    limb_mul_threads = threads;
+    ASSERT(left * right == expected);
+    ASSERT(right * left == expected);
+    ASSERT(BigInt::product(factors) == expected_product);
+
+    // an exception on the calling thread or on a worker reaches the
+    // caller once every thread has been joined, instead of terminating
+    for (size_t bad : { 0, 1 }) {
+      try {
+        limb_parallel_for(16, [bad](size_t i) {
+          if (i == bad) {
+            throw std::bad_alloc();
+          }
+        });
+        FAIL("an exception from a parallel call should reach the caller");
+      } catch (std::bad_alloc &ex) {
+        // good
+      }
+    }
+    std::atomic<size_t> calls(0);
+    limb_parallel_for(16, [&calls](size_t) { ++calls; });
+    ASSERT(calls == 16);
+    ASSERT(left * right == expected);
+  }
+
+  limb_toom3_threshold = saved_toom3;
+  limb_parallel_threshold = saved_parallel;
+  limb_mul_threads = saved_threads;
+
+  ASSERT(BigInt::product({}) == objs->one);
+  ASSERT(BigInt::product({ objs->negative_nine }) == objs->negative_nine);
+  ASSERT(BigInt::product({ objs->three, objs->zero, objs->nine }) == objs->zero);
+}
+
+void test_addmul_dot(TestObjs *objs) {
+  // every sign combination, with accumulators that grow, shrink, cancel
+  // and change sign, through the in-place and the scratch paths
+  size_t sizes[][2] = { {1, 1}, {3, 1}, {1, 4}, {7, 5}, {40, 40}, {90, 33}, {200, 150} };
+  for (auto &size : sizes) {
+    BigInt a = random_bigint(size[0], size[0] * 3 + 1);
+    BigInt b = random_bigint(size[1], size[1] * 5 + 2);
+    BigInt accumulators[] = { objs->zero, objs->one, objs->negative_nine, random_bigint(size[0] + size[1] + 2, 9), -(a * b) };
+    for (const BigInt &start : accumulators) {
+      for (int signs = 0; signs < 4; ++signs) {
+        BigInt x = (signs & 1) ? -a : a;
+        BigInt y = (signs & 2) ? -b : b;
+        BigInt acc = start;
+        acc.addmul(x, y);
+        ASSERT(acc == start + x * y);
+        ASSERT(acc.addmul(y, x) == start + x * y * objs->two);
+      }
+    }
+  }
+  BigInt acc = objs->three;
+  ASSERT(acc.addmul(acc, acc) == BigInt(12));
+  ASSERT(acc.addmul(objs->negative_three, acc) == BigInt(24, true));
+  ASSERT(acc.addmul(objs->zero, acc) == BigInt(24, true));
+  BigInt cancel = BigInt(27, true);
+  ASSERT(cancel.addmul(objs->three, objs->nine) == objs->zero);
+  ASSERT(!cancel.is_negative());
+
+  // dot products against separate multiplications and additions
+  std::vector<BigInt> left, right;
+  BigInt expected;
+  for (size_t i = 0; i < 300; ++i) {
+    BigInt l = random_bigint(1 + i % 5, i + 100);
+    BigInt r = random_bigint(1 + i % 3, i + 900);
+    left.push_back(i % 3 == 0 ? -l : l);
+    right.push_back(i % 7 == 0 ? -r : r);
+    expected += left.back() * right.back();
+  }
+  ASSERT(BigInt::dot(left, right) == expected);
+  ASSERT(BigInt::dot({}, {}) == objs->zero);
+  ASSERT(BigInt::dot({ objs->three }, { objs->negative_three }) == BigInt(9, true));
+
+  // enough work to run on several threads
+  std::vector<BigInt> big_left, big_right;
+  BigInt big_expected;
+  for (size_t i = 0; i < 64; ++i) {
+    big_left.push_back(random_bigint(40, i + 2000));
+    big_right.push_back(i % 2 ? -random_bigint(40, i + 3000) : random_bigint(40, i + 3000));
+    big_expected += big_left.back() * big_right.back();
+  }
+  unsigned saved_threads = limb_mul_threads;
+  for (unsigned threads : { 1, 3, 8 }) {
+    limb_mul_threads = threads;
+    ASSERT(BigInt::dot(big_left, big_right) == big_expected);
+  }
+  limb_mul_threads = saved_threads;
+
+  try {
+    BigInt::dot(left, big_right);
+    FAIL("vectors of different lengths should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
 void test_compare_1(TestObjs *objs) {
   // some basic tests for compare
   ASSERT(objs->zero.compare(objs->zero) == 0);
@@ -561,6 +1264,73 @@ void test_compare_2(TestObjs *) {
   }
 }
 
+// True if the value has no leading zero limbs and is not a negative 0
+static bool is_normalized(const BigInt &value) {
+  LimbView limbs = value.get_bit_vector();
+  if (limbs.size() == 0) {
+    return !value.is_negative();
+  }
+  return limbs[limbs.size() - 1] != 0;
+}
+
+void test_normalized_form(TestObjs *objs) {
+  ASSERT(is_normalized(objs->multiple_zeros));
+  ASSERT(objs->multiple_zeros == objs->zero);
+  ASSERT(is_normalized(BigInt(0UL, true)));
+  ASSERT(is_normalized(BigInt({ 0UL, 0UL }, true)));
+  ASSERT(is_normalized(BigInt({ 5UL, 0UL, 0UL }, true)));
+  ASSERT(BigInt({ 5UL, 0UL, 0UL }, true) == BigInt(5, true));
+  ASSERT(BigInt(0UL, true).compare(objs->zero) == 0);
+
+  // results of every kind of operation, including ones that cancel to 0
+  BigInt big = random_bigint(5, 61);
+  BigInt values[] = { objs->zero, objs->one, objs->negative_nine, big, -big, big + objs->one };
+  for (const BigInt &a : values) {
+    ASSERT(is_normalized(-a));
+    ASSERT(is_normalized(~a));
+    ASSERT(is_normalized(a >> 3));
+    ASSERT(is_normalized(a >> 400));
+    ASSERT(is_normalized(a.pow(3)));
+    if (!a.is_negative()) {
+      ASSERT(is_normalized(a << 70));
+    }
+    for (const BigInt &b : values) {
+      ASSERT(is_normalized(a + b));
+      ASSERT(is_normalized(a - b));
+      ASSERT(is_normalized(a - a));
+      ASSERT(is_normalized(a * b));
+      ASSERT(is_normalized(a & b));
+      ASSERT(is_normalized(a | b));
+      ASSERT(is_normalized(a ^ b));
+      ASSERT(is_normalized(a.gcd(b)));
+      if (b != objs->zero) {
+        std::pair<BigInt, BigInt> qr = a.divmod(b);
+        ASSERT(is_normalized(qr.first));
+        ASSERT(is_normalized(qr.second));
+      }
+      BigInt c = a;
+      c -= b;
+      c += b;
+      ASSERT(is_normalized(c) && c == a);
+    }
+  }
+  ASSERT(is_normalized(BigInt::from_hex("-0000")));
+  ASSERT(is_normalized(BigInt::from_dec("-000")));
+
+  // std::sort goes through the in-place compare; check the order by subtraction
+  std::vector<BigInt> sorted;
+  for (uint64_t i = 0; i < 40; ++i) {
+    BigInt v = random_bigint(i % 4 + 1, i + 300);
+    sorted.push_back(i % 3 == 0 ? -v : v);
+  }
+  sorted.push_back(objs->multiple_zeros);
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t i = 1; i < sorted.size(); ++i) {
+    ASSERT(sorted[i - 1] <= sorted[i]);
+    ASSERT((sorted[i] - sorted[i - 1]).is_negative() == false);
+  }
+}
+
 void test_div_1(TestObjs *objs) {
   // Some relatively basic division tests
 
@@ -593,6 +1363,773 @@ void test_div_2(TestObjs *) {
   }
 }
 
+void test_divmod(TestObjs *objs) {
+  // quotient and remainder together, truncated toward zero
+
+  {
+    auto result = BigInt(7).divmod(objs->two);
+    check_contents(result.first, { 3UL });
+    check_contents(result.second, { 1UL });
+    ASSERT(!result.first.is_negative());
+    ASSERT(!result.second.is_negative());
+  }
+
+  {
+    auto result = BigInt(7, true).divmod(objs->two);
+    check_contents(result.first, { 3UL });
+    check_contents(result.second, { 1UL });
+    ASSERT(result.first.is_negative());
+    ASSERT(result.second.is_negative());
+  }
+
+  {
+    auto result = objs->three.divmod(objs->negative_nine);
+    ASSERT(result.first == objs->zero);
+    ASSERT(result.second == objs->three);
+  }
+
+  {
+    // single-limb divisor
+    auto result = objs->u64_max_rep.divmod(BigInt(10));
+    ASSERT(result.first * BigInt(10) + result.second == objs->u64_max_rep);
+    check_contents(result.second, { 5UL });
+  }
+
+  {
+    // the estimated quotient limb is one too large and must be added back
+    BigInt left({0UL, 0UL, 0x8000000000000000UL, 0x7fffffffffffffffUL});
+    BigInt right({1UL, 0UL, 0x8000000000000000UL});
+    auto result = left.divmod(right);
+    check_contents(result.first, { 0xfffffffffffffffeUL });
+    ASSERT(result.first * right + result.second == left);
+    ASSERT(result.second < right);
+  }
+
+  // random operands of many shapes: q * d + r == n and |r| < |d|
+  for (size_t n = 1; n < 40; n += 3) {
+    for (size_t d = 1; d <= n + 1; d += 2) {
+      BigInt dividend = random_bigint(n, n * 100 + d);
+      BigInt divisor = random_bigint(d, d * 7 + n);
+      if (d % 3 == 0) {
+        divisor = -divisor;
+      }
+      auto result = dividend.divmod(divisor);
+      ASSERT(result.first * divisor + result.second == dividend);
+      ASSERT(!result.second.is_negative());
+      ASSERT(result.second < divisor || result.second < -divisor);
+      ASSERT(result.first == dividend / divisor);
+    }
+  }
+
+  try {
+    objs->nine.divmod(objs->zero);
+    FAIL("division by zero should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_div_newton(TestObjs *) {
+  // Newton division must match long division exactly, for all signs and
+  // for divisors right next to a power of two
+  size_t saved_newton = limb_newton_threshold;
+  size_t sizes[][2] = { {8, 4}, {9, 5}, {40, 7}, {61, 30}, {200, 64}, {500, 250} };
+
+  for (auto &size : sizes) {
+    BigInt dividend = random_bigint(size[0], size[0] + 21);
+    BigInt divisors[] = {
+      random_bigint(size[1], size[1] + 22),
+      (BigInt(1) << unsigned(64 * size[1] - 1)),
+      (BigInt(1) << unsigned(64 * size[1])) - BigInt(1),
+    };
+
+    for (const BigInt &divisor : divisors) {
+      for (int signs = 0; signs < 4; ++signs) {
+        BigInt a = (signs & 1) ? -dividend : dividend;
+        BigInt d = (signs & 2) ? -divisor : divisor;
+
+        limb_newton_threshold = SIZE_MAX;
+        std::pair<BigInt, BigInt> expected = a.divmod(d);
+        limb_newton_threshold = 4;
+        std::pair<BigInt, BigInt> result = a.divmod(d);
+
+        ASSERT(result.first == expected.first);
+        ASSERT(result.second == expected.second);
+      }
+    }
+  }
+
+  // an exact quotient, so the remainder must come out as 0
+  limb_newton_threshold = 4;
+  BigInt factor = random_bigint(50, 31);
+  BigInt multiple = random_bigint(90, 32) * factor;
+  ASSERT(multiple.divmod(factor).second == BigInt());
+  ASSERT(multiple / factor * factor == multiple);
+
+  limb_newton_threshold = saved_newton;
+}
+
+void test_isqrt_nth_root(TestObjs *objs) {
+  ASSERT(objs->zero.isqrt() == objs->zero);
+  ASSERT(objs->one.isqrt() == objs->one);
+  ASSERT(objs->three.isqrt() == objs->one);
+  ASSERT(objs->nine.isqrt() == objs->three);
+  ASSERT(BigInt(8).isqrt() == BigInt(2));
+  ASSERT(objs->nine.nth_root(1) == objs->nine);
+  ASSERT(objs->negative_nine.nth_root(3) == BigInt(2, true));
+  ASSERT(BigInt(27, true).nth_root(3) == objs->negative_three);
+  ASSERT(objs->u64_max.nth_root(64) == objs->one);
+  ASSERT(objs->u64_max.nth_root(2) == BigInt(0xFFFFFFFFUL));
+
+  // degrees at or above the bit length return at once instead of raising
+  // x to huge powers
+  ASSERT(BigInt(1000).nth_root(1000000000) == objs->one);
+  ASSERT(BigInt(1000, true).nth_root(~0u) == BigInt(1, true));
+  ASSERT(objs->zero.nth_root(~0u - 1) == objs->zero);
+  ASSERT(objs->two_pow_64.nth_root(64) == BigInt(2));
+  ASSERT(objs->two_pow_64.nth_root(65) == objs->one);
+
+  // perfect powers and their neighbours, small and large
+  for (unsigned k : { 2, 3, 5, 7 }) {
+    for (size_t limbs : { 1, 3, 40, 300 }) {
+      BigInt root = random_bigint(limbs, limbs * k);
+      BigInt power = root.pow(k);
+      ASSERT(power.nth_root(k) == root);
+      ASSERT((power - objs->one).nth_root(k) == root - objs->one);
+      ASSERT((power + objs->one).nth_root(k) == root);
+      if (k == 2) {
+        ASSERT(power.isqrt() == root);
+      }
+    }
+  }
+
+  try {
+    objs->negative_nine.isqrt();
+    FAIL("isqrt of a negative value should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  try {
+    objs->nine.nth_root(0);
+    FAIL("zeroth root should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  try {
+    objs->negative_nine.nth_root(4);
+    FAIL("even root of a negative value should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_mod_pow(TestObjs *objs) {
+  // operator% follows the truncated quotient, mod() is never negative
+  BigInt seven(7), negative_seven(7, true);
+  ASSERT(seven % objs->three == objs->one);
+  ASSERT(negative_seven % objs->three == -objs->one);
+  ASSERT(seven % objs->negative_three == objs->one);
+  ASSERT(negative_seven.mod(objs->three) == BigInt(2));
+  ASSERT(seven.mod(objs->three) == objs->one);
+  ASSERT(objs->negative_nine.mod(objs->three) == objs->zero);
+  ASSERT(!objs->negative_nine.mod(objs->three).is_negative());
+
+  try {
+    seven.mod(objs->negative_three);
+    FAIL("a negative modulus should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    seven.mod(objs->zero);
+    FAIL("a zero modulus should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  ASSERT(objs->three.pow(0) == objs->one);
+  ASSERT(objs->zero.pow(0) == objs->one);
+  ASSERT(objs->zero.pow(5) == objs->zero);
+  ASSERT(objs->negative_three.pow(3) == BigInt(27, true));
+  ASSERT(objs->negative_three.pow(4) == BigInt(81));
+  ASSERT(objs->two_pow_64.pow(3) == (objs->one << 192));
+
+  BigInt base = BigInt::from_dec("123456789123456789123456789123456789123456789123456789123456789123456789123456789123456789");
+  ASSERT(base.pow(5).to_dec() == "28679718746395774517519299791372661585178461484059535641038954777040024180886283709301507643511111674256247540105731122772440032368313607404352914790620749836241636249401826137349586803581230719651838901319070275747991171511075318588203848366665293641155588613778068893756674311405977107407805789001877925156310146567618145660716676588919555233939659205888927986676955944996897698013540016046904237317246267945056581951060221256216795681720482949");
+}
+
+// Reference modular exponentiation with one multiplication and mod() per exponent bit
+BigInt slow_modpow(const BigInt &base, unsigned exponent, const BigInt &modulus) {
+  BigInt result = BigInt(1).mod(modulus);
+  for (unsigned i = 32; i > 0; --i) {
+    result = (result * result).mod(modulus);
+    if ((exponent >> (i - 1)) & 1) {
+      result = (result * base).mod(modulus);
+    }
+  }
+  return result;
+}
+
+void test_modpow(TestObjs *objs) {
+  // the Mersenne prime 2^521 - 1
+  BigInt m521 = (objs->one << 521) - objs->one;
+  BigInt base = BigInt::from_dec("123456789123456789123456789123456789123456789123456789123456789123456789123456789123456789");
+  ASSERT(base.modpow(BigInt(65537), m521).to_dec() ==
+         "4208855287429872671393182914883886024251094490440057758954172395713969182965020137596787312239801947430992700408472794415311432921203689453819294483399794126");
+
+  // Fermat's little theorem: b^(p-1) = 1 and b^p = b mod p
+  BigInt p_minus_1 = m521 - objs->one;
+  ASSERT(base.modpow(p_minus_1, m521) == objs->one);
+  ASSERT(base.modpow(m521, m521) == base);
+  ASSERT((-base).modpow(m521, m521) == (-base).mod(m521));
+
+  // edge cases
+  ASSERT(base.modpow(objs->zero, m521) == objs->one);
+  ASSERT(base.modpow(objs->zero, objs->one) == objs->zero);
+  ASSERT(base.modpow(objs->three, objs->one) == objs->zero);
+  ASSERT(objs->zero.modpow(objs->three, m521) == objs->zero);
+  ASSERT(m521.modpow(objs->three, m521) == objs->zero);
+  try {
+    base.modpow(objs->negative_three, m521);
+    FAIL("a negative exponent should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    base.modpow(objs->three, objs->zero);
+    FAIL("a zero modulus should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  // odd (Montgomery) and even (division) moduli of several sizes, against
+  // the reference, with exponents long enough to use every window width
+  unsigned exponents[] = { 1, 2, 3, 0x55, 0xF00F, 0xDEADBEEF, 0xFFFFFFFF };
+  for (size_t n = 1; n <= 40; n += 13) {
+    BigInt odd = random_bigint(n, n * 3) * objs->two_pow_64 + objs->one;
+    BigInt even = odd + objs->one;
+    BigInt x = -random_bigint(n + 2, n * 5);
+    for (unsigned e : exponents) {
+      ASSERT(x.modpow(BigInt(e), odd) == slow_modpow(x, e, odd));
+      ASSERT(x.modpow(BigInt(e), even) == slow_modpow(x, e, even));
+    }
+  }
+
+  // a reused context matches modpow, including for long exponents
+  MontgomeryContext ctx(m521);
+  BigInt e = random_bigint(30, 9);
+  ASSERT(ctx.modpow(base, e) == base.modpow(e, m521));
+  ASSERT(ctx.mul(base, -base) == (base * -base).mod(m521));
+  try {
+    MontgomeryContext even_ctx(objs->two_pow_64);
+    FAIL("an even Montgomery modulus should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+// Euclid's algorithm with plain remainders, to check gcd against
+static BigInt euclid_gcd(BigInt a, BigInt b) {
+  a = a.is_negative() ? -a : a;
+  b = b.is_negative() ? -b : b;
+  while (b != BigInt()) {
+    BigInt r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+void test_gcd(TestObjs *objs) {
+  ASSERT(objs->zero.gcd(objs->zero) == objs->zero);
+  ASSERT(objs->zero.gcd(objs->negative_nine) == objs->nine);
+  ASSERT(objs->negative_nine.gcd(objs->zero) == objs->nine);
+  ASSERT(objs->multiple_zeros.gcd(objs->three) == objs->three);
+  ASSERT(objs->nine.gcd(objs->negative_three) == objs->three);
+  ASSERT(BigInt(48).gcd(BigInt(180)) == BigInt(12));
+  ASSERT((BigInt(1) << 200).gcd(BigInt(3) << 130) == BigInt(1) << 130);
+  ASSERT(objs->u64_max.gcd(objs->two_pow_64_plus_one) == objs->one);
+  ASSERT(BigInt(4).lcm(BigInt(6, true)) == BigInt(12));
+  ASSERT(objs->zero.lcm(objs->nine) == objs->zero);
+
+  auto abs_value = [](const BigInt &v) { return v.is_negative() ? -v : v; };
+
+  // every path: binary GCD only, Lehmer steps from 3 limbs, the default;
+  // operands with a large common factor, unequal sizes and mixed signs
+  size_t saved_lehmer = limb_lehmer_threshold;
+  for (size_t threshold : { size_t(1000000), size_t(3), saved_lehmer }) {
+    limb_lehmer_threshold = threshold;
+    for (size_t n : { 1, 2, 3, 5, 17, 60 }) {
+      for (size_t m : { 1, 2, 4, 30 }) {
+        BigInt common = random_bigint(m, n * 31 + m);
+        BigInt a = random_bigint(n, n * 7 + m) * common;
+        BigInt b = -(random_bigint(n + m % 3, n * 11 + m) * common);
+        BigInt g = a.gcd(b);
+        ASSERT(g == euclid_gcd(a, b));
+        ASSERT(a.lcm(b) * g == -(a * b));
+
+        BigInt x, y;
+        ASSERT(a.extended_gcd(b, x, y) == g);
+        ASSERT(a * x + b * y == g);
+        ASSERT(abs_value(x) <= abs_value(b) && abs_value(y) <= abs_value(a));
+        ASSERT(b.extended_gcd(a, x, y) == g);
+        ASSERT(b * x + a * y == g);
+        ASSERT(abs_value(x) <= abs_value(a) && abs_value(y) <= abs_value(b));
+      }
+    }
+  }
+  limb_lehmer_threshold = saved_lehmer;
+
+  // consecutive Fibonacci numbers: every Euclid quotient is 1
+  BigInt f0(1), f1(1);
+  for (int i = 0; i < 800; ++i) {
+    BigInt f2 = f0 + f1;
+    f0 = f1;
+    f1 = f2;
+  }
+  ASSERT(f0.gcd(f1) == objs->one);
+  BigInt x, y;
+  ASSERT(f1.extended_gcd(f0, x, y) == objs->one);
+  ASSERT(f1 * x + f0 * y == objs->one);
+
+  // the machine-word path at its limits: the longest Euclid sequence below
+  // 2^128 (Fibonacci again), the largest two-limb values, and 0 operands
+  f0 = BigInt(1);
+  f1 = BigInt(1);
+  while ((f0 + f1).get_bit_vector().size() <= 2) {
+    BigInt f2 = f0 + f1;
+    f0 = f1;
+    f1 = f2;
+  }
+  ASSERT(f1.extended_gcd(-f0, x, y) == objs->one);
+  ASSERT(f1 * x - f0 * y == objs->one);
+  BigInt top = BigInt({ ~0UL, ~0UL });
+  ASSERT(top.extended_gcd(top - BigInt(2), x, y) == objs->one);
+  ASSERT(top * x + (top - BigInt(2)) * y == objs->one);
+  ASSERT(top.extended_gcd(objs->u64_max, x, y) == objs->u64_max);
+  ASSERT(top * x + objs->u64_max * y == objs->u64_max);
+  ASSERT(BigInt(5).extended_gcd(objs->zero, x, y) == BigInt(5));
+  ASSERT(x == objs->one && y == objs->zero);
+  ASSERT(objs->zero.extended_gcd(BigInt(5, true), x, y) == BigInt(5));
+  ASSERT(x == objs->zero && y == BigInt(1, true));
+  ASSERT(objs->zero.extended_gcd(objs->zero, x, y) == objs->zero);
+  ASSERT(x == objs->one && y == objs->zero);
+  ASSERT((BigInt(1) << 300).extended_gcd(objs->zero, x, y) == BigInt(1) << 300);
+  ASSERT(x == objs->one && y == objs->zero);
+
+  // modular inverse
+  BigInt p = (BigInt(1) << 127) - objs->one;
+  for (size_t n : { 1, 2, 5 }) {
+    BigInt a = random_bigint(n, n + 90);
+    BigInt inv = a.mod_inverse(p);
+    ASSERT(inv >= BigInt() && inv < p);
+    ASSERT((a * inv).mod(p) == objs->one);
+    ASSERT((-a).mod_inverse(p) == p - inv);
+  }
+  ASSERT(objs->three.mod_inverse(objs->one) == objs->zero);
+  ASSERT(objs->three.mod_inverse(BigInt(10)) == BigInt(7));
+
+  try {
+    objs->three.mod_inverse(objs->nine);
+    FAIL("a value sharing a factor with the modulus has no inverse");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->three.mod_inverse(objs->negative_nine);
+    FAIL("a negative modulus should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+// xorshift64 with a fixed seed, so failures are reproducible
+static uint64_t test_random_state = 88172645463325252UL;
+static uint64_t test_random() {
+  test_random_state ^= test_random_state << 13;
+  test_random_state ^= test_random_state >> 7;
+  test_random_state ^= test_random_state << 17;
+  return test_random_state;
+}
+
+void test_primes(TestObjs *objs) {
+  RandomSource random = test_random;
+
+  // random values stay in range and cover it
+  for (int i = 0; i < 200; ++i) {
+    BigInt r = BigInt::random_bits(70, random);
+    ASSERT(!r.is_negative() && r.bit_length() <= 70);
+  }
+  bool seen[7] = { false };
+  for (int i = 0; i < 500; ++i) {
+    BigInt r = BigInt::random_range(BigInt(3, true), BigInt(4), random);
+    ASSERT(r >= BigInt(3, true) && r < BigInt(4));
+    seen[(r + BigInt(3)).get_bits(0)] = true;
+  }
+  ASSERT(std::all_of(seen, seen + 7, [](bool b) { return b; }));
+  BigInt big_low = objs->two_pow_64, big_high = objs->two_pow_64 << 64;
+  for (int i = 0; i < 50; ++i) {
+    BigInt r = BigInt::random_range(big_low, big_high, random);
+    ASSERT(r >= big_low && r < big_high);
+  }
+  try {
+    BigInt::random_range(objs->one, objs->one, random);
+    FAIL("an empty range should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  // every value below 2^16 against a sieve, and next_prime from a
+  // sample of them
+  const size_t LIMIT = 1 << 16;
+  std::vector<bool> composite(LIMIT + 100, false);
+  composite[0] = composite[1] = true;
+  for (size_t i = 2; i < composite.size(); ++i) {
+    for (size_t j = i * i; !composite[i] && j < composite.size(); j += i) {
+      composite[j] = true;
+    }
+  }
+  size_t next = LIMIT;
+  while (composite[next]) {
+    ++next;
+  }
+  for (size_t n = LIMIT; n > 0; --n) {
+    ASSERT(BigInt(n).is_probable_prime() == !composite[n]);
+    ASSERT(n % 7 != 0 || BigInt(n).next_prime() == BigInt(next));
+    if (!composite[n]) {
+      next = n;
+    }
+  }
+  ASSERT(objs->zero.next_prime() == BigInt(2));
+  ASSERT(objs->negative_nine.next_prime() == BigInt(2));
+  ASSERT(!objs->negative_three.is_probable_prime());
+
+  // Mersenne primes and their neighbours
+  unsigned mersenne[] = { 61, 89, 107, 127, 521, 607 };
+  for (unsigned p : mersenne) {
+    BigInt m = (objs->one << p) - objs->one;
+    ASSERT(m.is_probable_prime());
+    ASSERT(m.miller_rabin(5, random));
+    ASSERT(!(m + BigInt(2)).is_probable_prime() || p == 61);
+    ASSERT(!(m * BigInt(1000003)).is_probable_prime());
+  }
+  ASSERT(!((objs->one << 67) - objs->one).is_probable_prime());
+
+  // strong pseudoprimes to base 2 with no small factors: the first is
+  // 1093^2 and the second passes bases 2 through 23
+  BigInt wieferich(1194649UL);
+  BigInt pseudoprime(3825123056546413051UL);
+  ASSERT(wieferich.is_strong_probable_prime(BigInt(2)));
+  ASSERT(pseudoprime.is_strong_probable_prime(BigInt(2)));
+  ASSERT(pseudoprime.is_strong_probable_prime(BigInt(23)));
+  ASSERT(!wieferich.is_probable_prime());
+  ASSERT(!pseudoprime.is_probable_prime());
+  ASSERT(!pseudoprime.miller_rabin(20, random));
+  ASSERT(!BigInt(561).is_strong_probable_prime(BigInt(2)));
+  ASSERT(BigInt(7).is_strong_probable_prime(BigInt(14)));
+  try {
+    objs->two_pow_64.is_strong_probable_prime(BigInt(2));
+    FAIL("Miller-Rabin on an even value should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  // the sieve across whole windows, above 2^64 and at 1024 bits
+  ASSERT(objs->two_pow_64.next_prime() == objs->two_pow_64 + BigInt(13));
+  ASSERT((objs->one << 1023).next_prime() == (objs->one << 1023) + BigInt(1155));
+  BigInt p = BigInt::from_dec("1000000000000000000000000000057");
+  ASSERT(p.is_probable_prime());
+  ASSERT((p - BigInt(57)).next_prime() == p);
+  for (int i = 0; i < 3; ++i) {
+    BigInt start = BigInt::random_bits(200, random);
+    BigInt prime = start.next_prime();
+    ASSERT(prime > start && prime.is_probable_prime() && prime.miller_rabin(10, random));
+    for (BigInt c = start + BigInt(1); c < prime; c += BigInt(1)) {
+      ASSERT(!c.is_probable_prime());
+    }
+  }
+}
+
+void test_fixed_int(TestObjs *objs) {
+  typedef FixedInt<256> U256;
+
+  // arithmetic is usable in constant expressions
+  constexpr U256 big_const = U256({ 0, 0, 0, 1 }) * U256(3) - U256(1);
+  static_assert(big_const.get_bits(3) == 2 && big_const.get_bits(0) == ~0UL, "constexpr arithmetic");
+  static_assert((big_const / U256({ 0, 1 })).get_bits(2) == 2 && (big_const % U256({ 0, 1 })) == U256(~0UL), "constexpr division");
+  static_assert((U256(1) << 255 >> 255) == U256(1), "constexpr shifts");
+  static_assert(sizeof(U256) == 32, "no storage beyond the limbs");
+
+  U256 a({ 0x8796a5b4c3d2e1f0UL, 0x0f1e2d3c4b5a6978UL, 0xfedcba9876543210UL, 0x0123456789abcdefUL });
+  U256 b({ 0x0123456789UL, 0xdeadbeefcafebabeUL, 0, 0 });
+
+  ASSERT(a.to_hex() == "123456789abcdeffedcba98765432100f1e2d3c4b5a69788796a5b4c3d2e1f0");
+  ASSERT(a.to_dec() == "514631507721405312519378913364952599457899916736173488040697764812573303280");
+  ASSERT((a * a).to_hex() == "7716581e4abf5e08c7baa363ddf38678695966af516b1a7db2d80b6b1527c100");
+  ASSERT((a / b).to_hex() == "14edb42704c8c4219ad9a8116400911");
+  ASSERT((a % b).to_hex() == "7f66ade601f86aba8f6f3d1b535330d7");
+  ASSERT((-a).to_hex() == "fedcba98765432100123456789abcdeff0e1d2c3b4a5968778695a4b3c2d1e10");
+  ASSERT((a << 77).to_hex() == "97530eca864201e3c5a7896b4d2f10f2d4b6987a5c3e00000000000000000000");
+  ASSERT((a >> 100).to_hex() == "123456789abcdeffedcba98765432100f1e2d3");
+  ASSERT((a + -a).is_zero());
+  ASSERT(U256().to_hex() == "0" && U256().to_dec() == "0");
+  ASSERT(U256(10000000000000000000UL).to_dec() == "10000000000000000000");
+
+  // wrap-around and comparisons
+  U256 max = U256() - U256(1);
+  ASSERT(max + U256(1) == U256());
+  ASSERT(max > a && a > b && b < a && a >= a && a != b);
+  ASSERT(max.is_bit_set(255) && !max.is_bit_set(256));
+
+  U256 c(a);
+  c += b;
+  c -= b;
+  c *= U256(7);
+  c /= U256(7);
+  ASSERT(c == a);
+  c %= b;
+  ASSERT(c == a % b);
+
+  try {
+    a / U256();
+    FAIL("division by zero should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  // conversion to and from BigInt agrees with BigInt arithmetic
+  BigInt big_a = a.to_bigint();
+  BigInt big_b = b.to_bigint();
+  ASSERT(big_a.to_dec() == a.to_dec());
+  ASSERT(U256(big_a * big_b) == a * b);
+  ASSERT((big_a / big_b) == (a / b).to_bigint());
+  ASSERT(U256(-big_b) == -b);
+  ASSERT(U256(objs->negative_three) == U256() - U256(3));
+  ASSERT(FixedInt<128>(objs->really_big_number).to_bigint() == BigInt({ 4UL, 7UL }));
+}
+
+void test_bigdecimal(TestObjs *) {
+  BigDecimal price = BigDecimal::from_string("19.99");
+  ASSERT(price.unscaled_value() == BigInt(1999) && price.scale() == 2);
+  ASSERT(price.to_string() == "19.99");
+  ASSERT(BigDecimal::from_string("-0.050").to_string() == "-0.050");
+  ASSERT(BigDecimal::from_string("-0.050").scale() == 3);
+  ASSERT(BigDecimal::from_string("42").to_string() == "42");
+  ASSERT(BigDecimal(BigInt(5, true), 4).to_string() == "-0.0005");
+  ASSERT(BigDecimal().to_string() == "0");
+
+  // exact arithmetic: sums take the larger scale, products the sum of scales
+  BigDecimal tax = BigDecimal::from_string("0.0825");
+  ASSERT((price + tax).to_string() == "20.0725");
+  ASSERT((price - tax).to_string() == "19.9075");
+  ASSERT((tax - price).to_string() == "-19.9075");
+  ASSERT((price * tax).to_string() == "1.649175");
+  BigDecimal total;
+  for (int i = 0; i < 1000; ++i) {
+    total += BigDecimal::from_string("0.01");
+  }
+  ASSERT(total.to_string() == "10.00");
+  total -= BigDecimal::from_string("10");
+  ASSERT(total == BigDecimal() && total.scale() == 2);
+  total *= price;
+  ASSERT(total.scale() == 4);
+
+  // numeric comparison ignores the scale
+  ASSERT(BigDecimal::from_string("1.5") == BigDecimal::from_string("1.50"));
+  ASSERT(BigDecimal::from_string("1.5") < BigDecimal::from_string("1.51"));
+  ASSERT(BigDecimal::from_string("-2") < BigDecimal::from_string("-1.999"));
+  ASSERT(BigDecimal::from_string("-0.1") < BigDecimal::from_string("0.01"));
+
+  // rounding modes, checked on the usual table of values
+  const char *values[] = { "5.5", "2.5", "1.6", "1.1", "1.0", "-1.0", "-1.1", "-1.6", "-2.5", "-5.5" };
+  const char *expected[][10] = {
+    { "5", "2", "1", "1", "1", "-1", "-1", "-1", "-2", "-5" },   // DOWN
+    { "6", "3", "2", "2", "1", "-1", "-2", "-2", "-3", "-6" },   // UP
+    { "5", "2", "1", "1", "1", "-1", "-2", "-2", "-3", "-6" },   // FLOOR
+    { "6", "3", "2", "2", "1", "-1", "-1", "-1", "-2", "-5" },   // CEILING
+    { "6", "3", "2", "1", "1", "-1", "-1", "-2", "-3", "-6" },   // HALF_UP
+    { "5", "2", "2", "1", "1", "-1", "-1", "-2", "-2", "-5" },   // HALF_DOWN
+    { "6", "2", "2", "1", "1", "-1", "-1", "-2", "-2", "-6" },   // HALF_EVEN
+  };
+  RoundingMode modes[] = { RoundingMode::DOWN, RoundingMode::UP, RoundingMode::FLOOR, RoundingMode::CEILING,
+                           RoundingMode::HALF_UP, RoundingMode::HALF_DOWN, RoundingMode::HALF_EVEN };
+  for (int m = 0; m < 7; ++m) {
+    for (int i = 0; i < 10; ++i) {
+      ASSERT(BigDecimal::from_string(values[i]).with_scale(0, modes[m]).to_string() == expected[m][i]);
+    }
+  }
+  ASSERT(price.with_scale(4).to_string() == "19.9900");
+
+  // division
+  BigDecimal one = BigDecimal::from_string("1.00");
+  BigDecimal three = BigDecimal::from_string("3");
+  ASSERT((one / three).to_string() == "0.33");
+  ASSERT(one.divide(three, 5, RoundingMode::UP).to_string() == "0.33334");
+  ASSERT(BigDecimal::from_string("-2").divide(three, 3, RoundingMode::HALF_EVEN).to_string() == "-0.667");
+  ASSERT(BigDecimal::from_string("1234.5678").divide(BigDecimal::from_string("0.01"), 0, RoundingMode::DOWN).to_string() == "123456");
+  ASSERT(BigDecimal::power_of_ten(45) == BigInt::from_dec("1" + std::string(45, '0')));
+
+  try {
+    one / BigDecimal::from_string("0.00");
+    FAIL("division by zero should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  for (const char *bad : { "", "-", ".5", "5.", "1.2.3", "1,5", "--1" }) {
+    try {
+      BigDecimal::from_string(bad);
+      FAIL("malformed decimal string should throw");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+}
+
+void test_bigrational(TestObjs *) {
+  BigRational half(BigInt(1), BigInt(2));
+  BigRational third(BigInt(1), BigInt(3));
+  ASSERT(BigRational(BigInt(6), BigInt(8, true)).to_string() == "-3/4");
+  ASSERT(BigRational(BigInt(6, true), BigInt(3, true)).to_string() == "2");
+  ASSERT(BigRational(BigInt(), BigInt(5, true)) == BigRational());
+  ASSERT(BigRational().denominator() == BigInt(1));
+
+  // results are always in lowest terms, so equal values compare equal field by field
+  ASSERT((half + third).to_string() == "5/6");
+  ASSERT((half - third).to_string() == "1/6");
+  ASSERT((third - half).to_string() == "-1/6");
+  ASSERT((half * third).to_string() == "1/6");
+  ASSERT((half / third).to_string() == "3/2");
+  ASSERT((third / -half).to_string() == "-2/3");
+  ASSERT((BigRational(BigInt(1), BigInt(6)) + BigRational(BigInt(1), BigInt(10))).to_string() == "4/15");
+  ASSERT((BigRational(BigInt(1), BigInt(6)) + BigRational(BigInt(1), BigInt(3))).to_string() == "1/2");
+  ASSERT((BigRational(BigInt(5), BigInt(6)) + BigRational(BigInt(1), BigInt(6))).to_string() == "1");
+  ASSERT((BigRational(BigInt(4), BigInt(9)) * BigRational(BigInt(3), BigInt(8))).to_string() == "1/6");
+  ASSERT((half * BigRational()) == BigRational());
+  ASSERT((BigRational(BigInt(7)) + half).to_string() == "15/2");
+  ASSERT((half + BigRational(BigInt(7))).to_string() == "15/2");
+  BigRational x = half;
+  x += x;
+  ASSERT(x.is_integer() && x.numerator() == BigInt(1));
+  x -= x;
+  ASSERT(x == BigRational());
+
+  // adding 1/k for k = 1..30 in every order of operations gives the same canonical value
+  BigRational sum, check;
+  for (unsigned k = 1; k <= 30; ++k) {
+    sum += BigRational(BigInt(1), BigInt(k));
+  }
+  BigInt lcm(1), num;
+  for (unsigned k = 1; k <= 30; ++k) {
+    lcm = lcm.lcm(BigInt(k));
+  }
+  for (unsigned k = 1; k <= 30; ++k) {
+    num += lcm / BigInt(k);
+  }
+  ASSERT(sum == BigRational(num, lcm));
+  ASSERT(sum.numerator().gcd(sum.denominator()) == BigInt(1));
+
+  ASSERT(half < BigRational(BigInt(2), BigInt(3)));
+  ASSERT(-half < third);
+  ASSERT(BigRational(BigInt(7), BigInt(3)) > BigRational(BigInt(2)));
+
+  // strings, decimals and rounding
+  ASSERT(BigRational::from_string("10/-4").to_string() == "-5/2");
+  ASSERT(BigRational::from_string("-1.25").to_string() == "-5/4");
+  ASSERT(BigRational::from_string("12") == BigRational(BigInt(12)));
+  ASSERT(BigRational(BigDecimal::from_string("0.50")) == half);
+  ASSERT(BigRational::from_string("-5/2").round(RoundingMode::HALF_EVEN) == BigInt(2, true));
+  ASSERT(BigRational::from_string("-5/2").round(RoundingMode::FLOOR) == BigInt(3, true));
+  ASSERT(BigRational::from_string("2/3").to_decimal(4, RoundingMode::HALF_UP).to_string() == "0.6667");
+  ASSERT(BigRational::from_string("-2/3").to_decimal(2, RoundingMode::DOWN).to_string() == "-0.66");
+
+  try {
+    BigRational(BigInt(1), BigInt());
+    FAIL("a zero denominator should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    half / BigRational();
+    FAIL("division by zero should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    BigRational::from_string("1/0");
+    FAIL("a zero denominator should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_bigint_batch(TestObjs *objs) {
+  // element-wise results must match BigInt arithmetic modulo 2^(64 * width),
+  // with both the portable and the vector kernels, for batch sizes that
+  // leave partial vectors, and for values that carry through every limb
+  for (int portable = 0; portable < 2; ++portable) {
+    limb_use_portable_kernels(portable);
+    for (size_t width : { 1, 2, 4 }) {
+      BigInt modulus = BigInt(1) << unsigned(64 * width);
+      for (size_t count : { 1, 3, 4, 8, 13 }) {
+        std::vector<BigInt> left, right;
+        for (size_t j = 0; j < count; ++j) {
+          left.push_back(j % 3 == 0 ? modulus - objs->one : random_bigint(width, 100 * width + j));
+          right.push_back(j % 4 == 1 ? objs->one : random_bigint(width - (j % width), 200 * width + j));
+        }
+        right[count / 2] = left[count / 2];
+
+        BigIntBatch a(left, width), b(right, width);
+        BigIntBatch sum = a + b, difference = a - b, product = a * b;
+        BigIntBatch full = a.mul_full(b);
+        std::vector<int> order = a.compare(b);
+        ASSERT(sum.size() == count && sum.width() == width && full.width() == 2 * width);
+
+        for (size_t j = 0; j < count; ++j) {
+          ASSERT(a.get(j) == left[j]);
+          ASSERT(sum.get(j) == (left[j] + right[j]).mod(modulus));
+          ASSERT(difference.get(j) == (left[j] - right[j]).mod(modulus));
+          ASSERT(product.get(j) == (left[j] * right[j]).mod(modulus));
+          ASSERT(full.get(j) == left[j] * right[j]);
+          ASSERT(order[j] == left[j].compare(right[j]));
+        }
+      }
+    }
+  }
+  limb_use_portable_kernels(false);
+
+  // negative values are stored in two's complement
+  BigIntBatch batch(3, 2);
+  batch.set(0, objs->negative_nine);
+  batch.set(1, -objs->two_pow_64_plus_one);
+  batch.set(2, objs->two_pow_64_plus_one << 64); // 2^128 + 2^64 wraps to 2^64
+  ASSERT(batch.get(0) == (BigInt(1) << 128) - objs->nine);
+  ASSERT(batch.get(1) == (BigInt(1) << 128) - objs->two_pow_64_plus_one);
+  ASSERT(batch.get(2) == BigInt(1) << 64);
+  ASSERT(batch.limb_row(0)[0] == 0xFFFFFFFFFFFFFFF7UL);
+
+  // compound operators, resizing and conversion back
+  BigIntBatch ones(std::vector<BigInt>(3, objs->one), 2);
+  batch += ones;
+  ASSERT(batch.get(0) == (BigInt(1) << 128) - BigInt(8));
+  batch -= ones;
+  batch *= ones;
+  ASSERT(batch.get(1) == (BigInt(1) << 128) - objs->two_pow_64_plus_one);
+  BigIntBatch narrow = batch.resized(1);
+  ASSERT(narrow.width() == 1 && narrow.get(1) == objs->u64_max);
+  ASSERT(narrow.resized(3).get(0) == BigInt(0xFFFFFFFFFFFFFFF7UL));
+  std::vector<BigInt> values = batch.to_bigints();
+  ASSERT(values.size() == 3 && values[2] == BigInt(1) << 64);
+
+  try {
+    batch + narrow;
+    FAIL("adding batches of different widths should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
 void test_to_hex_1(TestObjs *objs) {
   // some basic tests for to_hex()
 
@@ -626,6 +2163,54 @@ void test_to_hex_2(TestObjs *) {
 
 }
 
+void test_from_hex(TestObjs *objs) {
+  ASSERT(BigInt::from_hex("0") == objs->zero);
+  ASSERT(BigInt::from_hex("-0") == objs->zero);
+  ASSERT(!BigInt::from_hex("-0").is_negative());
+  ASSERT(BigInt::from_hex("-9") == objs->negative_nine);
+  ASSERT(BigInt::from_hex("FfFfFfFfFfFfFfFf") == objs->u64_max);
+  ASSERT(BigInt::from_hex("0000000000000000000000010000000000000001") == objs->two_pow_64_plus_one);
+  ASSERT(BigInt::from_hex("0000000000000000000000010000000000000001").get_bit_vector().size() == 2);
+  ASSERT(BigInt::from_hex("-10000000000000101") == -objs->two_pow_64_plus_hex);
+
+  // round trips for every digit count up to a few limbs, both signs
+  BigInt big = random_bigint(5, 17);
+  for (unsigned bits = 0; bits <= 320; bits += 3) {
+    BigInt value = big / (BigInt(1) << bits);
+    std::string hex = value.to_hex();
+    ASSERT(BigInt::from_hex(hex) == value);
+    ASSERT(BigInt::from_hex("-" + hex) == -value);
+    ASSERT(hex.size() == value.hex_length());
+  }
+
+  // formatting into a caller's buffer
+  {
+    char buf[40];
+    std::string expected = objs->negative_three.to_hex() + (-objs->two_pow_64_plus_one).to_hex();
+    size_t len = objs->negative_three.to_hex(buf, sizeof(buf));
+    len += (-objs->two_pow_64_plus_one).to_hex(buf + len, sizeof(buf) - len);
+    ASSERT(std::string(buf, len) == expected);
+    ASSERT(BigInt::from_hex(buf, 2) == objs->negative_three);
+
+    try {
+      objs->u64_max.to_hex(buf, 15);
+      FAIL("formatting into a buffer that is too small should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+
+  const char *bad[] = { "", "-", "0x10", "12g4", "1 2", "--1", "123456789abcdef0123456789abcdef0z" };
+  for (const char *str : bad) {
+    try {
+      BigInt::from_hex(str);
+      FAIL("parsing an invalid hex string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+}
+
 void test_to_dec_1(TestObjs *objs) {
   // some basic tests for to_dec()
   std::string result1 = objs->three.to_dec();
@@ -647,6 +2232,376 @@ void test_to_dec_2(TestObjs *) {
   }
 }
 
+void test_to_dec_3(TestObjs *objs) {
+  // large values take the divide-and-conquer path
+
+  {
+    // 10^2000 is a 1 followed by zeroes, so every low half is all padding
+    BigInt power = objs->one;
+    for (int i = 0; i < 2000; ++i) {
+      power = power * BigInt(10);
+    }
+    ASSERT("1" + std::string(2000, '0') == power.to_dec());
+    ASSERT(std::string(2000, '9') == (power - objs->one).to_dec());
+    ASSERT("-1" + std::string(1999, '0') + "1" == (-power - objs->one).to_dec());
+  }
+
+  {
+    // the digit count of 2^(64k) - 1 only depends on k
+    BigInt val = (objs->one << (64 * 300)) - objs->one;
+    std::string result = val.to_dec();
+    ASSERT(5780 == result.size());
+    ASSERT("59692" == result.substr(0, 5));
+    ASSERT("41375" == result.substr(result.size() - 5));
+  }
+}
+
+void test_from_dec(TestObjs *objs) {
+  ASSERT(BigInt::from_dec("0") == objs->zero);
+  ASSERT(!BigInt::from_dec("-0").is_negative());
+  ASSERT(BigInt::from_dec("-9") == objs->negative_nine);
+  ASSERT(BigInt::from_dec("0000018446744073709551615") == objs->u64_max);
+  ASSERT(BigInt::from_dec("18446744073709551616") == objs->two_pow_64);
+  check_contents(BigInt::from_dec("703527900324720116021349050368162523567079645895"),
+                 {0x361adeb15b6962c7UL, 0x31a5b3c012d2a685UL, 0x7b3b4839UL});
+
+  // round trips across the basecase and recursive sizes
+  size_t sizes[] = { 1, 2, 3, 17, 59, 60, 61, 130, 257, 600 };
+  for (size_t n : sizes) {
+    BigInt val = random_bigint(n, n * 31);
+    ASSERT(BigInt::from_dec(val.to_dec()) == val);
+    ASSERT(BigInt::from_dec((-val).to_dec()) == -val);
+  }
+
+  const char *bad[] = { "", "-", "12a4", " 12", "+5", "--3" };
+  for (const char *str : bad) {
+    try {
+      BigInt::from_dec(str);
+      FAIL("parsing an invalid decimal string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+}
+
+void test_radix_strings(TestObjs *objs) {
+  ASSERT(objs->zero.to_string(2) == "0");
+  ASSERT(objs->negative_nine.to_string(2) == "-1001");
+  ASSERT(objs->negative_nine.to_string(8) == "-11");
+  ASSERT(objs->negative_nine.to_string(10) == "-9");
+  ASSERT(objs->u64_max.to_string(16) == "ffffffffffffffff");
+  ASSERT(objs->u64_max.to_string(32) == "fvvvvvvvvvvvv");
+  ASSERT(objs->u64_max.to_string(36) == "3w5e11264sgsf");
+  ASSERT(objs->two_pow_64.to_string(2) == "1" + std::string(64, '0'));
+  ASSERT(objs->two_pow_64.to_string(8) == "2" + std::string(21, '0'));
+  ASSERT(BigInt::from_string("3W5E11264SGSF", 36) == objs->u64_max);
+  ASSERT(BigInt::from_string("-zz", 36) == BigInt(1295, true));
+  ASSERT(!BigInt::from_string("-000", 7).is_negative());
+  ASSERT(BigInt::from_string("1" + std::string(64, '0'), 2) == objs->two_pow_64);
+  ASSERT(BigInt::from_string("-FfFfFfFfFfFfFfFf", 16) == -objs->u64_max);
+  ASSERT(!BigInt::from_string("-0", 16).is_negative());
+
+  // round trips in every radix across the basecase and recursive sizes
+  size_t sizes[] = { 1, 2, 3, 59, 61, 130, 300 };
+  for (unsigned radix = 2; radix <= 36; ++radix) {
+    for (size_t n : sizes) {
+      BigInt val = random_bigint(n, n * 37 + radix);
+      ASSERT(BigInt::from_string(val.to_string(radix), radix) == val);
+      ASSERT(BigInt::from_string((-val).to_string(radix), radix) == -val);
+    }
+  }
+
+  // digit strings that are mostly zeroes exercise the padding of low halves
+  BigInt sparse = (BigInt(1) << 9000) + BigInt(7);
+  ASSERT(BigInt::from_string(sparse.to_string(3), 3) == sparse);
+  ASSERT(sparse.to_string(10) == sparse.to_dec());
+
+  // powers are cached and shared across calls
+  size_t levels = RadixPowers::cached_levels(10);
+  ASSERT(levels > 0);
+  random_bigint(300, 5).to_dec();
+  ASSERT(RadixPowers::cached_levels(10) == levels);
+  const BigInt *const *powers = RadixPowers::get(10, 3);
+  ASSERT(*powers[0] == BigInt(10000000000000000000UL));
+  ASSERT(*powers[2] == powers[1]->pow(2));
+  ASSERT(RadixPowers::get(10, 3)[2] == powers[2]);
+  ASSERT(RadixPowers::get(10, 1) == powers);
+
+  // threads growing the tables of several radices at once all get
+  // correct powers
+  BigInt wide = random_bigint(400, 77);
+  std::vector<std::string> texts(8);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 8; ++t) {
+    threads.emplace_back([&wide, &texts, t] { texts[t] = wide.to_string(3 + t % 4); });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (unsigned t = 0; t < 8; ++t) {
+    ASSERT(BigInt::from_string(texts[t], 3 + t % 4) == wide);
+    ASSERT(texts[t] == texts[t % 4]);
+  }
+
+  unsigned bad_radices[] = { 0, 1, 37 };
+  for (unsigned radix : bad_radices) {
+    try {
+      objs->one.to_string(radix);
+      FAIL("converting to an invalid radix should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+    try {
+      BigInt::from_string("1", radix);
+      FAIL("parsing in an invalid radix should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+  const char *bad[] = { "", "-", "102", "1 0", "+1", "1-" };
+  for (const char *str : bad) {
+    try {
+      BigInt::from_string(str, 2);
+      FAIL("parsing an invalid binary string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+  const char *bad_hex[] = { "", "-", "g", "1-0" };
+  for (const char *str : bad_hex) {
+    try {
+      BigInt::from_string(str, 16);
+      FAIL("parsing an invalid hex string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+  try {
+    BigInt::from_string("z", 35);
+    FAIL("parsing a digit beyond the radix should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_encode_decode(TestObjs *objs) {
+  // exact bytes: sign, varint limb count, little-endian limbs
+  {
+    uint8_t buf[32];
+    ASSERT(objs->zero.encode(buf, sizeof(buf)) == 2);
+    ASSERT(buf[0] == 0 && buf[1] == 0);
+    ASSERT(objs->multiple_zeros.encoded_size() == 2);
+
+    ASSERT(objs->negative_nine.encode(buf, sizeof(buf)) == 10);
+    const uint8_t expected[] = { 1, 1, 9, 0, 0, 0, 0, 0, 0, 0 };
+    ASSERT(std::equal(expected, expected + 10, buf));
+
+    ASSERT(objs->two_pow_64_plus_one.encode(buf, sizeof(buf)) == 18);
+    ASSERT(buf[1] == 2 && buf[2] == 1 && buf[10] == 1);
+  }
+
+  // many values back to back in one buffer, including one whose limb
+  // count needs a two-byte varint
+  std::vector<BigInt> values = { objs->zero, objs->one, objs->negative_nine, objs->u64_max,
+                                 -objs->two_pow_64_plus_one, random_bigint(200, 5), -random_bigint(3, 6) };
+  size_t total = 0;
+  for (const BigInt &value : values) {
+    total += value.encoded_size();
+  }
+  ASSERT(values[5].encoded_size() == 1 + 2 + 8 * 200);
+
+  std::vector<uint8_t> buf(total + 1);
+  size_t pos = 1; // start at an odd address: decode needs no alignment
+  for (const BigInt &value : values) {
+    pos += value.encode(buf.data() + pos, buf.size() - pos);
+  }
+  ASSERT(pos == buf.size());
+
+  pos = 1;
+  for (const BigInt &value : values) {
+    size_t consumed = 0;
+    BigInt decoded = BigInt::decode(buf.data() + pos, buf.size() - pos, &consumed);
+    ASSERT(decoded == value);
+    ASSERT(decoded.get_bit_vector() == value.get_bit_vector());
+    ASSERT(consumed == value.encoded_size());
+    pos += consumed;
+  }
+
+  // leading zero limbs and a negative zero are accepted and normalized
+  {
+    const uint8_t padded[] = { 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    BigInt decoded = BigInt::decode(padded, sizeof(padded));
+    ASSERT(decoded == objs->zero);
+    ASSERT(!decoded.is_negative());
+    ASSERT(decoded.get_bit_vector().size() == 0);
+  }
+
+  // malformed input
+  const uint8_t truncated[] = { 0, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1 };
+  const uint8_t bad_sign[] = { 2, 0 };
+  const uint8_t endless_varint[] = { 0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  const uint8_t *bad_inputs[] = { truncated, bad_sign, endless_varint };
+  size_t bad_sizes[] = { sizeof(truncated), sizeof(bad_sign), sizeof(endless_varint) };
+  for (size_t i = 0; i < 3; ++i) {
+    try {
+      BigInt::decode(bad_inputs[i], bad_sizes[i]);
+      FAIL("decoding a malformed value should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+
+  try {
+    uint8_t small[9];
+    objs->u64_max.encode(small, sizeof(small));
+    FAIL("encoding into a buffer that is too small should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_bigint_view(TestObjs *objs) {
+  // views of BigInt values and of plain limb arrays
+  BigInt big = random_bigint(50, 9);
+  BigIntView view(big);
+  ASSERT(view.get_bit_vector().data() == big.get_bit_vector().data());
+  ASSERT(view.to_bigint() == big);
+  ASSERT(BigInt(view) == big);
+
+  uint64_t limbs[] = { 9, 0, 0 };
+  BigIntView nine(limbs, 3);
+  ASSERT(nine.get_bit_vector().size() == 1);
+  ASSERT(nine == BigIntView(objs->nine));
+  ASSERT(BigIntView(limbs, 3, true) == BigIntView(objs->negative_nine));
+  ASSERT(BigIntView(limbs, 0, true) == BigIntView());
+  ASSERT(!BigIntView(limbs, 0, true).is_negative());
+  ASSERT(BigIntView(objs->negative_nine) < BigIntView(objs->negative_three));
+  ASSERT(BigIntView(objs->negative_three) < BigIntView(objs->zero));
+  ASSERT(BigIntView(objs->nine) < BigIntView(objs->two_pow_64_plus_one));
+  ASSERT(view.encoded_size() == big.encoded_size());
+
+  // an encoded value whose limbs land on an 8-byte boundary is viewed in
+  // place, as it would be in a memory-mapped file
+  std::vector<uint64_t> storage(60);
+  uint8_t *bytes = reinterpret_cast<uint8_t *>(storage.data());
+  size_t header = big.encoded_size() - 8 * 50; // 2 bytes
+  size_t written = big.encode(bytes + 8 - header, 8 * storage.size() - (8 - header));
+  size_t consumed = 0;
+  BigIntView decoded = BigIntView::decode(bytes + 8 - header, written, &consumed);
+  ASSERT(consumed == written);
+  ASSERT(decoded.get_bit_vector().data() == storage.data() + 1);
+  ASSERT(decoded.to_bigint() == big);
+
+  // zero has no limbs, so any address works
+  ASSERT(objs->zero.encode(bytes + 3, 2) == 2);
+  ASSERT(BigIntView::decode(bytes + 3, 2).is_zero());
+
+  big.encode(bytes + 1, 8 * storage.size() - 1);
+  ASSERT(BigInt::decode(bytes + 1, written) == big);
+  try {
+    BigIntView::decode(bytes + 1, written);
+    FAIL("viewing misaligned limbs should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_sort_key(TestObjs *objs) {
+  // exact bytes: class byte, big-endian count and limbs, complemented
+  // for negative values
+  {
+    uint8_t buf[32];
+    ASSERT(objs->zero.write_sort_key(buf, sizeof(buf)) == 1);
+    ASSERT(buf[0] == 0x01);
+
+    ASSERT(objs->nine.write_sort_key(buf, sizeof(buf)) == 17);
+    const uint8_t nine[] = { 2, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 9 };
+    ASSERT(std::equal(nine, nine + 17, buf));
+
+    ASSERT(objs->negative_nine.write_sort_key(buf, sizeof(buf)) == 17);
+    for (size_t i = 1; i < 17; ++i) {
+      ASSERT(buf[i] == uint8_t(~nine[i]));
+    }
+    ASSERT(buf[0] == 0x00);
+
+    ASSERT(objs->two_pow_64_plus_one.sort_key_size() == 25);
+    std::string key = objs->two_pow_64_plus_one.sort_key();
+    ASSERT(key.size() == 25);
+    ASSERT(key[8] == 2 && key[16] == 1 && key[24] == 1);
+  }
+
+  // keys sort in the same order as the values, across signs and lengths
+  std::vector<BigInt> values = { objs->zero, objs->one, objs->negative_nine, objs->u64_max,
+                                 -objs->u64_max, objs->two_pow_64_plus_one, -objs->two_pow_64_plus_one };
+  for (int i = 0; i < 200; ++i) {
+    BigInt value = random_bigint(1 + test_random() % 4, test_random());
+    if (test_random() % 4 == 0) {
+      value >>= unsigned(test_random() % 64);
+    }
+    values.push_back(test_random() % 2 ? -value : value);
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    std::string key_i = values[i].sort_key();
+    for (size_t j = 0; j < values.size(); ++j) {
+      int value_cmp = values[i].compare(values[j]);
+      int key_cmp = key_i.compare(values[j].sort_key());
+      ASSERT((value_cmp < 0) == (key_cmp < 0));
+      ASSERT((value_cmp == 0) == (key_cmp == 0));
+    }
+  }
+
+  // keys written back to back read back in order
+  std::vector<uint8_t> buf;
+  for (const BigInt &value : values) {
+    size_t pos = buf.size();
+    buf.resize(pos + value.sort_key_size());
+    ASSERT(value.write_sort_key(buf.data() + pos, buf.size() - pos) == value.sort_key_size());
+  }
+  size_t pos = 0;
+  for (const BigInt &value : values) {
+    size_t consumed = 0;
+    BigInt decoded = BigInt::from_sort_key(buf.data() + pos, buf.size() - pos, &consumed);
+    ASSERT(decoded == value);
+    ASSERT(consumed == value.sort_key_size());
+    pos += consumed;
+  }
+  ASSERT(pos == buf.size());
+
+  // equal values hash equally, whether held in a BigInt or viewed
+  std::unordered_set<BigInt> seen(values.begin(), values.end());
+  for (const BigInt &value : values) {
+    ASSERT(seen.count(value) == 1);
+    ASSERT(std::hash<BigInt>()(value) == std::hash<BigIntView>()(BigIntView(value)));
+  }
+  uint64_t limbs[] = { 9, 0 };
+  ASSERT(objs->nine.hash() == BigIntView(limbs, 2).hash());
+  ASSERT(objs->nine.hash() != objs->negative_nine.hash());
+  ASSERT(seen.count(objs->nine) == 0);
+
+  // malformed input
+  const uint8_t bad_class[] = { 3 };
+  const uint8_t truncated[] = { 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 1 };
+  const uint8_t zero_count[] = { 2, 0, 0, 0, 0, 0, 0, 0, 0 };
+  const uint8_t *bad_inputs[] = { bad_class, truncated, zero_count };
+  size_t bad_sizes[] = { sizeof(bad_class), sizeof(truncated), sizeof(zero_count) };
+  for (size_t i = 0; i < 3; ++i) {
+    try {
+      BigInt::from_sort_key(bad_inputs[i], bad_sizes[i]);
+      FAIL("reading a malformed sort key should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+
+  try {
+    uint8_t small[16];
+    objs->nine.write_sort_key(small, sizeof(small));
+    FAIL("writing a sort key into a buffer that is too small should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
 void hw_1_to_hex_tests(TestObjs *objs){
   std::string result1 = objs->zero.to_hex();
   ASSERT("0" == result1);
@@ -699,7 +2654,8 @@ void hw1_get_bits_get_bit_vector_tests(TestObjs *objs){
 
   ASSERT(0UL == objs->multiple_zeros.get_bits(0));
   ASSERT(0UL == objs->multiple_zeros.get_bits(4));
-  ASSERT((objs->multiple_zeros.get_bit_vector() == std::vector<uint64_t>{0, 0, 0}));;
+  // leading zero limbs are dropped at construction, leaving no limbs for 0
+  ASSERT((objs->multiple_zeros.get_bit_vector() == std::vector<uint64_t>{}));
 
   ASSERT(257UL == objs->two_pow_64_plus_hex.get_bits(0));
   ASSERT(1UL == objs->two_pow_64_plus_hex.get_bits(1));
@@ -746,6 +2702,12 @@ void hw1_addition_tests(TestObjs *objs) {
   //2^64 + 2^64 = 2^65
   ASSERT(objs->two_pow_64 + objs->two_pow_64 == objs->two_pow_65);
 
+  //Edge case: carry rippling through a limb where rhs + carry wraps around
+  BigInt almost_two_pow_128({0xFFFFFFFFFFFFFFFEUL, 0xFFFFFFFFFFFFFFFFUL});
+  check_contents(almost_two_pow_128 + objs->two, {0UL, 0UL, 1UL});
+  check_contents(objs->two + almost_two_pow_128, {0UL, 0UL, 1UL});
+  check_contents(BigInt({0UL, 0UL, 1UL}) - objs->two, {0xFFFFFFFFFFFFFFFEUL, 0xFFFFFFFFFFFFFFFFUL});
+
 
 }
 
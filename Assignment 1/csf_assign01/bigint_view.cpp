@@ -0,0 +1,175 @@
+#include <cstring>
+#include <stdexcept>
+#include "bigint_view.h"
+
+//Limbs are copied as raw memory where the byte order matches the encoding
+static const bool LITTLE_ENDIAN_HOST = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+//A varint holding a size_t needs at most 10 bytes of 7 bits
+static const size_t MAX_VARINT_BYTES = 10;
+
+//Constructor, leaves out leading zero limbs
+BigIntView::BigIntView(const uint64_t *limbs, size_t count, bool negative) : limbs(limbs), count(count), negative(negative) {
+  while (this->count > 0 && limbs[this->count - 1] == 0) {
+    --this->count;
+  }
+  if (this->count == 0) {
+    this->negative = false;
+  }
+}
+
+//Compares signs first, then lengths, then limbs from the most significant
+int BigIntView::compare(const BigIntView &rhs) const {
+  if (negative != rhs.negative) {
+    return negative ? -1 : 1;
+  }
+
+  int magnitude_cmp = 0;
+  if (count != rhs.count) {
+    magnitude_cmp = count > rhs.count ? 1 : -1;
+  } else {
+    for (size_t i = count; i > 0; --i) {
+      if (limbs[i - 1] != rhs.limbs[i - 1]) {
+        magnitude_cmp = limbs[i - 1] > rhs.limbs[i - 1] ? 1 : -1;
+        break;
+      }
+    }
+  }
+  return negative ? -magnitude_cmp : magnitude_cmp;
+}
+
+size_t BigIntView::encoded_size() const {
+  size_t varint_bytes = 1;
+  for (size_t n = count; n >= 0x80; n >>= 7) {
+    ++varint_bytes;
+  }
+  return 1 + varint_bytes + 8 * count;
+}
+
+size_t BigIntView::encode(uint8_t *out, size_t capacity) const {
+  size_t total = encoded_size();
+  if (capacity < total) {
+    throw std::invalid_argument("Buffer too small for encoded BigInt");
+  }
+
+  uint8_t *p = out;
+  *p++ = negative ? 1 : 0;
+  size_t n = count;
+  while (n >= 0x80) {
+    *p++ = uint8_t(n | 0x80);
+    n >>= 7;
+  }
+  *p++ = uint8_t(n);
+
+  if (LITTLE_ENDIAN_HOST) {
+    if (count > 0) {
+      std::memcpy(p, limbs, 8 * count);
+    }
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      for (unsigned byte = 0; byte < 8; ++byte) {
+        p[8 * i + byte] = uint8_t(limbs[i] >> (8 * byte));
+      }
+    }
+  }
+  return total;
+}
+
+//Stores a 64-bit value most significant byte first
+static void store_big_endian(uint8_t *p, uint64_t value) {
+  for (unsigned byte = 8; byte > 0; --byte) {
+    p[byte - 1] = uint8_t(value);
+    value >>= 8;
+  }
+}
+
+//Writes the class byte, then the count and the limbs from the most
+//significant, XORing every byte with 0xFF for negative values
+size_t BigIntView::write_sort_key(uint8_t *out, size_t capacity) const {
+  size_t total = sort_key_size();
+  if (capacity < total) {
+    throw std::invalid_argument("Buffer too small for BigInt sort key");
+  }
+  if (count == 0) {
+    out[0] = 0x01;
+    return total;
+  }
+
+  uint64_t flip = negative ? UINT64_MAX : 0;
+  out[0] = negative ? 0x00 : 0x02;
+  store_big_endian(out + 1, uint64_t(count) ^ flip);
+  uint8_t *p = out + 9;
+  for (size_t i = count; i > 0; --i) {
+    store_big_endian(p, limbs[i - 1] ^ flip);
+    p += 8;
+  }
+  return total;
+}
+
+//Multiplies and folds in one limb at a time, then mixes the result the
+//way splitmix64 finishes, so nearby values spread over all the bits
+size_t BigIntView::hash() const {
+  const uint64_t K = 0x9E3779B97F4A7C15ULL;
+  uint64_t h = uint64_t(count) * K ^ (negative ? 0xD6E8FEB86659FD93ULL : 0);
+  for (size_t i = 0; i < count; ++i) {
+    h = (h ^ limbs[i]) * K;
+    h ^= h >> 32;
+  }
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return size_t(h);
+}
+
+//Reads the sign byte and the varint, then checks that the limbs fit
+size_t BigIntView::decode_header(const uint8_t *in, size_t size, bool &negative, size_t &count) {
+  if (size < 2) {
+    throw std::invalid_argument("Truncated BigInt encoding");
+  }
+  if (in[0] > 1) {
+    throw std::invalid_argument("Invalid sign byte in BigInt encoding");
+  }
+  negative = (in[0] == 1);
+
+  size_t pos = 1;
+  count = 0;
+  for (unsigned shift = 0; ; shift += 7) {
+    if (pos >= size) {
+      throw std::invalid_argument("Truncated BigInt encoding");
+    }
+    if (pos > MAX_VARINT_BYTES) {
+      throw std::invalid_argument("Limb count too large in BigInt encoding");
+    }
+    uint8_t byte = in[pos++];
+    uint64_t group = byte & 0x7F;
+    if (shift >= 64 || (shift > 0 && (group >> (64 - shift)) != 0)) {
+      throw std::invalid_argument("Limb count too large in BigInt encoding");
+    }
+    count |= size_t(group << shift);
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+
+  if (count > (size - pos) / 8) {
+    throw std::invalid_argument("Truncated BigInt encoding");
+  }
+  return pos;
+}
+
+BigIntView BigIntView::decode(const uint8_t *in, size_t size, size_t *consumed) {
+  bool negative;
+  size_t count;
+  size_t header = decode_header(in, size, negative, count);
+  const uint8_t *limb_bytes = in + header;
+
+  if (count > 0 && (!LITTLE_ENDIAN_HOST || reinterpret_cast<uintptr_t>(limb_bytes) % alignof(uint64_t) != 0)) {
+    throw std::invalid_argument("Encoded limbs cannot be viewed in place");
+  }
+  if (consumed) {
+    *consumed = header + 8 * count;
+  }
+  return BigIntView(reinterpret_cast<const uint64_t *>(limb_bytes), count, negative);
+}
@@ -0,0 +1,160 @@
+#ifndef BIGINT_VIEW_H
+#define BIGINT_VIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "bigint.h"
+#include "limb_vector.h"
+
+//! @file
+//! Non-owning views of BigInt values and the binary encoding of BigInt.
+//!
+//! The encoding of a value is
+//!   - one sign byte: 0 for non-negative values, 1 for negative values
+//!   - the number of limbs `n` as an unsigned LEB128 varint (7 bits per
+//!     byte, least significant group first, high bit set on every byte
+//!     but the last)
+//!   - `n` limbs of 8 bytes each, least significant limb first, and
+//!     each limb in little-endian byte order
+//!
+//! Encoders write no leading zero limbs, so 0 is the two bytes `00 00`
+//! and every value has exactly one encoding. Decoders accept leading
+//! zero limbs and ignore the sign of 0. Encoded values carry their own
+//! length, so several of them can be written back to back into one
+//! buffer and read back in order.
+//!
+//! Values also have a sort key, a second byte string built so that
+//! comparing two keys bytewise (memcmp, or std::string comparison) gives
+//! the same order as comparing the values. The key of a value is
+//!   - one class byte: 0x00 for negative values, 0x01 for 0 and 0x02
+//!     for positive values
+//!   - for nonzero values, the number of limbs `n` as 8 bytes, most
+//!     significant byte first
+//!   - `n` limbs of 8 bytes each, most significant limb first, and each
+//!     limb in big-endian byte order
+//! and the count and limb bytes of a negative value are complemented,
+//! so larger magnitudes sort first. 0 is the single byte `01`. Keys of
+//! values with the same sign and length have the same length, so a key
+//! is never a proper prefix of another, and radix sorts can work on the
+//! 9-byte header first and only look at limbs within equal headers.
+
+//! Read-only view of an integer whose limbs live somewhere else: in a
+//! BigInt, in a caller's array, or in an encoded buffer (for example a
+//! memory-mapped file). A view never copies or owns the limbs and is
+//! only valid as long as they stay alive and unmodified. Convert it to a
+//! BigInt to do arithmetic with it.
+class BigIntView {
+private:
+  const uint64_t *limbs;
+  size_t count;
+  bool negative;
+
+public:
+  //! Default constructor: a view of the value 0.
+  BigIntView() : limbs(nullptr), count(0), negative(false) { }
+
+  //! Constructor from an array of limbs. Leading zero limbs are left out
+  //! of the view, and a view of 0 is never negative.
+  //!
+  //! @param limbs pointer to the first (least significant) limb
+  //! @param count number of limbs
+  //! @param negative if true, the value is negative
+  BigIntView(const uint64_t *limbs, size_t count, bool negative = false);
+
+  //! Constructor from a BigInt, viewing its limbs.
+  //!
+  //! @param value the BigInt to view; it must outlive the view
+  BigIntView(const BigInt &value) : BigIntView(value.get_bit_vector().data(), value.get_bit_vector().size(), value.is_negative()) { }
+
+  //! @return true if the value is negative
+  bool is_negative() const { return negative; }
+
+  //! @return true if the value is 0
+  bool is_zero() const { return count == 0; }
+
+  //! @return the limbs, without leading zero limbs
+  LimbView get_bit_vector() const { return LimbView(limbs, count); }
+
+  //! @param index the index of the limb (0 for the least significant)
+  //! @return the limb at `index`, or 0 if `index` is past the last limb
+  uint64_t get_bits(size_t index) const { return index < count ? limbs[index] : 0; }
+
+  //! Copy the value into a BigInt.
+  //!
+  //! @return the BigInt with the same value
+  BigInt to_bigint() const { return BigInt(*this); }
+
+  //! Compare two values, returning negative, 0 or positive if this
+  //! value is less than, equal to or greater than `rhs`.
+  int compare(const BigIntView &rhs) const;
+
+  bool operator==(const BigIntView &rhs) const { return compare(rhs) == 0; }
+  bool operator!=(const BigIntView &rhs) const { return compare(rhs) != 0; }
+  bool operator<(const BigIntView &rhs) const  { return compare(rhs) < 0; }
+  bool operator<=(const BigIntView &rhs) const { return compare(rhs) <= 0; }
+  bool operator>(const BigIntView &rhs) const  { return compare(rhs) > 0; }
+  bool operator>=(const BigIntView &rhs) const { return compare(rhs) >= 0; }
+
+  //! @return the number of bytes encode() writes for this value
+  size_t encoded_size() const;
+
+  //! Write the encoding of this value into a buffer.
+  //!
+  //! @param out the buffer
+  //! @param capacity the size of the buffer in bytes
+  //! @return the number of bytes written, i.e. encoded_size()
+  //! @throw std::invalid_argument if the buffer is too small
+  size_t encode(uint8_t *out, size_t capacity) const;
+
+  //! @return the number of bytes write_sort_key() writes for this value
+  size_t sort_key_size() const { return count == 0 ? 1 : 9 + 8 * count; }
+
+  //! Write the sort key of this value into a buffer.
+  //!
+  //! @param out the buffer
+  //! @param capacity the size of the buffer in bytes
+  //! @return the number of bytes written, i.e. sort_key_size()
+  //! @throw std::invalid_argument if the buffer is too small
+  size_t write_sort_key(uint8_t *out, size_t capacity) const;
+
+  //! Hash the value from its sign and limbs. Equal values hash equally,
+  //! whether they are viewed or held in a BigInt.
+  //!
+  //! @return the hash
+  size_t hash() const;
+
+  //! View an encoded value in place, without copying its limbs. The
+  //! limbs are used directly, so this needs a little-endian machine and
+  //! limbs that start at a multiple of 8 bytes in memory; use
+  //! BigInt::decode for buffers that do not meet these requirements.
+  //!
+  //! @param in the start of the encoded value
+  //! @param size the number of bytes available at `in`
+  //! @param consumed if not null, set to the number of bytes the value takes up
+  //! @return a view of the encoded value
+  //! @throw std::invalid_argument if the encoding is malformed or
+  //!        truncated, or the limbs cannot be viewed in place
+  static BigIntView decode(const uint8_t *in, size_t size, size_t *consumed = nullptr);
+
+  //! Parse the sign byte and limb count at the start of an encoded value.
+  //!
+  //! @param in the start of the encoded value
+  //! @param size the number of bytes available at `in`
+  //! @param negative set to the sign
+  //! @param count set to the number of limbs, all of which are known
+  //!        to fit in the buffer
+  //! @return the number of header bytes; the limbs start right after them
+  //! @throw std::invalid_argument if the header is malformed or the
+  //!        limbs do not fit in `size` bytes
+  static size_t decode_header(const uint8_t *in, size_t size, bool &negative, size_t &count);
+};
+
+namespace std {
+  //! Hash of a view, for unordered containers.
+  template<> struct hash<BigIntView> {
+    size_t operator()(const BigIntView &value) const { return value.hash(); }
+  };
+}
+
+#endif // BIGINT_VIEW_H
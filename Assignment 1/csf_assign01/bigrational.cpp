@@ -0,0 +1,186 @@
+#include <stdexcept>
+#include <utility>
+#include "bigrational.h"
+
+static const BigInt ONE(1);
+
+BigRational::BigRational() : num(), den(1) {
+}
+
+BigRational::BigRational(const BigInt &value) : num(value), den(1) {
+}
+
+//Divides out the gcd and moves the sign to the numerator
+BigRational::BigRational(const BigInt &num, const BigInt &den) : num(num), den(den) {
+  if (den == BigInt()) {
+    throw std::invalid_argument("Denominator must not be zero");
+  }
+  BigInt g = num.gcd(den);
+  if (g != ONE) {
+    this->num = this->num / g;
+    this->den = this->den / g;
+  }
+  if (this->den.is_negative()) {
+    this->num = -this->num;
+    this->den = -this->den;
+  }
+}
+
+BigRational::BigRational(const BigDecimal &value)
+  : BigRational(value.unscaled_value(), BigDecimal::power_of_ten(value.scale())) {
+}
+
+void BigRational::assign_reduced(BigInt &&num, BigInt &&den) {
+  this->num = std::move(num);
+  this->den = std::move(den);
+}
+
+bool BigRational::is_integer() const {
+  return den == ONE;
+}
+
+//a/b + c/d with g = gcd(b, d): the sum is (a*(d/g) + c*(b/g)) / (b*(d/g)),
+//and any common factor of that numerator and denominator divides g
+void BigRational::add_signed(const BigRational &rhs, bool subtract) {
+  BigInt c = subtract ? -rhs.num : rhs.num;
+
+  if (den == rhs.den) {
+    num += c;
+    if (den != ONE) {
+      BigInt g = num.gcd(den);
+      if (g != ONE) {
+        num = num / g;
+        den = den / g;
+      }
+    }
+    return;
+  }
+  //gcd(a*d + c, d) = gcd(c, d) = 1, and likewise with the operands swapped
+  if (den == ONE) {
+    assign_reduced(num * rhs.den + c, BigInt(rhs.den));
+    return;
+  }
+  if (rhs.den == ONE) {
+    num += c * den;
+    return;
+  }
+
+  BigInt g = den.gcd(rhs.den);
+  if (g == ONE) {
+    assign_reduced(num * rhs.den + c * den, den * rhs.den);
+    return;
+  }
+  BigInt b_g = den / g;
+  BigInt t = num * (rhs.den / g) + c * b_g;
+  BigInt g2 = t.gcd(g);
+  if (g2 == ONE) {
+    assign_reduced(std::move(t), b_g * rhs.den);
+  } else {
+    assign_reduced(t / g2, b_g * (rhs.den / g2));
+  }
+}
+
+BigRational BigRational::operator+(const BigRational &rhs) const {
+  BigRational result(*this);
+  result.add_signed(rhs, false);
+  return result;
+}
+
+BigRational BigRational::operator-(const BigRational &rhs) const {
+  BigRational result(*this);
+  result.add_signed(rhs, true);
+  return result;
+}
+
+BigRational &BigRational::operator+=(const BigRational &rhs) {
+  add_signed(rhs, false);
+  return *this;
+}
+
+BigRational &BigRational::operator-=(const BigRational &rhs) {
+  add_signed(rhs, true);
+  return *this;
+}
+
+BigRational BigRational::operator*(const BigRational &rhs) const {
+  BigRational result(*this);
+  result *= rhs;
+  return result;
+}
+
+//a/b * c/d = (a/g1 * c/g2) / (b/g2 * d/g1) with g1 = gcd(a, d) and
+//g2 = gcd(c, b), which is in lowest terms because a/b and c/d are
+BigRational &BigRational::operator*=(const BigRational &rhs) {
+  if (num == BigInt() || rhs.num == BigInt()) {
+    assign_reduced(BigInt(), BigInt(1));
+    return *this;
+  }
+  BigInt g1 = rhs.den == ONE ? ONE : num.gcd(rhs.den);
+  BigInt g2 = den == ONE ? ONE : rhs.num.gcd(den);
+  BigInt a = g1 == ONE ? num : num / g1;
+  BigInt c = g2 == ONE ? rhs.num : rhs.num / g2;
+  BigInt b = g2 == ONE ? den : den / g2;
+  BigInt d = g1 == ONE ? rhs.den : rhs.den / g1;
+  assign_reduced(a * c, b * d);
+  return *this;
+}
+
+BigRational BigRational::operator/(const BigRational &rhs) const {
+  BigRational result(*this);
+  result /= rhs;
+  return result;
+}
+
+//Multiplies by the reciprocal, which is in lowest terms once the sign moves up
+BigRational &BigRational::operator/=(const BigRational &rhs) {
+  if (rhs.num == BigInt()) {
+    throw std::invalid_argument("Cannot divide by zero");
+  }
+  BigRational reciprocal;
+  if (rhs.num.is_negative()) {
+    reciprocal.assign_reduced(-rhs.den, -rhs.num);
+  } else {
+    reciprocal.assign_reduced(BigInt(rhs.den), BigInt(rhs.num));
+  }
+  return *this *= reciprocal;
+}
+
+BigRational BigRational::operator-() const {
+  BigRational result;
+  result.assign_reduced(-num, BigInt(den));
+  return result;
+}
+
+//Denominators are positive, so a/b < c/d exactly when a*d < c*b
+int BigRational::compare(const BigRational &rhs) const {
+  if (den == rhs.den) {
+    return num.compare(rhs.num);
+  }
+  if (is_negative() != rhs.is_negative()) {
+    return is_negative() ? -1 : 1;
+  }
+  return (num * rhs.den).compare(rhs.num * den);
+}
+
+BigInt BigRational::round(RoundingMode mode) const {
+  return BigDecimal::divide_rounded(num, den, mode);
+}
+
+BigDecimal BigRational::to_decimal(unsigned scale, RoundingMode mode) const {
+  return BigDecimal(BigDecimal::divide_rounded(num * BigDecimal::power_of_ten(scale), den, mode), scale);
+}
+
+std::string BigRational::to_string() const {
+  if (den == ONE) {
+    return num.to_dec();
+  }
+  return num.to_dec() + "/" + den.to_dec();
+}
+
+BigRational BigRational::from_string(const std::string &str) {
+  size_t slash = str.find('/');
+  if (slash == std::string::npos) {
+    return BigRational(BigDecimal::from_string(str));
+  }
+  return BigRational(BigInt::from_dec(str.substr(0, slash)), BigInt::from_dec(str.substr(slash + 1)));
+}
@@ -0,0 +1,127 @@
+#ifndef BIGRATIONAL_H
+#define BIGRATIONAL_H
+
+#include <string>
+#include "bigint.h"
+#include "bigdecimal.h"
+
+//! @file
+//! Exact rational numbers.
+
+//! Rational number `num / den` in lowest terms, with `den > 0`, so
+//! equal values always have equal numerators and denominators.
+//!
+//! Keeping the canonical form costs gcds, and each operation takes them
+//! of the smallest values that do the job instead of reducing the full
+//! result: products cancel across (`gcd(a, d)` and `gcd(c, b)` for
+//! `a/b * c/d`), sums divide out `gcd(b, d)` first and then only need
+//! the gcd of the numerator with that factor, and operations between
+//! integers (denominator 1) or with equal denominators skip the gcds
+//! that are known to be 1. The idea is the one used by GMP's mpq and is
+//! described by Knuth (TAOCP vol. 2, 4.5.1).
+class BigRational {
+private:
+  BigInt num;
+  BigInt den;
+
+public:
+  //! Default constructor: 0.
+  BigRational();
+
+  //! Constructor from an integer.
+  //!
+  //! @param value the value
+  BigRational(const BigInt &value);
+
+  //! Constructor from a fraction, which is reduced to lowest terms.
+  //!
+  //! @param num the numerator
+  //! @param den the denominator
+  //! @throw std::invalid_argument if `den` is 0
+  BigRational(const BigInt &num, const BigInt &den);
+
+  //! Constructor from a decimal, exactly.
+  //!
+  //! @param value the value
+  explicit BigRational(const BigDecimal &value);
+
+  //! @return the numerator, which has the sign of the value
+  const BigInt &numerator() const { return num; }
+
+  //! @return the denominator, which is always positive
+  const BigInt &denominator() const { return den; }
+
+  //! @return true if the value is negative
+  bool is_negative() const { return num.is_negative(); }
+
+  //! @return true if the value is an integer (the denominator is 1)
+  bool is_integer() const;
+
+  //! Exact arithmetic operators.
+  BigRational operator+(const BigRational &rhs) const;
+  BigRational operator-(const BigRational &rhs) const;
+  BigRational operator*(const BigRational &rhs) const;
+  BigRational &operator+=(const BigRational &rhs);
+  BigRational &operator-=(const BigRational &rhs);
+  BigRational &operator*=(const BigRational &rhs);
+
+  //! @throw std::invalid_argument if `rhs` is 0
+  BigRational operator/(const BigRational &rhs) const;
+
+  //! @throw std::invalid_argument if `rhs` is 0
+  BigRational &operator/=(const BigRational &rhs);
+
+  //! @return the negation of this value
+  BigRational operator-() const;
+
+  //! Compare two values, returning negative, 0 or positive if this
+  //! value is less than, equal to or greater than `rhs`. Values with
+  //! the same denominator compare their numerators; others compare
+  //! cross products.
+  int compare(const BigRational &rhs) const;
+
+  bool operator==(const BigRational &rhs) const { return num == rhs.num && den == rhs.den; }
+  bool operator!=(const BigRational &rhs) const { return !(*this == rhs); }
+  bool operator<(const BigRational &rhs) const  { return compare(rhs) < 0; }
+  bool operator<=(const BigRational &rhs) const { return compare(rhs) <= 0; }
+  bool operator>(const BigRational &rhs) const  { return compare(rhs) > 0; }
+  bool operator>=(const BigRational &rhs) const { return compare(rhs) >= 0; }
+
+  //! Round to an integer.
+  //!
+  //! @param mode how to round
+  //! @return the rounded value
+  BigInt round(RoundingMode mode) const;
+
+  //! Round to a decimal with the given scale.
+  //!
+  //! @param scale the number of digits after the decimal point
+  //! @param mode how to round
+  //! @return the rounded value
+  BigDecimal to_decimal(unsigned scale, RoundingMode mode) const;
+
+  //! Format the value as `num/den`, or just `num` for an integer.
+  //!
+  //! @return the value as a string
+  std::string to_string() const;
+
+  //! Parse a fraction `num/den` (each an optional minus sign followed by
+  //! digits), or a decimal number as accepted by BigDecimal::from_string.
+  //! The result is reduced to lowest terms.
+  //!
+  //! @param str the string to parse
+  //! @return the value
+  //! @throw std::invalid_argument if the string is not a valid fraction
+  //!        or decimal number, or the denominator is 0
+  static BigRational from_string(const std::string &str);
+
+private:
+  //! Set this value to `num / den` for values already in lowest terms
+  //! with a positive denominator, without taking any gcd.
+  void assign_reduced(BigInt &&num, BigInt &&den);
+
+  //! Add `rhs` to this value, or subtract it if `subtract` is true.
+  void add_signed(const BigRational &rhs, bool subtract);
+};
+
+#endif // BIGRATIONAL_H
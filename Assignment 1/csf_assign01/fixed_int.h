@@ -0,0 +1,327 @@
+#ifndef FIXED_INT_H
+#define FIXED_INT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "bigint.h"
+
+//! @file
+//! Fixed-width unsigned integer type.
+
+//! Unsigned integer of exactly `BITS` bits (a multiple of 64), stored
+//! in a `std::array` of `uint64_t` limbs in order from less-significant
+//! to more-significant. Arithmetic wraps around modulo `2^BITS`, like
+//! the built-in unsigned types, so values never allocate and every loop
+//! has a trip count known at compile time, which lets the compiler
+//! unroll it completely. All arithmetic is `constexpr`.
+//!
+//! The operator surface matches BigInt, and values convert to and from
+//! BigInt.
+template<size_t BITS>
+class FixedInt {
+  static_assert(BITS > 0 && BITS % 64 == 0, "FixedInt width must be a positive multiple of 64 bits");
+
+public:
+  //! Number of 64-bit limbs.
+  static constexpr size_t LIMBS = BITS / 64;
+
+private:
+  typedef unsigned __int128 u128;
+
+  std::array<uint64_t, LIMBS> limbs;
+
+public:
+  //! Default constructor: the value 0.
+  constexpr FixedInt() : limbs() { }
+
+  //! Constructor from a `uint64_t` value.
+  //!
+  //! @param val the value
+  constexpr FixedInt(uint64_t val) : limbs() { limbs[0] = val; }
+
+  //! Constructor from an `std::initializer_list` of limbs. Limbs past
+  //! the width are ignored, i.e. the value is reduced modulo `2^BITS`.
+  //!
+  //! @param vals the limbs, in order from less-significant to more-significant
+  constexpr FixedInt(std::initializer_list<uint64_t> vals) : limbs() {
+    size_t i = 0;
+    for (uint64_t val : vals) {
+      if (i < LIMBS) {
+        limbs[i++] = val;
+      }
+    }
+  }
+
+  //! Constructor from a BigInt. Values that do not fit are reduced
+  //! modulo `2^BITS`, so negative values become their two's complement
+  //! (e.g. `-1` becomes the all-ones value).
+  //!
+  //! @param val the BigInt value to convert
+  explicit FixedInt(const BigInt &val) : limbs() {
+    LimbView bits = val.get_bit_vector();
+    for (size_t i = 0; i < LIMBS && i < bits.size(); ++i) {
+      limbs[i] = bits[i];
+    }
+    if (val.is_negative()) {
+      *this = -*this;
+    }
+  }
+
+  //! Convert to a (non-negative) BigInt.
+  //!
+  //! @return the BigInt with the same value
+  BigInt to_bigint() const {
+    //Build the value a limb at a time through BigInt's public operators
+    BigInt result;
+    for (size_t i = LIMBS; i > 0; --i) {
+      result <<= 64;
+      result += BigInt(limbs[i - 1]);
+    }
+    return result;
+  }
+
+  //! Get 64 bits from the bit string.
+  //!
+  //! @param index the index of the limb (0 for the least significant)
+  //! @return the limb at `index`, or 0 if `index` is past the last limb
+  constexpr uint64_t get_bits(unsigned index) const { return index < LIMBS ? limbs[index] : 0; }
+
+  //! @return the limbs, in order from less-significant to more-significant
+  constexpr const std::array<uint64_t, LIMBS> &get_limbs() const { return limbs; }
+
+  //! Test whether a specific bit is set to 1.
+  //!
+  //! @param n the bit to test (0 for the least significant bit, etc.)
+  //! @return true if bit `n` is set to 1, false if it is 0 or past the width
+  constexpr bool is_bit_set(unsigned n) const {
+    return n < BITS && ((limbs[n / 64] >> (n % 64)) & 1) != 0;
+  }
+
+  //! @return true if the value is 0
+  constexpr bool is_zero() const {
+    for (size_t i = 0; i < LIMBS; ++i) {
+      if (limbs[i] != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  constexpr FixedInt &operator+=(const FixedInt &rhs) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint64_t sum = limbs[i] + carry;
+      carry = (sum < carry);
+      sum += rhs.limbs[i];
+      carry += (sum < rhs.limbs[i]);
+      limbs[i] = sum;
+    }
+    return *this;
+  }
+
+  constexpr FixedInt &operator-=(const FixedInt &rhs) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint64_t lhs = limbs[i];
+      uint64_t diff = lhs - rhs.limbs[i];
+      uint64_t next_borrow = (lhs < rhs.limbs[i]);
+      next_borrow += (diff < borrow);
+      limbs[i] = diff - borrow;
+      borrow = next_borrow;
+    }
+    return *this;
+  }
+
+  //! Multiplication modulo `2^BITS`: only the partial products that land
+  //! in the low `LIMBS` limbs are computed.
+  constexpr FixedInt &operator*=(const FixedInt &rhs) {
+    std::array<uint64_t, LIMBS> product{};
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; i + j < LIMBS; ++j) {
+        u128 t = (u128) limbs[i] * rhs.limbs[j] + product[i + j] + carry;
+        product[i + j] = (uint64_t) t;
+        carry = (uint64_t) (t >> 64);
+      }
+    }
+    limbs = product;
+    return *this;
+  }
+
+  //! @throw std::invalid_argument if `rhs` is 0
+  constexpr FixedInt &operator/=(const FixedInt &rhs) {
+    *this = divmod(rhs).first;
+    return *this;
+  }
+
+  //! @throw std::invalid_argument if `rhs` is 0
+  constexpr FixedInt &operator%=(const FixedInt &rhs) {
+    *this = divmod(rhs).second;
+    return *this;
+  }
+
+  //! Left shift; bits shifted past the width are lost.
+  constexpr FixedInt &operator<<=(unsigned n) {
+    if (n >= BITS) {
+      return *this = FixedInt();
+    }
+    size_t limb_shift = n / 64;
+    unsigned bit_shift = n % 64;
+    for (size_t i = LIMBS; i > 0; --i) {
+      size_t dst = i - 1;
+      uint64_t value = 0;
+      if (dst >= limb_shift) {
+        value = limbs[dst - limb_shift] << bit_shift;
+        if (bit_shift != 0 && dst > limb_shift) {
+          value |= limbs[dst - limb_shift - 1] >> (64 - bit_shift);
+        }
+      }
+      limbs[dst] = value;
+    }
+    return *this;
+  }
+
+  //! Logical right shift.
+  constexpr FixedInt &operator>>=(unsigned n) {
+    if (n >= BITS) {
+      return *this = FixedInt();
+    }
+    size_t limb_shift = n / 64;
+    unsigned bit_shift = n % 64;
+    for (size_t dst = 0; dst < LIMBS; ++dst) {
+      uint64_t value = 0;
+      if (dst + limb_shift < LIMBS) {
+        value = limbs[dst + limb_shift] >> bit_shift;
+        if (bit_shift != 0 && dst + limb_shift + 1 < LIMBS) {
+          value |= limbs[dst + limb_shift + 1] << (64 - bit_shift);
+        }
+      }
+      limbs[dst] = value;
+    }
+    return *this;
+  }
+
+  constexpr FixedInt operator+(const FixedInt &rhs) const { FixedInt r(*this); r += rhs; return r; }
+  constexpr FixedInt operator-(const FixedInt &rhs) const { FixedInt r(*this); r -= rhs; return r; }
+  constexpr FixedInt operator*(const FixedInt &rhs) const { FixedInt r(*this); r *= rhs; return r; }
+  constexpr FixedInt operator/(const FixedInt &rhs) const { return divmod(rhs).first; }
+  constexpr FixedInt operator%(const FixedInt &rhs) const { return divmod(rhs).second; }
+  constexpr FixedInt operator<<(unsigned n) const { FixedInt r(*this); r <<= n; return r; }
+  constexpr FixedInt operator>>(unsigned n) const { FixedInt r(*this); r >>= n; return r; }
+
+  //! Two's complement negation, i.e. `2^BITS - value`.
+  constexpr FixedInt operator-() const { return FixedInt() - *this; }
+
+  //! Division with remainder. Single-limb divisors divide a limb at a
+  //! time; larger divisors use binary long division, which stays
+  //! `constexpr` and needs at most `BITS` shift-and-subtract steps.
+  //!
+  //! @param rhs the divisor
+  //! @return the quotient (first) and remainder (second)
+  //! @throw std::invalid_argument if `rhs` is 0
+  constexpr std::pair<FixedInt, FixedInt> divmod(const FixedInt &rhs) const {
+    size_t divisor_limbs = rhs.significant_limbs();
+    if (divisor_limbs == 0) {
+      throw std::invalid_argument("Cannot divide by zero");
+    }
+
+    FixedInt quotient;
+    if (divisor_limbs == 1) {
+      uint64_t d = rhs.limbs[0];
+      uint64_t rem = 0;
+      for (size_t i = LIMBS; i > 0; --i) {
+        u128 t = ((u128) rem << 64) | limbs[i - 1];
+        quotient.limbs[i - 1] = (uint64_t) (t / d);
+        rem = (uint64_t) (t % d);
+      }
+      return std::make_pair(quotient, FixedInt(rem));
+    }
+
+    FixedInt remainder;
+    for (size_t i = bit_length(); i > 0; --i) {
+      remainder <<= 1;
+      remainder.limbs[0] |= (limbs[(i - 1) / 64] >> ((i - 1) % 64)) & 1;
+      if (remainder.compare(rhs) >= 0) {
+        remainder -= rhs;
+        quotient.limbs[(i - 1) / 64] |= uint64_t(1) << ((i - 1) % 64);
+      }
+    }
+    return std::make_pair(quotient, remainder);
+  }
+
+  //! Compare two values, returning negative, 0 or positive if this
+  //! value is less than, equal to or greater than `rhs`.
+  constexpr int compare(const FixedInt &rhs) const {
+    for (size_t i = LIMBS; i > 0; --i) {
+      if (limbs[i - 1] != rhs.limbs[i - 1]) {
+        return limbs[i - 1] > rhs.limbs[i - 1] ? 1 : -1;
+      }
+    }
+    return 0;
+  }
+
+  constexpr bool operator==(const FixedInt &rhs) const { return compare(rhs) == 0; }
+  constexpr bool operator!=(const FixedInt &rhs) const { return compare(rhs) != 0; }
+  constexpr bool operator<(const FixedInt &rhs) const  { return compare(rhs) < 0; }
+  constexpr bool operator<=(const FixedInt &rhs) const { return compare(rhs) <= 0; }
+  constexpr bool operator>(const FixedInt &rhs) const  { return compare(rhs) > 0; }
+  constexpr bool operator>=(const FixedInt &rhs) const { return compare(rhs) >= 0; }
+
+  //! Return the value in lower-case hexadecimal, without leading zeroes.
+  std::string to_hex() const {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = LIMBS; i > 0; --i) {
+      for (int shift = 60; shift >= 0; shift -= 4) {
+        unsigned digit = (limbs[i - 1] >> shift) & 0xF;
+        if (digit != 0 || !hex.empty()) {
+          hex.push_back(DIGITS[digit]);
+        }
+      }
+    }
+    return hex.empty() ? "0" : hex;
+  }
+
+  //! Return the value in decimal, produced 19 digits at a time.
+  std::string to_dec() const {
+    const uint64_t CHUNK = 10000000000000000000UL; //10^19
+    std::string dec;
+    FixedInt rest(*this);
+    do {
+      std::pair<FixedInt, FixedInt> qr = rest.divmod(FixedInt(CHUNK));
+      uint64_t chunk = qr.second.limbs[0];
+      rest = qr.first;
+      for (int i = 0; i < 19 && (chunk != 0 || !rest.is_zero()); ++i) {
+        dec.push_back(char('0' + chunk % 10));
+        chunk /= 10;
+      }
+    } while (!rest.is_zero());
+    if (dec.empty()) {
+      return "0";
+    }
+    return std::string(dec.rbegin(), dec.rend());
+  }
+
+private:
+  //! @return the number of limbs up to and including the highest nonzero one
+  constexpr size_t significant_limbs() const {
+    size_t n = LIMBS;
+    while (n > 0 && limbs[n - 1] == 0) {
+      --n;
+    }
+    return n;
+  }
+
+  //! @return the number of bits up to and including the highest set bit
+  constexpr size_t bit_length() const {
+    size_t n = significant_limbs();
+    return n == 0 ? 0 : 64 * n - __builtin_clzll(limbs[n - 1]);
+  }
+};
+
+#endif // FIXED_INT_H
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "limb_arena.h"
+
+//First chunk size; later chunks at least double so a thread needs few of them
+static const size_t MIN_CHUNK_LIMBS = 4096;
+
+bool LimbArena::enabled = true;
+
+//Constructor, chunks are only allocated when first needed
+LimbArena::LimbArena() : current(0), offset(0) {
+}
+
+//Destructor, frees all chunks (runs when the owning thread exits)
+LimbArena::~LimbArena() {
+  for (Chunk &chunk : chunks) {
+    delete[] chunk.limbs;
+  }
+  for (uint64_t *block : heap_blocks) {
+    delete[] block;
+  }
+}
+
+//Each thread gets its own arena, so no locking is needed
+LimbArena &LimbArena::local() {
+  thread_local LimbArena arena;
+  return arena;
+}
+
+void LimbArena::set_enabled(bool on) {
+  enabled = on;
+}
+
+//Bumps the offset in the current chunk, moving on to a later chunk
+//(or a new one) when the request does not fit
+uint64_t *LimbArena::allocate(size_t n) {
+  if (!enabled) {
+    heap_blocks.push_back(new uint64_t[std::max<size_t>(n, 1)]);
+    return heap_blocks.back();
+  }
+
+  if (!chunks.empty() && offset + n <= chunks[current].capacity) {
+    uint64_t *result = chunks[current].limbs + offset;
+    offset += n;
+    return result;
+  }
+
+  //Reuse a later chunk that is big enough before allocating a new one
+  size_t next = chunks.empty() ? 0 : current + 1;
+  while (next < chunks.size() && chunks[next].capacity < n) {
+    ++next;
+  }
+  if (next == chunks.size()) {
+    size_t capacity = MIN_CHUNK_LIMBS;
+    if (!chunks.empty()) {
+      capacity = std::max(capacity, 2 * chunks.back().capacity);
+    }
+    capacity = std::max(capacity, n);
+    chunks.push_back(Chunk{ new uint64_t[capacity], capacity });
+  }
+
+  current = next;
+  offset = n;
+  return chunks[current].limbs;
+}
+
+LimbArena::Mark LimbArena::mark() const {
+  return Mark{ current, offset, heap_blocks.size() };
+}
+
+//Rewinds to the mark; chunks stay allocated for the next user
+void LimbArena::release(const Mark &m) {
+  current = m.chunk;
+  offset = m.offset;
+  while (heap_blocks.size() > m.heap_blocks) {
+    delete[] heap_blocks.back();
+    heap_blocks.pop_back();
+  }
+}
+
+size_t LimbArena::reserved_limbs() const {
+  size_t total = 0;
+  for (const Chunk &chunk : chunks) {
+    total += chunk.capacity;
+  }
+  return total;
+}
+
+uint64_t *LimbScratchScope::allocate_zeroed(size_t n) {
+  uint64_t *limbs = allocate(n);
+  std::fill(limbs, limbs + n, 0);
+  return limbs;
+}
@@ -0,0 +1,95 @@
+#ifndef LIMB_ARENA_H
+#define LIMB_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! @file
+//! Thread-local bump allocator for the scratch limbs used inside
+//! multiplication, division and conversion algorithms.
+
+//! Per-thread stack of limb buffers. Allocation bumps an offset inside
+//! a chunk; memory is handed back in bulk by rewinding to an earlier
+//! mark, and the chunks are kept for reuse, so a thread that repeatedly
+//! multiplies or divides numbers of similar size stops touching the heap
+//! after the first operation. Use LimbScratchScope rather than calling
+//! mark/release directly.
+class LimbArena {
+public:
+  //! Position in the arena to rewind to.
+  struct Mark {
+    size_t chunk;
+    size_t offset;
+    size_t heap_blocks;
+  };
+
+private:
+  struct Chunk {
+    uint64_t *limbs;
+    size_t capacity;
+  };
+
+  std::vector<Chunk> chunks;
+  size_t current;  // index of the chunk being bumped
+  size_t offset;   // limbs used in chunks[current]
+  std::vector<uint64_t *> heap_blocks; // allocations made while disabled
+
+  static bool enabled;
+
+public:
+  LimbArena();
+  ~LimbArena();
+
+  LimbArena(const LimbArena &) = delete;
+  LimbArena &operator=(const LimbArena &) = delete;
+
+  //! Return the calling thread's arena.
+  static LimbArena &local();
+
+  //! Turn the arena on or off for all threads. While off, every
+  //! allocation is a separate heap allocation freed on release, which
+  //! is how the benchmark measures what the arena saves. Must not be
+  //! called while any LimbScratchScope is alive.
+  //!
+  //! @param on true to use the arena (the default)
+  static void set_enabled(bool on);
+
+  //! Allocate `n` uninitialized limbs, valid until the arena is
+  //! released to a mark taken before this call.
+  uint64_t *allocate(size_t n);
+
+  //! Record the current position.
+  Mark mark() const;
+
+  //! Free everything allocated since `m` was taken.
+  void release(const Mark &m);
+
+  //! Number of limbs held in chunks for reuse by this thread.
+  size_t reserved_limbs() const;
+};
+
+//! RAII scope for scratch limbs: everything allocated through the
+//! scope is released when the scope is destroyed. Scopes must be
+//! destroyed in reverse order of creation, which holds automatically
+//! for local variables.
+class LimbScratchScope {
+private:
+  LimbArena &arena;
+  LimbArena::Mark saved;
+
+public:
+  LimbScratchScope() : arena(LimbArena::local()), saved(arena.mark()) { }
+  ~LimbScratchScope() { arena.release(saved); }
+
+  LimbScratchScope(const LimbScratchScope &) = delete;
+  LimbScratchScope &operator=(const LimbScratchScope &) = delete;
+
+  //! Allocate `n` uninitialized limbs.
+  uint64_t *allocate(size_t n) { return arena.allocate(n); }
+
+  //! Allocate `n` limbs set to 0.
+  uint64_t *allocate_zeroed(size_t n);
+};
+
+#endif // LIMB_ARENA_H
@@ -0,0 +1,283 @@
+// Greatest common divisors of limb arrays.
+//
+// Small operands use binary GCD: subtract the smaller odd value from
+// the larger and shift out the factors of two, which costs no division
+// at all. Larger operands use Lehmer's algorithm (TAOCP vol. 2, 4.5.2,
+// Algorithm L) with double-limb leading parts: the Euclid quotients of
+// the top 126 bits are run in 128-bit arithmetic for as long as they
+// are guaranteed to match the quotients of the full values, and the
+// resulting cofactors (up to 62 bits) are applied to the full values in
+// two linear passes. Each pass removes about 62 bits from the operands
+// where a plain Euclid step would need a full division per quotient.
+
+#include <algorithm>
+#include <cassert>
+#include "limb_ops.h"
+#include "limb_arena.h"
+
+typedef unsigned __int128 u128;
+typedef __int128 s128;
+
+//Tuned on x86-64 with bigint_bench (see README.txt)
+size_t limb_lehmer_threshold = 4;
+
+//Cofactors must stay below this so the combined values fit in int64_t and the
+//quotient tests on the 126-bit leading parts stay exact
+static const s128 COFACTOR_LIMIT = s128(1) << 62;
+
+//Returns the 128 bits of a[0..n) starting at bit `shift`
+static u128 bits_at(const uint64_t *a, size_t n, size_t shift) {
+  size_t i = shift / 64;
+  unsigned s = shift % 64;
+  uint64_t l0 = i < n ? a[i] : 0;
+  uint64_t l1 = i + 1 < n ? a[i + 1] : 0;
+  uint64_t l2 = i + 2 < n ? a[i + 2] : 0;
+  u128 lo = ((u128) l1 << 64) | l0;
+  if (s == 0) {
+    return lo;
+  }
+  return (lo >> s) | ((u128) l2 << (128 - s));
+}
+
+//Quotient of non-negative values; Euclid quotients are almost always 1 or 2,
+//so try those before paying for a 128-bit division
+static s128 small_quotient(s128 n, s128 d) {
+  if (n < d) {
+    return 0;
+  }
+  if (n - d < d) {
+    return 1;
+  }
+  if (n - d < 2 * d) {
+    return 2;
+  }
+  return n / d;
+}
+
+//Algorithm L, steps L1-L3 on the leading 126 bits of a, with b taken at the same shift
+bool limb_lehmer_matrix(LimbLehmerMatrix &m, const uint64_t *a, const uint64_t *b, size_t n) {
+  size_t bits = limb_bit_length(a, n);
+  size_t shift = bits > 126 ? bits - 126 : 0;
+  s128 x = (s128) bits_at(a, n, shift);
+  s128 y = (s128) bits_at(b, n, shift);
+
+  s128 A = 1, B = 0, C = 0, D = 1;
+  while (y + C > 0 && y + D > 0) {
+    //The true quotient lies between these two; stop once they disagree
+    s128 q = small_quotient(x + A, y + C);
+    if (q != small_quotient(x + B, y + D)) {
+      break;
+    }
+    s128 next_C = A - q * C;
+    s128 next_D = B - q * D;
+    if (next_C <= -COFACTOR_LIMIT || next_C >= COFACTOR_LIMIT ||
+        next_D <= -COFACTOR_LIMIT || next_D >= COFACTOR_LIMIT) {
+      break;
+    }
+    A = C;
+    C = next_C;
+    B = D;
+    D = next_D;
+    s128 next_y = x - q * y;
+    x = y;
+    y = next_y;
+  }
+
+  m.A = int64_t(A);
+  m.B = int64_t(B);
+  m.C = int64_t(C);
+  m.D = int64_t(D);
+  return B != 0;
+}
+
+//Multiplies by the non-negative cofactor and subtracts the other product
+void limb_lehmer_combine(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n, int64_t p, int64_t q) {
+  if (q <= 0) {
+    limb_mul_1(r, a, n, uint64_t(p));
+    limb_submul_1(r, b, n, uint64_t(-q));
+  } else {
+    limb_mul_1(r, b, n, uint64_t(q));
+    limb_submul_1(r, a, n, uint64_t(-p));
+  }
+}
+
+//Sets r = a mod b (bn limbs of space) and returns its normalized size
+static size_t mod_step(uint64_t *r, uint64_t *q, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  if (bn == 1) {
+    r[0] = limb_divrem_1(q, a, an, b[0]);
+    return r[0] != 0;
+  }
+  limb_divrem(q, r, a, an, b, bn);
+  return limb_normalized_size(r, bn);
+}
+
+//Returns the number of trailing zero bits of a nonzero a[]
+static size_t trailing_zeros(const uint64_t *a) {
+  size_t i = 0;
+  while (a[i] == 0) {
+    ++i;
+  }
+  return 64 * i + __builtin_ctzll(a[i]);
+}
+
+//Shifts a[0..n) right by `bits` in place and returns its normalized size
+static size_t shift_out(uint64_t *a, size_t n, size_t bits) {
+  size_t limbs = bits / 64;
+  if (limbs) {
+    std::copy(a + limbs, a + n, a);
+    n -= limbs;
+  }
+  if (bits % 64) {
+    limb_rshift(a, a, n, unsigned(bits % 64));
+  }
+  return limb_normalized_size(a, n);
+}
+
+static unsigned ctz128(u128 x) {
+  uint64_t lo = uint64_t(x);
+  return lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll(uint64_t(x >> 64));
+}
+
+//Binary GCD of two odd values of at most two limbs
+static u128 gcd_odd_128(u128 x, u128 y) {
+  while (x != y) {
+    if (x < y) {
+      std::swap(x, y);
+    }
+    x -= y;
+    x >>= ctz128(x);
+  }
+  return x;
+}
+
+//Binary GCD of nonzero values of at most two limbs, with single-limb
+//operands kept in 64-bit arithmetic
+static u128 gcd_128(u128 x, u128 y) {
+  unsigned twos = std::min(ctz128(x), ctz128(y));
+  x >>= ctz128(x);
+  y >>= ctz128(y);
+  if ((x >> 64) == 0 && (y >> 64) == 0) {
+    uint64_t u = uint64_t(x), v = uint64_t(y);
+    while (u != v) {
+      if (u < v) {
+        std::swap(u, v);
+      }
+      u -= v;
+      u >>= __builtin_ctzll(u);
+    }
+    return (u128) u << twos;
+  }
+  return gcd_odd_128(x, y) << twos;
+}
+
+//Binary GCD (Stein's algorithm) of nonzero values; a and b are overwritten
+static size_t gcd_binary(uint64_t *g, uint64_t *a, size_t an, uint64_t *b, size_t bn) {
+  size_t za = trailing_zeros(a);
+  size_t zb = trailing_zeros(b);
+  size_t twos = std::min(za, zb);
+  an = shift_out(a, an, za);
+  bn = shift_out(b, bn, zb);
+
+  //Both odd: replace the larger by the difference, which is even and nonzero
+  while (an > 2 || bn > 2) {
+    int cmp = an != bn ? (an > bn ? 1 : -1) : limb_cmp(a, b, an);
+    if (cmp == 0) {
+      break;
+    }
+    if (cmp < 0) {
+      std::swap(a, b);
+      std::swap(an, bn);
+    }
+    limb_sub(a, a, an, b, bn);
+    an = limb_normalized_size(a, an);
+    an = shift_out(a, an, trailing_zeros(a));
+  }
+
+  size_t n = an;
+  uint64_t small[2];
+  if (an <= 2 && bn <= 2) {
+    u128 x = ((u128) (an > 1 ? a[1] : 0) << 64) | a[0];
+    u128 y = ((u128) (bn > 1 ? b[1] : 0) << 64) | b[0];
+    x = gcd_odd_128(x, y);
+    small[0] = uint64_t(x);
+    small[1] = uint64_t(x >> 64);
+    a = small;
+    n = small[1] ? 2 : 1;
+  }
+
+  //Put back the common factors of two
+  size_t limbs = twos / 64;
+  std::fill(g, g + limbs, 0);
+  if (twos % 64) {
+    uint64_t high = limb_lshift(g + limbs, a, n, unsigned(twos % 64));
+    if (high) {
+      g[limbs + n] = high;
+      ++n;
+    }
+  } else {
+    std::copy(a, a + n, g + limbs);
+  }
+  return limbs + n;
+}
+
+//Euclid steps bring the operands to the same size; Lehmer passes (or a
+//division when a pass cannot determine a quotient) shrink them until they
+//drop below limb_lehmer_threshold, and binary GCD finishes
+size_t limb_gcd(uint64_t *g, const uint64_t *a_in, size_t an, const uint64_t *b_in, size_t bn) {
+  assert(an >= 1 && bn >= 1 && a_in[an - 1] != 0 && b_in[bn - 1] != 0);
+  if (an < bn || (an == bn && limb_cmp(a_in, b_in, an) < 0)) {
+    std::swap(a_in, b_in);
+    std::swap(an, bn);
+  }
+
+  if (an <= 2) { //both fit in 128 bits, so no scratch space is needed
+    u128 x = ((u128) (an > 1 ? a_in[1] : 0) << 64) | a_in[0];
+    u128 y = ((u128) (bn > 1 ? b_in[1] : 0) << 64) | b_in[0];
+    x = gcd_128(x, y);
+    g[0] = uint64_t(x);
+    if (x >> 64) {
+      g[1] = uint64_t(x >> 64);
+      return 2;
+    }
+    return 1;
+  }
+
+  LimbScratchScope scratch;
+  size_t n = an;
+  uint64_t *a = scratch.allocate(n);
+  uint64_t *b = scratch.allocate_zeroed(n);
+  uint64_t *t = scratch.allocate(n);
+  uint64_t *u = scratch.allocate(n);
+  std::copy(a_in, a_in + an, a);
+  std::copy(b_in, b_in + bn, b);
+
+  //Invariant: a >= b, and b is zero-padded to an limbs
+  while (bn > 0) {
+    LimbLehmerMatrix m;
+    if (an == bn && bn < std::max<size_t>(limb_lehmer_threshold, 3)) {
+      break;
+    }
+    if (an - bn <= 1 && bn >= 3 && limb_lehmer_matrix(m, a, b, an)) {
+      limb_lehmer_combine(t, a, b, an, m.A, m.B);
+      limb_lehmer_combine(u, a, b, an, m.C, m.D);
+      std::swap(a, t);
+      std::swap(b, u);
+      bn = limb_normalized_size(b, an);
+      an = limb_normalized_size(a, an);
+    } else {
+      //t holds the quotient, which is not needed
+      size_t rn = mod_step(u, t, a, an, b, bn);
+      std::fill(u + rn, u + bn, 0);
+      std::swap(a, b);
+      std::swap(b, u);
+      an = bn;
+      bn = rn;
+    }
+  }
+
+  if (bn == 0) {
+    std::copy(a, a + an, g);
+    return an;
+  }
+  return gcd_binary(g, a, an, b, bn);
+}
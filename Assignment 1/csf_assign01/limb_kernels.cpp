@@ -0,0 +1,655 @@
+// Inner-loop kernels for limb arithmetic (add_n, sub_n, mul_1, addmul_1,
+// submul_1, lshift, rshift), bit counting (popcount), hex formatting
+// (to_hex) and element-wise batch arithmetic (batch_add, batch_sub,
+// batch_cmp) with runtime CPU dispatch.
+//
+// Every kernel has a portable C++ version. On x86-64 the carry chains
+// are written with _addcarry_u64/_subborrow_u64 so they compile to
+// straight adc/sbb sequences without compare-and-branch, addmul_1 and
+// submul_1 have BMI2/ADX versions in inline assembly that run two carry
+// chains with mulx, adcx and adox, the shifts have an AVX2 build that
+// the compiler vectorizes, popcount has a build that uses the popcnt
+// instruction, and to_hex has an SSSE3 version that turns a limb into 16
+// digits with one pshufb. The batch kernels work on values stored
+// limb-major (limb i of every value is contiguous), so the AVX2 and
+// AVX-512 versions process 4 or 8 values per instruction, with a carry,
+// borrow or comparison result per lane. The best set the CPU
+// supports is picked the first time a kernel is called.
+
+#include <cassert>
+#include <cstring>
+#include "limb_ops.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#define LIMB_KERNELS_X86 1
+#endif
+
+typedef unsigned __int128 u128;
+
+namespace {
+
+typedef uint64_t (*AddSubFn)(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+typedef uint64_t (*MulFn)(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+typedef uint64_t (*ShiftFn)(uint64_t *r, const uint64_t *a, size_t n, unsigned shift);
+typedef void (*HexFn)(char *out, const uint64_t *a, size_t n);
+typedef size_t (*PopcountFn)(const uint64_t *a, size_t n);
+typedef void (*BatchAddSubFn)(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count);
+typedef void (*BatchCmpFn)(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count);
+
+// One implementation of every kernel
+struct LimbKernels {
+  const char *name;
+  AddSubFn add_n;
+  AddSubFn sub_n;
+  MulFn mul_1;
+  MulFn addmul_1;
+  MulFn submul_1;
+  ShiftFn lshift;
+  ShiftFn rshift;
+  PopcountFn popcount;
+  HexFn to_hex;
+  BatchAddSubFn batch_add;
+  BatchAddSubFn batch_sub;
+  BatchCmpFn batch_cmp;
+};
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+//
+// Portable versions
+//
+
+uint64_t portable_add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t sum = a[i] + carry;
+    carry = (sum < carry); //a[i] + carry wrapped around
+    sum += b[i];
+    carry += (sum < b[i]); //sum + b[i] wrapped around
+    r[i] = sum;
+  }
+  return carry;
+}
+
+uint64_t portable_sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t lhs = a[i];
+    uint64_t diff = lhs - b[i];
+    uint64_t next_borrow = (lhs < b[i]);
+    next_borrow += (diff < borrow); //subtracting the incoming borrow wrapped around
+    r[i] = diff - borrow;
+    borrow = next_borrow;
+  }
+  return borrow;
+}
+
+uint64_t portable_mul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    u128 product = (u128) a[i] * b + carry;
+    r[i] = (uint64_t) product;
+    carry = (uint64_t) (product >> 64);
+  }
+  return carry;
+}
+
+uint64_t portable_addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    //a[i]*b + r[i] + carry always fits in 128 bits
+    u128 product = (u128) a[i] * b + r[i] + carry;
+    r[i] = (uint64_t) product;
+    carry = (uint64_t) (product >> 64);
+  }
+  return carry;
+}
+
+uint64_t portable_submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    u128 product = (u128) a[i] * b + borrow;
+    uint64_t low = (uint64_t) product;
+    borrow = (uint64_t) (product >> 64) + (r[i] < low);
+    r[i] -= low;
+  }
+  return borrow;
+}
+
+//Starts from the top so r may alias a
+uint64_t portable_lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  uint64_t out = a[n - 1] >> (64 - shift);
+  for (size_t i = n - 1; i > 0; --i) {
+    r[i] = (a[i] << shift) | (a[i - 1] >> (64 - shift));
+  }
+  r[0] = a[0] << shift;
+  return out;
+}
+
+//Starts from the bottom so r may alias a
+uint64_t portable_rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  uint64_t out = a[0] << (64 - shift);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    r[i] = (a[i] >> shift) | (a[i + 1] << (64 - shift));
+  }
+  r[n - 1] = a[n - 1] >> shift;
+  return out;
+}
+
+//Without -mpopcnt the builtin expands to a few shifts, masks and a multiply
+size_t portable_popcount(const uint64_t *a, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += __builtin_popcountll(a[i]);
+  }
+  return count;
+}
+
+//Two digits per table lookup, from a table of all 256 byte values
+uint16_t HEX_PAIRS[256];
+
+bool fill_hex_pairs() {
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    char pair[2] = { HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0xF] };
+    std::memcpy(&HEX_PAIRS[byte], pair, 2);
+  }
+  return true;
+}
+
+void portable_to_hex(char *out, const uint64_t *a, size_t n) {
+  static const bool filled = fill_hex_pairs();
+  (void) filled;
+  for (size_t i = n; i > 0; --i, out += 16) {
+    uint64_t limb = a[i - 1];
+    for (int byte = 7; byte >= 0; --byte) {
+      std::memcpy(out + 2 * (7 - byte), &HEX_PAIRS[(limb >> (8 * byte)) & 0xFF], 2);
+    }
+  }
+}
+
+//Batch kernels for the values (lanes) [begin, end); the vector versions
+//use these for the lanes left over after the last full vector.
+//Limb i of value j is at [i * count + j].
+void batch_add_lanes(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count, size_t begin, size_t end) {
+  for (size_t j = begin; j < end; ++j) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      uint64_t sum = a[k] + carry;
+      carry = (sum < carry);
+      sum += b[k];
+      carry += (sum < b[k]);
+      r[k] = sum;
+    }
+  }
+}
+
+void batch_sub_lanes(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count, size_t begin, size_t end) {
+  for (size_t j = begin; j < end; ++j) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      uint64_t diff = a[k] - b[k];
+      uint64_t next_borrow = (a[k] < b[k]) + (diff < borrow);
+      r[k] = diff - borrow;
+      borrow = next_borrow;
+    }
+  }
+}
+
+void batch_cmp_lanes(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count, size_t begin, size_t end) {
+  for (size_t j = begin; j < end; ++j) {
+    int result = 0;
+    for (size_t i = width; i > 0 && result == 0; --i) {
+      size_t k = (i - 1) * count + j;
+      result = (a[k] > b[k]) - (a[k] < b[k]);
+    }
+    out[j] = result;
+  }
+}
+
+void portable_batch_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  batch_add_lanes(r, a, b, width, count, 0, count);
+}
+
+void portable_batch_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  batch_sub_lanes(r, a, b, width, count, 0, count);
+}
+
+void portable_batch_cmp(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  batch_cmp_lanes(out, a, b, width, count, 0, count);
+}
+
+const LimbKernels PORTABLE_KERNELS = {
+  "portable",
+  portable_add_n, portable_sub_n,
+  portable_mul_1, portable_addmul_1, portable_submul_1,
+  portable_lshift, portable_rshift,
+  portable_popcount,
+  portable_to_hex,
+  portable_batch_add, portable_batch_sub, portable_batch_cmp,
+};
+
+#ifdef LIMB_KERNELS_X86
+
+//
+// x86-64 versions. adc/sbb are part of the base instruction set, so
+// the add/sub kernels need no feature check.
+//
+
+uint64_t x86_add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  unsigned char carry = 0;
+  unsigned long long sum;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) { //unrolled so the carry flag stays live across limbs
+    carry = _addcarry_u64(carry, a[i], b[i], &sum);
+    r[i] = sum;
+    carry = _addcarry_u64(carry, a[i + 1], b[i + 1], &sum);
+    r[i + 1] = sum;
+    carry = _addcarry_u64(carry, a[i + 2], b[i + 2], &sum);
+    r[i + 2] = sum;
+    carry = _addcarry_u64(carry, a[i + 3], b[i + 3], &sum);
+    r[i + 3] = sum;
+  }
+  for (; i < n; ++i) {
+    carry = _addcarry_u64(carry, a[i], b[i], &sum);
+    r[i] = sum;
+  }
+  return carry;
+}
+
+uint64_t x86_sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  unsigned char borrow = 0;
+  unsigned long long diff;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    borrow = _subborrow_u64(borrow, a[i], b[i], &diff);
+    r[i] = diff;
+    borrow = _subborrow_u64(borrow, a[i + 1], b[i + 1], &diff);
+    r[i + 1] = diff;
+    borrow = _subborrow_u64(borrow, a[i + 2], b[i + 2], &diff);
+    r[i + 2] = diff;
+    borrow = _subborrow_u64(borrow, a[i + 3], b[i + 3], &diff);
+    r[i + 3] = diff;
+  }
+  for (; i < n; ++i) {
+    borrow = _subborrow_u64(borrow, a[i], b[i], &diff);
+    r[i] = diff;
+  }
+  return borrow;
+}
+
+//
+// BMI2/ADX versions, in inline assembly because compilers lower
+// _addcarryx_u64 to plain adc. mulx leaves the flags alone, so the carry
+// from adding the previous high half to the low half (CF, adcx) and the
+// carry from adding that to r (OF, adox) run as two independent chains,
+// four limbs per iteration. The loop counter runs from -n up to 0 and is
+// stepped with lea and tested with jrcxz, which leave both flags alone.
+// The n % 4 limbs at the bottom go through the portable kernel, whose
+// carry limb starts the chains. submul_1 uses r - x = ~(~r + x): r is
+// complemented as it is loaded and stored, and the carry out of ~r + x
+// is the borrow out of r - x.
+//
+
+#define ADX_STEP(offset, hi_in, hi_out, load, store) \
+  "mulx " offset "(%[a],%[i],8), %[lo], %[" hi_out "]\n\t" \
+  "adcx %[" hi_in "], %[lo]\n\t" \
+  load \
+  "adox %[t], %[lo]\n\t" \
+  store \
+  "mov %[lo], " offset "(%[r],%[i],8)\n\t"
+
+#define ADX_LOOP(load, store) \
+  "xor %%r8d, %%r8d\n\t" /* clears CF and OF */ \
+  "1:\n\t" \
+  ADX_STEP("", "c", "h", "mov (%[r],%[i],8), %[t]\n\t" load, store) \
+  ADX_STEP("8", "h", "c", "mov 8(%[r],%[i],8), %[t]\n\t" load, store) \
+  ADX_STEP("16", "c", "h", "mov 16(%[r],%[i],8), %[t]\n\t" load, store) \
+  ADX_STEP("24", "h", "c", "mov 24(%[r],%[i],8), %[t]\n\t" load, store) \
+  "lea 4(%[i]), %[i]\n\t" \
+  "jrcxz 2f\n\t" \
+  "jmp 1b\n\t" \
+  "2:\n\t" \
+  "adcx %%r8, %[c]\n\t" \
+  "adox %%r8, %[c]\n\t"
+
+__attribute__((target("bmi2,adx")))
+uint64_t adx_addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  size_t head = n % 4;
+  uint64_t carry = head ? portable_addmul_1(r, a, head, b) : 0;
+  if (n == head) {
+    return carry;
+  }
+  intptr_t i = -intptr_t(n - head);
+  uint64_t lo, hi, t;
+  __asm__ volatile(ADX_LOOP("", "")
+                   : [c] "+&r"(carry), [i] "+&c"(i), [lo] "=&r"(lo), [h] "=&r"(hi), [t] "=&r"(t)
+                   : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+                   : "r8", "cc", "memory");
+  //The true result fits in n + 1 limbs, so the last two adds cannot overflow
+  return carry;
+}
+
+__attribute__((target("bmi2,adx")))
+uint64_t adx_submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  size_t head = n % 4;
+  uint64_t borrow = head ? portable_submul_1(r, a, head, b) : 0;
+  if (n == head) {
+    return borrow;
+  }
+  intptr_t i = -intptr_t(n - head);
+  uint64_t lo, hi, t;
+  __asm__ volatile(ADX_LOOP("not %[t]\n\t", "not %[lo]\n\t")
+                   : [c] "+&r"(borrow), [i] "+&c"(i), [lo] "=&r"(lo), [h] "=&r"(hi), [t] "=&r"(t)
+                   : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+                   : "r8", "cc", "memory");
+  return borrow;
+}
+
+#undef ADX_LOOP
+#undef ADX_STEP
+
+//
+// AVX2 versions of the shifts: the same loops, compiled so that the
+// compiler can process four limbs per instruction.
+//
+
+__attribute__((target("avx2")))
+uint64_t avx2_lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  uint64_t out = a[n - 1] >> (64 - shift);
+  for (size_t i = n - 1; i > 0; --i) {
+    r[i] = (a[i] << shift) | (a[i - 1] >> (64 - shift));
+  }
+  r[0] = a[0] << shift;
+  return out;
+}
+
+__attribute__((target("avx2")))
+uint64_t avx2_rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  uint64_t out = a[0] << (64 - shift);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    r[i] = (a[i] >> shift) | (a[i + 1] << (64 - shift));
+  }
+  r[n - 1] = a[n - 1] >> shift;
+  return out;
+}
+
+//
+// popcount built with the popcnt instruction, one per limb.
+//
+
+__attribute__((target("popcnt")))
+size_t popcnt_popcount(const uint64_t *a, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += __builtin_popcountll(a[i]);
+  }
+  return count;
+}
+
+//
+// SSSE3 version of to_hex: the byte-swapped limb is split into high and
+// low nibbles, which are interleaved into 16 bytes in output order, and
+// pshufb looks all 16 of them up in the digit table at once.
+//
+
+__attribute__((target("ssse3")))
+void ssse3_to_hex(char *out, const uint64_t *a, size_t n) {
+  const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(HEX_DIGITS));
+  const __m128i low_mask = _mm_set1_epi8(0x0F);
+  for (size_t i = n; i > 0; --i, out += 16) {
+    __m128i bytes = _mm_cvtsi64_si128((long long) __builtin_bswap64(a[i - 1]));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask);
+    __m128i low = _mm_and_si128(bytes, low_mask);
+    __m128i nibbles = _mm_unpacklo_epi8(high, low);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(digits, nibbles));
+  }
+}
+
+//
+// AVX2 batch kernels, 4 values per vector. AVX2 has only signed 64-bit
+// compares, so operands are biased by 2^63 before comparing; carries and
+// borrows are kept as all-ones lanes, so adding one subtracts 1.
+//
+
+__attribute__((target("avx2")))
+inline __m256i avx2_less_than(__m256i x, __m256i y) {
+  const __m256i bias = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+  return _mm256_cmpgt_epi64(_mm256_xor_si256(y, bias), _mm256_xor_si256(x, bias));
+}
+
+__attribute__((target("avx2")))
+void avx2_batch_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  for (; j + 4 <= count; j += 4) {
+    __m256i carry = _mm256_setzero_si256();
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k));
+      __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k));
+      __m256i sum = _mm256_add_epi64(x, y);
+      __m256i total = _mm256_sub_epi64(sum, carry);
+      carry = _mm256_or_si256(avx2_less_than(sum, x), avx2_less_than(total, sum));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + k), total);
+    }
+  }
+  batch_add_lanes(r, a, b, width, count, j, count);
+}
+
+__attribute__((target("avx2")))
+void avx2_batch_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  for (; j + 4 <= count; j += 4) {
+    __m256i borrow = _mm256_setzero_si256();
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k));
+      __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k));
+      __m256i diff = _mm256_sub_epi64(x, y);
+      __m256i total = _mm256_add_epi64(diff, borrow);
+      borrow = _mm256_or_si256(avx2_less_than(x, y), avx2_less_than(diff, total));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + k), total);
+    }
+  }
+  batch_sub_lanes(r, a, b, width, count, j, count);
+}
+
+//Compares from the most significant limb down; a lane keeps the result
+//of the first limb that differs
+__attribute__((target("avx2")))
+void avx2_batch_cmp(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  for (; j + 4 <= count; j += 4) {
+    __m256i result = _mm256_setzero_si256();
+    for (size_t i = width; i > 0; --i) {
+      size_t k = (i - 1) * count + j;
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k));
+      __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k));
+      //-1 where x > y, +1 where x < y, then negate: 1, -1 or 0
+      __m256i sign = _mm256_sub_epi64(avx2_less_than(y, x), avx2_less_than(x, y));
+      __m256i undecided = _mm256_cmpeq_epi64(result, _mm256_setzero_si256());
+      result = _mm256_blendv_epi8(result, _mm256_sub_epi64(_mm256_setzero_si256(), sign), undecided);
+      if (_mm256_testz_si256(_mm256_cmpeq_epi64(result, _mm256_setzero_si256()), _mm256_set1_epi64x(-1))) {
+        break; //every lane is decided
+      }
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), result);
+    for (int lane = 0; lane < 4; ++lane) {
+      out[j + lane] = int(lanes[lane]);
+    }
+  }
+  batch_cmp_lanes(out, a, b, width, count, j, count);
+}
+
+//
+// AVX-512 batch kernels, 8 values per vector. Unsigned compares produce
+// mask registers directly, and the carry is added with a masked add.
+//
+
+__attribute__((target("avx512f")))
+void avx512_batch_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  const __m512i one = _mm512_set1_epi64(1);
+  for (; j + 8 <= count; j += 8) {
+    __mmask8 carry = 0;
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      __m512i x = _mm512_loadu_si512(a + k);
+      __m512i y = _mm512_loadu_si512(b + k);
+      __m512i sum = _mm512_add_epi64(x, y);
+      __m512i total = _mm512_mask_add_epi64(sum, carry, sum, one);
+      carry = _mm512_cmplt_epu64_mask(sum, x) | _mm512_cmplt_epu64_mask(total, sum);
+      _mm512_storeu_si512(r + k, total);
+    }
+  }
+  batch_add_lanes(r, a, b, width, count, j, count);
+}
+
+__attribute__((target("avx512f")))
+void avx512_batch_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  const __m512i one = _mm512_set1_epi64(1);
+  for (; j + 8 <= count; j += 8) {
+    __mmask8 borrow = 0;
+    for (size_t i = 0; i < width; ++i) {
+      size_t k = i * count + j;
+      __m512i x = _mm512_loadu_si512(a + k);
+      __m512i y = _mm512_loadu_si512(b + k);
+      __m512i diff = _mm512_sub_epi64(x, y);
+      __m512i total = _mm512_mask_sub_epi64(diff, borrow, diff, one);
+      borrow = _mm512_cmplt_epu64_mask(x, y) | _mm512_cmplt_epu64_mask(diff, total);
+      _mm512_storeu_si512(r + k, total);
+    }
+  }
+  batch_sub_lanes(r, a, b, width, count, j, count);
+}
+
+__attribute__((target("avx512f")))
+void avx512_batch_cmp(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  size_t j = 0;
+  for (; j + 8 <= count; j += 8) {
+    __mmask8 greater = 0, less = 0;
+    for (size_t i = width; i > 0; --i) {
+      size_t k = (i - 1) * count + j;
+      __m512i x = _mm512_loadu_si512(a + k);
+      __m512i y = _mm512_loadu_si512(b + k);
+      __mmask8 undecided = __mmask8(~(greater | less));
+      greater |= _mm512_mask_cmpgt_epu64_mask(undecided, x, y);
+      less |= _mm512_mask_cmplt_epu64_mask(undecided, x, y);
+      if (__mmask8(greater | less) == 0xFF) { //random values differ in the top limb
+        break;
+      }
+    }
+    for (int lane = 0; lane < 8; ++lane) {
+      out[j + lane] = ((greater >> lane) & 1) - ((less >> lane) & 1);
+    }
+  }
+  batch_cmp_lanes(out, a, b, width, count, j, count);
+}
+
+#endif // LIMB_KERNELS_X86
+
+//Picks the fastest kernels the CPU running the program supports
+LimbKernels select_kernels() {
+  LimbKernels kernels = PORTABLE_KERNELS;
+#ifdef LIMB_KERNELS_X86
+  __builtin_cpu_init();
+  kernels.name = "x86-64";
+  kernels.add_n = x86_add_n;
+  kernels.sub_n = x86_sub_n;
+  if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx")) {
+    kernels.name = "x86-64 bmi2/adx";
+    kernels.addmul_1 = adx_addmul_1;
+    kernels.submul_1 = adx_submul_1;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    kernels.lshift = avx2_lshift;
+    kernels.rshift = avx2_rshift;
+    kernels.batch_add = avx2_batch_add;
+    kernels.batch_sub = avx2_batch_sub;
+    kernels.batch_cmp = avx2_batch_cmp;
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    kernels.batch_add = avx512_batch_add;
+    kernels.batch_sub = avx512_batch_sub;
+    kernels.batch_cmp = avx512_batch_cmp;
+  }
+  if (__builtin_cpu_supports("popcnt")) {
+    kernels.popcount = popcnt_popcount;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    kernels.to_hex = ssse3_to_hex;
+  }
+#endif
+  return kernels;
+}
+
+//The kernel table, filled in on first use so it is ready even for
+//BigInt objects constructed during static initialization
+LimbKernels &active_kernels() {
+  static LimbKernels kernels = select_kernels();
+  return kernels;
+}
+
+}
+
+const char *limb_kernel_name() {
+  return active_kernels().name;
+}
+
+void limb_use_portable_kernels(bool portable) {
+  active_kernels() = portable ? PORTABLE_KERNELS : select_kernels();
+}
+
+uint64_t limb_add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  return active_kernels().add_n(r, a, b, n);
+}
+
+uint64_t limb_sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+  return active_kernels().sub_n(r, a, b, n);
+}
+
+uint64_t limb_mul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  return active_kernels().mul_1(r, a, n, b);
+}
+
+uint64_t limb_addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  return active_kernels().addmul_1(r, a, n, b);
+}
+
+uint64_t limb_submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b) {
+  return active_kernels().submul_1(r, a, n, b);
+}
+
+uint64_t limb_lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  assert(n > 0 && shift > 0 && shift < 64);
+  return active_kernels().lshift(r, a, n, shift);
+}
+
+uint64_t limb_rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift) {
+  assert(n > 0 && shift > 0 && shift < 64);
+  return active_kernels().rshift(r, a, n, shift);
+}
+
+size_t limb_popcount(const uint64_t *a, size_t n) {
+  return active_kernels().popcount(a, n);
+}
+
+void limb_to_hex(char *out, const uint64_t *a, size_t n) {
+  active_kernels().to_hex(out, a, n);
+}
+
+void limb_batch_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  active_kernels().batch_add(r, a, b, width, count);
+}
+
+void limb_batch_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  active_kernels().batch_sub(r, a, b, width, count);
+}
+
+void limb_batch_cmp(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count) {
+  active_kernels().batch_cmp(out, a, b, width, count);
+}
@@ -0,0 +1,319 @@
+// Multiplication of very large limb arrays with number-theoretic
+// transforms (NTTs) modulo three primes.
+//
+// Each limb is used directly as a coefficient. A coefficient of the
+// product is a sum of at most min(an, bn) products of two limbs, so it
+// is below 2^(128 + 55) for any operands this code can handle, while
+// the three primes multiply to about 2^183.7. The product is therefore
+// computed exactly modulo each prime and recovered with the Chinese
+// remainder theorem; there is no floating point and no rounding.
+//
+// Arithmetic modulo each prime is done in Montgomery form with R = 2^64.
+// The forward transform is decimation-in-frequency and the inverse is
+// decimation-in-time, so neither needs a bit-reversal pass. Transform
+// lengths are 2^k or 3 * 2^k (one radix-3 step on top of radix-2
+// steps), so padding the product to the transform length wastes at
+// most a third of the work instead of half.
+
+#include <cassert>
+#include "limb_ops.h"
+#include "limb_arena.h"
+
+typedef unsigned __int128 u128;
+
+namespace {
+
+// A prime p = k * 2^e + 1 below 2^62, with k a multiple of 3, and its
+// Montgomery constants
+struct NttPrime {
+  uint64_t p;
+  uint64_t p_inv;   // -p^-1 mod 2^64
+  uint64_t r2;      // R^2 mod p
+  uint64_t one;     // R mod p, i.e. 1 in Montgomery form
+  uint64_t root;    // a primitive root mod p (plain value)
+  unsigned max_log; // e: transforms of up to 2^e points are possible
+
+  NttPrime(uint64_t p, uint64_t root, unsigned max_log) : p(p), root(root), max_log(max_log) {
+    uint64_t inv = p; //correct to 3 bits since p is odd, Newton doubles that each step
+    for (int i = 0; i < 5; ++i) {
+      inv *= 2 - p * inv;
+    }
+    p_inv = -inv;
+    one = (uint64_t) (((u128) 1 << 64) % p);
+    r2 = (uint64_t) ((u128) one * one % p);
+  }
+
+  //Montgomery product: a * b / R mod p, for a * b < p * R
+  uint64_t mul(uint64_t a, uint64_t b) const {
+    u128 t = (u128) a * b;
+    uint64_t m = (uint64_t) t * p_inv;
+    uint64_t u = (uint64_t) ((t + (u128) m * p) >> 64);
+    return u >= p ? u - p : u;
+  }
+
+  uint64_t add(uint64_t a, uint64_t b) const {
+    uint64_t s = a + b;
+    return s >= p ? s - p : s;
+  }
+
+  uint64_t sub(uint64_t a, uint64_t b) const {
+    return a >= b ? a - b : a + p - b;
+  }
+
+  //Converts any 64-bit value (even one above p) to Montgomery form
+  uint64_t to_mont(uint64_t a) const {
+    return mul(a, r2);
+  }
+
+  //Raises a Montgomery-form value to a power
+  uint64_t pow(uint64_t a, uint64_t e) const {
+    uint64_t result = one;
+    while (e > 0) {
+      if (e & 1) {
+        result = mul(result, a);
+      }
+      a = mul(a, a);
+      e >>= 1;
+    }
+    return result;
+  }
+};
+
+const NttPrime &prime(size_t i) {
+  static const NttPrime PRIMES[3] = {
+    NttPrime(3188548536178311169UL, 7, 54), // 177 * 2^54 + 1
+    NttPrime(2485986994308513793UL, 5, 55), // 69 * 2^55 + 1
+    NttPrime(1945555039024054273UL, 5, 56), // 27 * 2^56 + 1
+  };
+  return PRIMES[i];
+}
+
+// Fills roots[len/2 + j] with w_len^j for every power of two len <= n,
+// where w_len is a primitive len-th root of unity (or its inverse)
+void fill_roots(const NttPrime &q, uint64_t *roots, size_t n, bool inverse) {
+  uint64_t g = q.to_mont(q.root);
+  for (size_t len = 2; len <= n; len <<= 1) {
+    size_t half = len / 2;
+    uint64_t w = q.pow(g, (q.p - 1) / len);
+    if (inverse) {
+      w = q.pow(w, len - 1);
+    }
+    uint64_t x = q.one;
+    for (size_t j = 0; j < half; ++j) {
+      roots[half + j] = x;
+      x = q.mul(x, w);
+    }
+  }
+}
+
+// Forward transform, natural order in, bit-reversed order out
+void ntt_forward(const NttPrime &q, uint64_t *x, size_t n, const uint64_t *roots) {
+  for (size_t len = n; len >= 2; len >>= 1) {
+    size_t half = len / 2;
+    const uint64_t *w = roots + half;
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < half; ++j) {
+        uint64_t u = x[i + j];
+        uint64_t v = x[i + j + half];
+        x[i + j] = q.add(u, v);
+        x[i + j + half] = q.mul(q.sub(u, v), w[j]);
+      }
+    }
+  }
+}
+
+// Inverse transform without the 1/n scaling, bit-reversed order in,
+// natural order out
+void ntt_inverse(const NttPrime &q, uint64_t *x, size_t n, const uint64_t *roots) {
+  for (size_t len = 2; len <= n; len <<= 1) {
+    size_t half = len / 2;
+    const uint64_t *w = roots + half;
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < half; ++j) {
+        uint64_t u = x[i + j];
+        uint64_t v = q.mul(x[i + j + half], w[j]);
+        x[i + j] = q.add(u, v);
+        x[i + j + half] = q.sub(u, v);
+      }
+    }
+  }
+}
+
+// Radix-3 decimation-in-frequency step for a transform of length 3m:
+// leaves in block k (x[k*m..(k+1)*m)) the sequence whose m-point
+// transform gives the outputs with index congruent to k mod 3
+void radix3_forward(const NttPrime &q, uint64_t *x, size_t m) {
+  uint64_t w = q.pow(q.to_mont(q.root), (q.p - 1) / (3 * m)); //primitive 3m-th root
+  uint64_t omega = q.pow(w, m);                              //cube root of unity
+  uint64_t w1 = q.one, w2 = q.one, w_sq = q.mul(w, w);
+  for (size_t j = 0; j < m; ++j) {
+    uint64_t a0 = x[j], a1 = x[j + m], a2 = x[j + 2 * m];
+    //omega^2 = -1 - omega, so both odd outputs need only one product
+    uint64_t d = q.mul(q.sub(a1, a2), omega);
+    x[j] = q.add(q.add(a0, a1), a2);
+    x[j + m] = q.mul(q.add(q.sub(a0, a2), d), w1);
+    x[j + 2 * m] = q.mul(q.sub(q.sub(a0, a1), d), w2);
+    w1 = q.mul(w1, w);
+    w2 = q.mul(w2, w_sq);
+  }
+}
+
+// Inverse of radix3_forward, without the 1/3 scaling
+void radix3_inverse(const NttPrime &q, uint64_t *x, size_t m) {
+  uint64_t w = q.pow(q.to_mont(q.root), (q.p - 1) / (3 * m));
+  uint64_t omega = q.pow(w, m);
+  uint64_t w_inv = q.pow(w, 3 * m - 1);
+  uint64_t w1 = q.one, w2 = q.one, w_inv_sq = q.mul(w_inv, w_inv);
+  for (size_t j = 0; j < m; ++j) {
+    uint64_t z0 = x[j];
+    uint64_t z1 = q.mul(x[j + m], w1);
+    uint64_t z2 = q.mul(x[j + 2 * m], w2);
+    uint64_t d = q.mul(q.sub(z1, z2), omega);
+    x[j] = q.add(q.add(z0, z1), z2);
+    x[j + m] = q.sub(q.sub(z0, z1), d);
+    x[j + 2 * m] = q.add(q.sub(z0, z2), d);
+    w1 = q.mul(w1, w_inv);
+    w2 = q.mul(w2, w_inv_sq);
+  }
+}
+
+// Full forward transform of length n (a power of two, or 3 times one)
+void transform_forward(const NttPrime &q, uint64_t *x, size_t n, const uint64_t *roots) {
+  if (n % 3 == 0) {
+    size_t m = n / 3;
+    radix3_forward(q, x, m);
+    for (size_t k = 0; k < 3; ++k) {
+      ntt_forward(q, x + k * m, m, roots);
+    }
+  } else {
+    ntt_forward(q, x, n, roots);
+  }
+}
+
+// Inverse of transform_forward, without the 1/n scaling
+void transform_inverse(const NttPrime &q, uint64_t *x, size_t n, const uint64_t *roots) {
+  if (n % 3 == 0) {
+    size_t m = n / 3;
+    for (size_t k = 0; k < 3; ++k) {
+      ntt_inverse(q, x + k * m, m, roots);
+    }
+    radix3_inverse(q, x, m);
+  } else {
+    ntt_inverse(q, x, n, roots);
+  }
+}
+
+// Computes the cyclic convolution of a and b modulo one prime, leaving
+// the plain (non-Montgomery) coefficients in fa[0..n). fb is scratch,
+// and unused when squaring.
+void convolve(const NttPrime &q, uint64_t *fa, uint64_t *fb, uint64_t *roots, size_t n,
+              const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  bool square = (a == b && an == bn);
+  size_t radix2_length = n % 3 == 0 ? n / 3 : n;
+  for (size_t i = 0; i < n; ++i) {
+    fa[i] = i < an ? q.to_mont(a[i]) : 0;
+  }
+  fill_roots(q, roots, radix2_length, false);
+  transform_forward(q, fa, n, roots);
+  if (square) {
+    for (size_t i = 0; i < n; ++i) {
+      fa[i] = q.mul(fa[i], fa[i]);
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      fb[i] = i < bn ? q.to_mont(b[i]) : 0;
+    }
+    transform_forward(q, fb, n, roots);
+    for (size_t i = 0; i < n; ++i) {
+      fa[i] = q.mul(fa[i], fb[i]);
+    }
+  }
+
+  fill_roots(q, roots, radix2_length, true);
+  transform_inverse(q, fa, n, roots);
+
+  //Multiplying a Montgomery value by the plain value 1/n both scales
+  //it and converts it out of Montgomery form
+  uint64_t n_inv = q.pow(q.to_mont(n), q.p - 2); //Montgomery form of 1/n
+  n_inv = q.mul(n_inv, 1);                      //plain 1/n
+  for (size_t i = 0; i < n; ++i) {
+    fa[i] = q.mul(fa[i], n_inv);
+  }
+}
+
+}
+
+void limb_mul_ntt(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  assert(an >= bn && bn >= 1);
+
+  //Transform length: the smallest 2^k or 3 * 2^k that holds every coefficient
+  size_t coefficients = an + bn - 1;
+  size_t n = 1;
+  unsigned log_n = 0;
+  while (n < coefficients) {
+    n <<= 1;
+    ++log_n;
+  }
+  if (n >= 4 && 3 * (n / 4) >= coefficients) {
+    n = 3 * (n / 4);
+    log_n -= 2;
+  }
+  for (size_t k = 0; k < 3; ++k) {
+    assert(log_n <= prime(k).max_log);
+  }
+  (void) log_n;
+
+  LimbScratchScope scratch;
+  uint64_t *residues[3];
+  uint64_t *work[3];
+  uint64_t *roots[3];
+  for (size_t k = 0; k < 3; ++k) {
+    residues[k] = scratch.allocate(n);
+    work[k] = scratch.allocate(n);
+    roots[k] = scratch.allocate(n);
+  }
+
+  //The three primes are independent, so they can run on separate threads
+  limb_parallel_for(3, [&](size_t k) {
+    convolve(prime(k), residues[k], work[k], roots[k], n, a, an, b, bn);
+  });
+
+  //Garner's algorithm: x = x1 + x2 * p1 + x3 * p1 * p2, with xk < pk
+  const NttPrime &q1 = prime(0), &q2 = prime(1), &q3 = prime(2);
+  uint64_t inv_p1_mod_p2 = q2.pow(q2.to_mont(q1.p), q2.p - 2);          //Montgomery form
+  uint64_t p1_mod_p3 = q3.to_mont(q1.p);                                //Montgomery form
+  uint64_t p12_mod_p3 = q3.mul(p1_mod_p3, q3.to_mont(q2.p));            //Montgomery form
+  uint64_t inv_p12_mod_p3 = q3.pow(p12_mod_p3, q3.p - 2);               //Montgomery form
+  u128 p12 = (u128) q1.p * q2.p;
+  uint64_t p12_lo = (uint64_t) p12, p12_hi = (uint64_t) (p12 >> 64);
+
+  //acc holds the part of the sum not yet written to r (at most 3 limbs)
+  uint64_t acc0 = 0, acc1 = 0, acc2 = 0;
+  for (size_t i = 0; i < coefficients; ++i) {
+    uint64_t x1 = residues[0][i];
+    uint64_t x1_mod_p2 = x1 >= q2.p ? x1 - q2.p : x1; //p1 < 2 * p2
+    //mul() of a plain value and a Montgomery value gives a plain product
+    uint64_t x2 = q2.mul(q2.sub(residues[1][i], x1_mod_p2), inv_p1_mod_p2);
+    uint64_t t = q3.sub(residues[2][i], x1 % q3.p);
+    t = q3.sub(t, q3.mul(x2, p1_mod_p3));
+    uint64_t x3 = q3.mul(t, inv_p12_mod_p3);
+
+    //x = x1 + x2 * p1 + x3 * p12, added to acc
+    u128 low = (u128) x2 * q1.p + x1;
+    u128 mid = (u128) x3 * p12_lo;
+    u128 high = (u128) x3 * p12_hi;
+
+    u128 s = (u128) acc0 + (uint64_t) low + (uint64_t) mid;
+    acc0 = (uint64_t) s;
+    s = (s >> 64) + acc1 + (uint64_t) (low >> 64) + (uint64_t) (mid >> 64) + (uint64_t) high;
+    acc1 = (uint64_t) s;
+    acc2 += (uint64_t) (s >> 64) + (uint64_t) (high >> 64);
+
+    r[i] = acc0;
+    acc0 = acc1;
+    acc1 = acc2;
+    acc2 = 0;
+  }
+  r[coefficients] = acc0;
+  assert(acc1 == 0);
+}
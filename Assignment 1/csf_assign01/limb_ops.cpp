@@ -0,0 +1,652 @@
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include "limb_ops.h"
+#include "limb_arena.h"
+
+//Tuned on x86-64 with bigint_bench (see README.txt). Below these sizes
+//the extra additions of the divide-and-conquer methods cost more than they save.
+size_t limb_karatsuba_threshold = 32;
+size_t limb_sqr_karatsuba_threshold = 48;
+size_t limb_toom3_threshold = 256;
+size_t limb_ntt_threshold = 10000;
+size_t limb_newton_threshold = 2500;
+
+//Serial by default; multithreading is opt-in
+unsigned limb_mul_threads = 1;
+size_t limb_parallel_threshold = 2048;
+
+//Smallest sizes at which the recursive methods are guaranteed to shrink their
+//subproblems, regardless of how low the tunable thresholds are set.
+static const size_t KARATSUBA_MIN_LIMBS = 4;
+static const size_t TOOM3_MIN_LIMBS = 12;
+
+typedef unsigned __int128 u128;
+
+//Threads the calling thread may use for limb_parallel_for. 0 means the thread
+//is not running parallel work yet, so limb_mul_threads applies.
+static thread_local unsigned thread_budget = 0;
+
+//Joins every thread limb_parallel_for started and restores the caller's
+//budget, on the normal path and when an exception unwinds through it
+struct ParallelScope {
+  std::vector<std::thread> pool;
+  unsigned saved_budget;
+
+  ParallelScope() : saved_budget(thread_budget) { }
+
+  ~ParallelScope() {
+    for (std::thread &t : pool) {
+      t.join();
+    }
+    thread_budget = saved_budget;
+  }
+};
+
+//Hands every worker thread an equal share of the caller's threads, so nested
+//calls (Toom-3 inside Toom-3, or inside a product tree) never oversubscribe.
+//An exception from fn stops the remaining calls and is rethrown on the
+//calling thread once all the workers have finished
+void limb_parallel_for(size_t count, const std::function<void(size_t)> &fn) {
+  unsigned threads = thread_budget ? thread_budget : std::max(limb_mul_threads, 1u);
+  if (threads <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  unsigned workers = unsigned(std::min<size_t>(threads, count));
+  unsigned share = threads / workers;
+  std::vector<std::exception_ptr> errors(workers);
+  std::atomic<bool> failed(false);
+  auto run = [&](unsigned w) {
+    thread_budget = share;
+    try {
+      for (size_t i = w; i < count && !failed.load(std::memory_order_relaxed); i += workers) {
+        fn(i);
+      }
+    } catch (...) {
+      errors[w] = std::current_exception();
+      failed = true;
+    }
+  };
+
+  {
+    ParallelScope scope;
+    scope.pool.reserve(workers - 1);
+    try {
+      for (unsigned w = 1; w < workers; ++w) {
+        scope.pool.emplace_back(run, w);
+      }
+    } catch (...) {
+      failed = true; //the threads already started stop early and are joined
+      throw;
+    }
+    run(0);
+  }
+  for (std::exception_ptr &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+//Returns the length of the array once the most significant zero limbs are ignored
+size_t limb_normalized_size(const uint64_t *a, size_t n) {
+  while (n > 0 && a[n - 1] == 0) {
+    --n;
+  }
+  return n;
+}
+
+//Counts the bits below and including the highest set bit
+size_t limb_bit_length(const uint64_t *a, size_t n) {
+  n = limb_normalized_size(a, n);
+  if (n == 0) {
+    return 0;
+  }
+  return 64 * n - __builtin_clzll(a[n - 1]);
+}
+
+//Compares two equally sized arrays starting from the most significant limb
+int limb_cmp(const uint64_t *a, const uint64_t *b, size_t n) {
+  while (n > 0) {
+    --n;
+    if (a[n] != b[n]) {
+      return a[n] > b[n] ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+//Adds a shorter array onto a longer one, propagating the carry through the upper limbs
+uint64_t limb_add(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  uint64_t carry = limb_add_n(r, a, b, bn);
+  for (size_t i = bn; i < an; ++i) {
+    uint64_t sum = a[i] + carry;
+    carry = (sum < carry);
+    r[i] = sum;
+  }
+  return carry;
+}
+
+//Subtracts a shorter array from a longer one, propagating the borrow through the upper limbs
+uint64_t limb_sub(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  uint64_t borrow = limb_sub_n(r, a, b, bn);
+  for (size_t i = bn; i < an; ++i) {
+    uint64_t lhs = a[i];
+    r[i] = lhs - borrow;
+    borrow = (lhs < borrow);
+  }
+  return borrow;
+}
+
+//Returns floor((B^2 - 1) / d) - B for a normalized d (top bit set), the
+//reciprocal used by div_2by1 to replace hardware division with multiplication
+static uint64_t reciprocal_2by1(uint64_t d) {
+  return (uint64_t) ((((u128) ~d) << 64 | ~(uint64_t) 0) / d);
+}
+
+//Divides the two-limb value (u1:u0) by a normalized d with the precomputed
+//reciprocal v (Moller and Granlund, "Improved division by invariant integers").
+//Requires u1 < d. Stores the remainder in rem and returns the quotient.
+static uint64_t div_2by1(uint64_t u1, uint64_t u0, uint64_t d, uint64_t v, uint64_t &rem) {
+  u128 q = (u128) v * u1 + (((u128) u1 << 64) | u0);
+  uint64_t q1 = (uint64_t) (q >> 64) + 1;
+  uint64_t q0 = (uint64_t) q;
+  uint64_t r = u0 - q1 * d;
+  if (r > q0) { //estimate was one too large
+    --q1;
+    r += d;
+  }
+  if (r >= d) { //rare: estimate was one too small
+    ++q1;
+    r -= d;
+  }
+  rem = r;
+  return q1;
+}
+
+//Divides an array by a single limb from the most significant limb down.
+//Dividend and divisor are both shifted left so the divisor's top bit is set,
+//which lets every step be a 2-by-1 division by a precomputed reciprocal.
+uint64_t limb_divrem_1(uint64_t *q, const uint64_t *a, size_t n, uint64_t d) {
+  assert(d != 0);
+  if (n == 0) {
+    return 0;
+  }
+  unsigned shift = __builtin_clzll(d);
+  uint64_t d_norm = d << shift;
+  uint64_t v = reciprocal_2by1(d_norm);
+
+  //Bits shifted out of the top limb start off the remainder (always < d_norm)
+  uint64_t rem = shift ? a[n - 1] >> (64 - shift) : 0;
+  for (size_t i = n; i > 0; --i) {
+    uint64_t low = a[i - 1] << shift;
+    if (shift && i > 1) {
+      low |= a[i - 2] >> (64 - shift);
+    }
+    q[i - 1] = div_2by1(rem, low, d_norm, v, rem);
+  }
+  return rem >> shift;
+}
+
+//Same steps as limb_divrem_1 without storing the quotient limbs
+uint64_t limb_mod_1(const uint64_t *a, size_t n, uint64_t d) {
+  assert(d != 0);
+  if (n == 0) {
+    return 0;
+  }
+  unsigned shift = __builtin_clzll(d);
+  uint64_t d_norm = d << shift;
+  uint64_t v = reciprocal_2by1(d_norm);
+
+  uint64_t rem = shift ? a[n - 1] >> (64 - shift) : 0;
+  for (size_t i = n; i > 0; --i) {
+    uint64_t low = a[i - 1] << shift;
+    if (shift && i > 1) {
+      low |= a[i - 2] >> (64 - shift);
+    }
+    div_2by1(rem, low, d_norm, v, rem);
+  }
+  return rem >> shift;
+}
+
+//Knuth's Algorithm D (TAOCP vol. 2, 4.3.1). The divisor is normalized so its
+//top bit is set, which makes each estimated quotient limb at most two too large.
+void limb_divrem(uint64_t *q, uint64_t *r, const uint64_t *a, size_t an, const uint64_t *d, size_t dn) {
+  assert(an >= dn && dn >= 2 && d[dn - 1] != 0);
+
+  //D1: normalize
+  LimbScratchScope scratch;
+  unsigned shift = __builtin_clzll(d[dn - 1]);
+  uint64_t *v = scratch.allocate(dn);
+  uint64_t *u = scratch.allocate(an + 1);
+  if (shift) {
+    limb_lshift(v, d, dn, shift);
+    u[an] = limb_lshift(u, a, an, shift);
+  } else {
+    std::copy(d, d + dn, v);
+    std::copy(a, a + an, u);
+    u[an] = 0;
+  }
+
+  uint64_t v_top = v[dn - 1];
+  uint64_t v_next = v[dn - 2];
+  uint64_t v_inv = reciprocal_2by1(v_top);
+
+  //D2-D7: one quotient limb per iteration, most significant first
+  for (size_t j = an - dn + 1; j > 0; --j) {
+    uint64_t *window = u + (j - 1); //dn+1 limbs being divided
+    uint64_t u2 = window[dn];
+    uint64_t u1 = window[dn - 1];
+    uint64_t u0 = window[dn - 2];
+
+    //D3: estimate the quotient limb from the top two limbs of the window
+    uint64_t q_hat;
+    uint64_t r_hat;
+    bool r_hat_overflow = false;
+    if (u2 >= v_top) { //u2 == v_top, the estimate would not fit in a limb
+      q_hat = ~(uint64_t) 0;
+      r_hat = u1 + v_top;
+      r_hat_overflow = (r_hat < v_top);
+    } else {
+      q_hat = div_2by1(u2, u1, v_top, v_inv, r_hat);
+    }
+
+    //Refine using the next divisor limb; this removes almost every overestimate
+    while (!r_hat_overflow && (u128) q_hat * v_next > (((u128) r_hat << 64) | u0)) {
+      --q_hat;
+      r_hat += v_top;
+      r_hat_overflow = (r_hat < v_top);
+    }
+
+    //D4: multiply and subtract
+    uint64_t borrow = limb_submul_1(window, v, dn, q_hat);
+    bool negative = (window[dn] < borrow);
+    window[dn] -= borrow;
+
+    //D6: add back in the rare case the estimate was still one too large
+    if (negative) {
+      --q_hat;
+      window[dn] += limb_add_n(window, window, v, dn);
+    }
+
+    q[j - 1] = q_hat;
+  }
+
+  //D8: unnormalize the remainder
+  if (shift) {
+    limb_rshift(r, u, dn, shift);
+  } else {
+    std::copy(u, u + dn, r);
+  }
+}
+
+//Grade school multiplication: one row of partial products per limb of b
+void limb_mul_basecase(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  r[an] = limb_mul_1(r, a, an, b[0]);
+  for (size_t j = 1; j < bn; ++j) {
+    r[an + j] = limb_addmul_1(r + j, a, an, b[j]);
+  }
+}
+
+//Schoolbook squaring: each cross product a[i]*a[j] with i < j appears twice
+//in the square, so the triangle of them is computed once and doubled with a
+//shift before the diagonal squares a[i]^2 are added in, about half the
+//partial products of limb_mul_basecase
+void limb_sqr_basecase(uint64_t *r, const uint64_t *a, size_t n) {
+  r[0] = 0;
+  r[2 * n - 1] = 0;
+  if (n > 1) {
+    //Row i adds a[i] * a[i+1..n) at r[2i+1], leaving its carry in the new limb r[n+i]
+    r[n] = limb_mul_1(r + 1, a + 1, n - 1, a[0]);
+    for (size_t i = 1; i + 1 < n; ++i) {
+      r[n + i] = limb_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    r[2 * n - 1] = limb_lshift(r, r, 2 * n - 1, 1);
+  }
+
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    u128 sq = (u128) a[i] * a[i];
+    u128 low = (u128) r[2 * i] + (uint64_t) sq + carry;
+    u128 high = (u128) r[2 * i + 1] + (uint64_t) (sq >> 64) + (uint64_t) (low >> 64);
+    r[2 * i] = (uint64_t) low;
+    r[2 * i + 1] = (uint64_t) high;
+    carry = (uint64_t) (high >> 64);
+  }
+  assert(carry == 0);
+}
+
+//Multiplies a long operand by a much shorter one by cutting the long operand
+//into pieces the size of the short one and multiplying each piece separately
+static void mul_unbalanced(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  LimbScratchScope scratch;
+  std::fill(r, r + an + bn, 0);
+  uint64_t *piece_product = scratch.allocate(2 * bn);
+
+  for (size_t i = 0; i < an; i += bn) {
+    size_t piece = std::min(bn, an - i);
+    if (piece == bn) {
+      limb_mul(piece_product, a + i, piece, b, bn);
+    } else {
+      limb_mul(piece_product, b, bn, a + i, piece);
+    }
+
+    //Everything at or above r[i + bn] is still zero, so the sum cannot carry out
+    uint64_t carry = limb_add_n(r + i, r + i, piece_product, piece + bn);
+    assert(carry == 0);
+    (void) carry;
+  }
+}
+
+//Karatsuba multiplication: with a = a1*B^m + a0 and b = b1*B^m + b0,
+//a*b = z2*B^2m + (z1 - z2 - z0)*B^m + z0 where z0 = a0*b0, z2 = a1*b1
+//and z1 = (a0 + a1)*(b0 + b1), so only three half-size products are needed.
+//Requires an >= bn > an/2.
+static void mul_karatsuba(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  size_t m = an / 2; //size of the low halves
+  size_t ah = an - m; //size of a1
+  size_t bh = bn - m; //size of b1 (ah >= bh >= 1)
+
+  //z0 goes to r[0..2m), z2 goes to r[2m..an+bn)
+  limb_mul(r, a, m, b, m);
+  limb_mul(r + 2 * m, a + m, ah, b + m, bh);
+
+  //Sums of the halves, each with room for a carry limb
+  LimbScratchScope scratch;
+  uint64_t *sum_a = scratch.allocate(ah + 1);
+  sum_a[ah] = limb_add(sum_a, a + m, ah, a, m);
+
+  size_t sum_b_size = std::max(m, bh);
+  uint64_t *sum_b = scratch.allocate(sum_b_size + 1);
+  if (bh >= m) {
+    sum_b[sum_b_size] = limb_add(sum_b, b + m, bh, b, m);
+  } else {
+    sum_b[sum_b_size] = limb_add(sum_b, b, m, b + m, bh);
+  }
+
+  size_t san = limb_normalized_size(sum_a, ah + 1);
+  size_t sbn = limb_normalized_size(sum_b, sum_b_size + 1);
+
+  //z1 needs room for both subtractions even when the sums are short
+  size_t z1_size = std::max(std::max(san + sbn, 2 * m), ah + bh);
+  uint64_t *z1 = scratch.allocate_zeroed(z1_size);
+  if (san > 0 && sbn > 0) {
+    if (san >= sbn) {
+      limb_mul(z1, sum_a, san, sum_b, sbn);
+    } else {
+      limb_mul(z1, sum_b, sbn, sum_a, san);
+    }
+  }
+
+  //z1 - z0 - z2 = a0*b1 + a1*b0, which is never negative
+  uint64_t borrow = limb_sub(z1, z1, z1_size, r, 2 * m);
+  borrow += limb_sub(z1, z1, z1_size, r + 2 * m, ah + bh);
+  assert(borrow == 0);
+
+  size_t mid = limb_normalized_size(z1, z1_size);
+  uint64_t carry = limb_add(r + m, r + m, an + bn - m, z1, mid);
+  assert(carry == 0);
+  (void) borrow;
+  (void) carry;
+}
+
+//Karatsuba squaring: with a = a1*B^m + a0, a^2 = z2*B^2m + (z0 + z2 - z1)*B^m + z0
+//where z0 = a0^2, z2 = a1^2 and z1 = (a1 - a0)^2. Taking the difference
+//instead of the sum keeps the middle square from growing a carry limb.
+//Requires n >= 2.
+static void sqr_karatsuba(uint64_t *r, const uint64_t *a, size_t n) {
+  size_t m = n / 2; //size of a0
+  size_t h = n - m; //size of a1 (h >= m)
+
+  //z0 goes to r[0..2m), z2 goes to r[2m..2n)
+  limb_sqr(r, a, m);
+  limb_sqr(r + 2 * m, a + m, h);
+
+  //|a1 - a0|, which has at most h limbs
+  LimbScratchScope scratch;
+  size_t a0n = limb_normalized_size(a, m);
+  size_t a1n = limb_normalized_size(a + m, h);
+  uint64_t *diff = scratch.allocate(h);
+  size_t dn;
+  if (a1n > a0n || (a1n == a0n && limb_cmp(a + m, a, a1n) >= 0)) {
+    limb_sub(diff, a + m, a1n, a, a0n);
+    dn = limb_normalized_size(diff, a1n);
+  } else {
+    limb_sub(diff, a, a0n, a + m, a1n);
+    dn = limb_normalized_size(diff, a0n);
+  }
+
+  //z0 + z2 - z1 = 2*a0*a1, which is never negative
+  uint64_t *mid = scratch.allocate(2 * h + 1);
+  mid[2 * h] = limb_add(mid, r + 2 * m, 2 * h, r, 2 * m);
+  if (dn > 0) {
+    uint64_t *z1 = scratch.allocate(2 * dn);
+    limb_sqr(z1, diff, dn);
+    uint64_t borrow = limb_sub(mid, mid, 2 * h + 1, z1, 2 * dn);
+    assert(borrow == 0);
+    (void) borrow;
+  }
+
+  uint64_t carry = limb_add(r + m, r + m, 2 * n - m, mid, limb_normalized_size(mid, 2 * h + 1));
+  assert(carry == 0);
+  (void) carry;
+}
+
+//Signed-magnitude scratch value used by Toom-3 evaluation and interpolation,
+//where intermediate values can be negative. The magnitude is kept normalized
+//and points either into an operand or into arena scratch space.
+struct ToomValue {
+  const uint64_t *mag;
+  size_t size;
+  bool negative;
+};
+
+//Builds a ToomValue from a slice of limbs (the slice may be empty)
+static ToomValue toom_from(const uint64_t *a, size_t n) {
+  return ToomValue{ a, limb_normalized_size(a, n), false };
+}
+
+//Finishes a freshly computed value: normalizes it and clears the sign of zero
+static ToomValue toom_result(const uint64_t *mag, size_t size, bool negative) {
+  size = limb_normalized_size(mag, size);
+  return ToomValue{ mag, size, negative && size > 0 };
+}
+
+//Compares two normalized magnitudes
+static int toom_cmp_mag(const ToomValue &a, const ToomValue &b) {
+  if (a.size != b.size) {
+    return a.size > b.size ? 1 : -1;
+  }
+  return limb_cmp(a.mag, b.mag, a.size);
+}
+
+//Returns x + y for signed values
+static ToomValue toom_add(LimbScratchScope &scratch, const ToomValue &x, const ToomValue &y) {
+  if (x.negative == y.negative) { //same sign, add magnitudes
+    const ToomValue &big = x.size >= y.size ? x : y;
+    const ToomValue &small = x.size >= y.size ? y : x;
+    uint64_t *r = scratch.allocate(big.size + 1);
+    r[big.size] = limb_add(r, big.mag, big.size, small.mag, small.size);
+    return toom_result(r, big.size + 1, x.negative);
+  }
+
+  //opposite signs, subtract smaller magnitude from larger
+  int cmp = toom_cmp_mag(x, y);
+  const ToomValue &big = cmp >= 0 ? x : y;
+  const ToomValue &small = cmp >= 0 ? y : x;
+  uint64_t *r = scratch.allocate(big.size);
+  limb_sub(r, big.mag, big.size, small.mag, small.size);
+  return toom_result(r, big.size, big.negative);
+}
+
+//Returns x - y for signed values
+static ToomValue toom_sub(LimbScratchScope &scratch, const ToomValue &x, ToomValue y) {
+  y.negative = !y.negative && y.size > 0;
+  return toom_add(scratch, x, y);
+}
+
+//Returns x * y for signed values, stored in r[0..x.size+y.size)
+static ToomValue toom_mul(uint64_t *r, const ToomValue &x, const ToomValue &y) {
+  if (x.size == 0 || y.size == 0) {
+    return ToomValue{ nullptr, 0, false };
+  }
+  if (x.mag == y.mag && x.size == y.size) {
+    limb_sqr(r, x.mag, x.size);
+    return toom_result(r, 2 * x.size, false);
+  }
+  const ToomValue &big = x.size >= y.size ? x : y;
+  const ToomValue &small = x.size >= y.size ? y : x;
+  limb_mul(r, big.mag, big.size, small.mag, small.size);
+  return toom_result(r, big.size + small.size, x.negative != y.negative);
+}
+
+//Multiplies a signed value by 2
+static ToomValue toom_mul_2(LimbScratchScope &scratch, const ToomValue &x) {
+  return toom_add(scratch, x, x);
+}
+
+//Divides a signed value by 2; the value must be even
+static ToomValue toom_div_2(LimbScratchScope &scratch, const ToomValue &x) {
+  if (x.size == 0) {
+    return x;
+  }
+  uint64_t *r = scratch.allocate(x.size);
+  limb_rshift(r, x.mag, x.size, 1);
+  return toom_result(r, x.size, x.negative);
+}
+
+//Divides a signed value by 3; the value must be a multiple of 3
+static ToomValue toom_div_3(LimbScratchScope &scratch, const ToomValue &x) {
+  uint64_t *r = scratch.allocate(x.size);
+  uint64_t rem = limb_divrem_1(r, x.mag, x.size, 3);
+  assert(rem == 0);
+  (void) rem;
+  return toom_result(r, x.size, x.negative);
+}
+
+//Toom-3 multiplication: split both operands into three pieces of k limbs,
+//evaluate the piece polynomials at 0, 1, -1, -2 and infinity, multiply pointwise
+//and interpolate the five coefficients of the product (Bodrato's sequence).
+//When squaring, a is evaluated once and the pointwise products are squares.
+//Requires an >= bn > 2 * ceil(an / 3).
+static void mul_toom3(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  size_t k = (an + 2) / 3;
+  bool square = (a == b && an == bn);
+
+  LimbScratchScope scratch;
+  ToomValue a0 = toom_from(a, k);
+  ToomValue a1 = toom_from(a + k, k);
+  ToomValue a2 = toom_from(a + 2 * k, an - 2 * k);
+
+  //Evaluation
+  ToomValue pa = toom_add(scratch, a0, a2);
+  ToomValue a_at_1 = toom_add(scratch, pa, a1);
+  ToomValue a_at_m1 = toom_sub(scratch, pa, a1);
+  ToomValue a_at_m2 = toom_sub(scratch, toom_mul_2(scratch, toom_add(scratch, a_at_m1, a2)), a0);
+  ToomValue b0 = a0, b2 = a2, b_at_1 = a_at_1, b_at_m1 = a_at_m1, b_at_m2 = a_at_m2;
+  if (!square) {
+    b0 = toom_from(b, k);
+    ToomValue b1 = toom_from(b + k, k);
+    b2 = toom_from(b + 2 * k, bn - 2 * k);
+    ToomValue pb = toom_add(scratch, b0, b2);
+    b_at_1 = toom_add(scratch, pb, b1);
+    b_at_m1 = toom_sub(scratch, pb, b1);
+    b_at_m2 = toom_sub(scratch, toom_mul_2(scratch, toom_add(scratch, b_at_m1, b2)), b0);
+  }
+
+  //Pointwise products. The buffers come from this thread's arena up front,
+  //so for large operands the five products can run on other threads.
+  const ToomValue *factors[5][2] = {
+    { &a0, &b0 }, { &a_at_1, &b_at_1 }, { &a_at_m1, &b_at_m1 }, { &a_at_m2, &b_at_m2 }, { &a2, &b2 }
+  };
+  uint64_t *buffers[5];
+  for (size_t i = 0; i < 5; ++i) {
+    buffers[i] = scratch.allocate(factors[i][0]->size + factors[i][1]->size);
+  }
+  ToomValue products[5];
+  auto pointwise = [&](size_t i) {
+    products[i] = toom_mul(buffers[i], *factors[i][0], *factors[i][1]);
+  };
+  if (bn >= limb_parallel_threshold) {
+    limb_parallel_for(5, pointwise);
+  } else {
+    for (size_t i = 0; i < 5; ++i) {
+      pointwise(i);
+    }
+  }
+  ToomValue r0 = products[0];
+  ToomValue r_1 = products[1];
+  ToomValue r_m1 = products[2];
+  ToomValue r_m2 = products[3];
+  ToomValue r4 = products[4];
+
+  //Interpolation
+  ToomValue r3 = toom_div_3(scratch, toom_sub(scratch, r_m2, r_1));
+  ToomValue r1 = toom_div_2(scratch, toom_sub(scratch, r_1, r_m1));
+  ToomValue r2 = toom_sub(scratch, r_m1, r0);
+  r3 = toom_add(scratch, toom_div_2(scratch, toom_sub(scratch, r2, r3)), toom_mul_2(scratch, r4));
+  r2 = toom_sub(scratch, toom_add(scratch, r2, r1), r4);
+  r1 = toom_sub(scratch, r1, r3);
+
+  //Recomposition: every coefficient is a sum of non-negative products
+  size_t rn = an + bn;
+  std::fill(r, r + rn, 0);
+  const ToomValue *coefficients[5] = { &r0, &r1, &r2, &r3, &r4 };
+  for (size_t i = 0; i < 5; ++i) {
+    const ToomValue &c = *coefficients[i];
+    assert(!c.negative);
+    if (c.size == 0) {
+      continue;
+    }
+    size_t offset = i * k;
+    uint64_t carry = limb_add(r + offset, r + offset, rn - offset, c.mag, c.size);
+    assert(carry == 0);
+    (void) carry;
+  }
+}
+
+//Picks a squaring algorithm from the operand size. Squaring has its own
+//Karatsuba threshold because its basecase is cheaper; Toom-3 and the NTT
+//detect the square themselves.
+void limb_sqr(uint64_t *r, const uint64_t *a, size_t n) {
+  assert(n >= 1);
+
+  if (n < limb_sqr_karatsuba_threshold || n < KARATSUBA_MIN_LIMBS) {
+    limb_sqr_basecase(r, a, n);
+  } else if (n >= limb_ntt_threshold) {
+    limb_mul_ntt(r, a, n, a, n);
+  } else if (n < limb_toom3_threshold || n < TOOM3_MIN_LIMBS) {
+    sqr_karatsuba(r, a, n);
+  } else {
+    mul_toom3(r, a, n, a, n);
+  }
+}
+
+//Picks a multiplication algorithm from the operand sizes
+void limb_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  assert(an >= bn && bn >= 1);
+
+  if (a == b && an == bn) {
+    limb_sqr(r, a, an);
+    return;
+  }
+
+  if (bn < limb_karatsuba_threshold || bn < KARATSUBA_MIN_LIMBS) {
+    limb_mul_basecase(r, a, an, b, bn);
+  } else if (bn >= limb_ntt_threshold) {
+    limb_mul_ntt(r, a, an, b, bn);
+  } else if (2 * bn <= an) { //too lopsided to split both operands at the same point
+    mul_unbalanced(r, a, an, b, bn);
+  } else if (bn < limb_toom3_threshold || bn < TOOM3_MIN_LIMBS || bn <= 2 * ((an + 2) / 3)) {
+    mul_karatsuba(r, a, an, b, bn);
+  } else {
+    mul_toom3(r, a, an, b, bn);
+  }
+}
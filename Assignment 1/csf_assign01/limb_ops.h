@@ -0,0 +1,230 @@
+#ifndef LIMB_OPS_H
+#define LIMB_OPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+//! @file
+//! Low-level arithmetic on little-endian arrays of `uint64_t` limbs.
+//! These functions know nothing about signs or BigInt objects; they
+//! operate on raw magnitudes and are the building blocks BigInt uses
+//! for its arithmetic operators.
+
+//! Operand size (in limbs) at which limb_mul switches from schoolbook
+//! multiplication to Karatsuba. Measured with `bigint_bench`.
+extern size_t limb_karatsuba_threshold;
+
+//! Operand size (in limbs) at which limb_sqr switches from schoolbook
+//! squaring to Karatsuba. Higher than limb_karatsuba_threshold because
+//! schoolbook squaring does half the work of schoolbook multiplication.
+//! Measured with `bigint_bench sqr`.
+extern size_t limb_sqr_karatsuba_threshold;
+
+//! Operand size (in limbs) at which limb_mul switches from Karatsuba
+//! to Toom-3. Measured with `bigint_bench`.
+extern size_t limb_toom3_threshold;
+
+//! Operand size (in limbs) at which limb_mul switches from Toom-3 to
+//! multiplication by number-theoretic transforms. Measured with
+//! `bigint_bench`.
+extern size_t limb_ntt_threshold;
+
+//! Divisor and quotient size (in limbs) from which BigInt division
+//! multiplies by a Newton reciprocal instead of running limb_divrem.
+//! Measured with `bigint_bench`.
+extern size_t limb_newton_threshold;
+
+//! Operand size (in limbs) from which limb_gcd takes Lehmer steps
+//! instead of binary GCD steps. Measured with `bigint_bench`.
+extern size_t limb_lehmer_threshold;
+
+//! Number of threads a multiplication (or product tree) may use. The
+//! default of 1 keeps all arithmetic on the calling thread.
+extern unsigned limb_mul_threads;
+
+//! Operand size (in limbs) from which Toom-3 runs its five pointwise
+//! products on separate threads, when limb_mul_threads allows it.
+extern size_t limb_parallel_threshold;
+
+//! Call `fn(0)`, ..., `fn(count - 1)`, spreading the calls over the
+//! threads available to the caller: limb_mul_threads at the top level,
+//! or the caller's share when called from inside another
+//! limb_parallel_for. The calls must be independent of each other.
+//! Each thread has its own LimbArena, so buffers that must outlive a
+//! call have to be allocated before calling this.
+//!
+//! @param count number of calls
+//! @param fn function to call with each index
+//! @throw the first exception thrown by `fn`, once every thread has
+//!        finished; after an exception the remaining calls may be skipped
+void limb_parallel_for(size_t count, const std::function<void(size_t)> &fn);
+
+//! Name of the set of inner-loop kernels (add_n, sub_n, mul_1, addmul_1,
+//! submul_1, lshift, rshift, popcount, to_hex and the batch kernels)
+//! picked for this CPU, e.g. "x86-64 bmi2/adx".
+const char *limb_kernel_name();
+
+//! Switch between the portable C++ kernels and the fastest kernels this
+//! CPU supports (the default). Meant for tests and benchmarks; it must
+//! not be called while other threads are doing arithmetic.
+//!
+//! @param portable if true, use the portable kernels
+void limb_use_portable_kernels(bool portable);
+
+//! Return the number of significant limbs in `a[0..n)`, i.e. `n` with
+//! any most-significant zero limbs removed.
+size_t limb_normalized_size(const uint64_t *a, size_t n);
+
+//! Return the number of significant bits in `a[0..n)` (0 if it is 0).
+size_t limb_bit_length(const uint64_t *a, size_t n);
+
+//! Compare `a[0..n)` and `b[0..n)` as unsigned integers.
+//!
+//! @return negative, 0 or positive if a is less than, equal to or
+//!         greater than b
+int limb_cmp(const uint64_t *a, const uint64_t *b, size_t n);
+
+//! Set `r[0..n) = a[0..n) + b[0..n)`.
+//!
+//! @return the carry out of the most significant limb (0 or 1)
+uint64_t limb_add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+
+//! Set `r[0..an) = a[0..an) + b[0..bn)`. Requires `an >= bn`.
+//!
+//! @return the carry out of the most significant limb (0 or 1)
+uint64_t limb_add(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+//! Set `r[0..n) = a[0..n) - b[0..n)`.
+//!
+//! @return the borrow out of the most significant limb (0 or 1)
+uint64_t limb_sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+
+//! Set `r[0..an) = a[0..an) - b[0..bn)`. Requires `an >= bn`.
+//!
+//! @return the borrow out of the most significant limb (0 or 1)
+uint64_t limb_sub(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+//! Set `r[0..n) = a[0..n) * b`.
+//!
+//! @return the most significant limb of the product
+uint64_t limb_mul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+
+//! Set `r[0..n) = r[0..n) + a[0..n) * b`.
+//!
+//! @return the limb carried out of `r[n-1]`
+uint64_t limb_addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+
+//! Set `r[0..n) = r[0..n) - a[0..n) * b`.
+//!
+//! @return the limb borrowed out of `r[n-1]`
+uint64_t limb_submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+
+//! Set `r[0..n) = a[0..n) << shift`. Requires `0 < shift < 64`.
+//! `r` may alias `a`.
+//!
+//! @return the bits shifted out of `a[n-1]`, in the low bits of the result
+uint64_t limb_lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift);
+
+//! Set `r[0..n) = a[0..n) >> shift`. Requires `0 < shift < 64`.
+//! `r` may alias `a`.
+//!
+//! @return the bits shifted out of `a[0]`, in the high bits of the result
+uint64_t limb_rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned shift);
+
+//! Return the number of 1 bits in `a[0..n)`.
+size_t limb_popcount(const uint64_t *a, size_t n);
+
+//! Write `a[0..n)` as exactly `16 * n` lower-case hexadecimal digits,
+//! most significant limb first, with leading zeroes. No terminating
+//! null character is written.
+void limb_to_hex(char *out, const uint64_t *a, size_t n);
+
+//! Element-wise sum of `count` values of `width` limbs each, stored
+//! limb-major: limb `i` of value `j` is at index `i * count + j`. Each
+//! sum is taken modulo `2^(64 * width)`. `r` may alias `a` or `b`.
+void limb_batch_add(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count);
+
+//! Element-wise difference modulo `2^(64 * width)` of values stored
+//! like those of limb_batch_add. `r` may alias `a` or `b`.
+void limb_batch_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t width, size_t count);
+
+//! Element-wise comparison of values stored like those of
+//! limb_batch_add: `out[j]` is set to -1, 0 or 1 if value `j` of `a`
+//! is less than, equal to or greater than value `j` of `b`.
+void limb_batch_cmp(int *out, const uint64_t *a, const uint64_t *b, size_t width, size_t count);
+
+//! Set `q[0..n) = a[0..n) / d`. `q` may alias `a`. Requires `d != 0`.
+//!
+//! @return the remainder `a mod d`
+uint64_t limb_divrem_1(uint64_t *q, const uint64_t *a, size_t n, uint64_t d);
+
+//! Return `a[0..n) mod d`, like limb_divrem_1 but without writing a
+//! quotient. Requires `d != 0`.
+uint64_t limb_mod_1(const uint64_t *a, size_t n, uint64_t d);
+
+//! Long division (Knuth's Algorithm D): set `q[0..an-dn+1) = a / d`
+//! and `r[0..dn) = a mod d`. Requires `an >= dn >= 2` and
+//! `d[dn-1] != 0`; `q` and `r` must not overlap the operands.
+void limb_divrem(uint64_t *q, uint64_t *r, const uint64_t *a, size_t an, const uint64_t *d, size_t dn);
+
+//! Cofactors of a run of Euclid steps: the steps take `(a, b)` to
+//! `(A*a + B*b, C*a + D*b)`. The signs alternate, so in each row one
+//! cofactor is at most 0 and the other at least 0.
+struct LimbLehmerMatrix {
+  int64_t A, B, C, D;
+};
+
+//! Lehmer step: find the Euclid quotients of `a` and `b` that their
+//! leading 126 bits determine, and collect them into a cofactor matrix
+//! whose entries are below 2^62 in magnitude. Requires `a >= b`,
+//! `a[n-1] != 0` and `b` zero-padded to `n` limbs.
+//!
+//! @return false if not even the first quotient could be determined, in
+//!         which case the caller needs a full division step instead
+bool limb_lehmer_matrix(LimbLehmerMatrix &m, const uint64_t *a, const uint64_t *b, size_t n);
+
+//! Apply one row of a Lehmer matrix: set `r[0..n) = p * a + q * b`,
+//! where `(p, q)` is `(A, B)` or `(C, D)` of a matrix from
+//! limb_lehmer_matrix for `a` and `b`. The cofactors have opposite signs
+//! (or one is 0) and the result is a remainder of the Euclid sequence,
+//! so it is non-negative and fits in `n` limbs; `r` must not overlap the
+//! operands.
+void limb_lehmer_combine(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n, int64_t p, int64_t q);
+
+//! Greatest common divisor: set `g = gcd(a[0..an), b[0..bn))` using
+//! Lehmer's algorithm down to limb_lehmer_threshold limbs and binary
+//! GCD below that. Requires both values to be nonzero with their top
+//! limbs nonzero; `g` needs room for `min(an, bn)` limbs.
+//!
+//! @return the number of limbs written to `g`
+size_t limb_gcd(uint64_t *g, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+//! Schoolbook multiplication: set `r[0..an+bn) = a[0..an) * b[0..bn)`.
+//! Requires `an >= bn >= 1`; `r` must not overlap the operands.
+void limb_mul_basecase(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+//! Schoolbook squaring: set `r[0..2n) = a[0..n)^2`, computing each cross
+//! product once. Requires `n >= 1`; `r` must not overlap `a`.
+void limb_sqr_basecase(uint64_t *r, const uint64_t *a, size_t n);
+
+//! Multiplication by number-theoretic transforms modulo three primes,
+//! combined with the Chinese remainder theorem: set
+//! `r[0..an+bn) = a[0..an) * b[0..bn)`. The result is exact for any
+//! `an + bn` up to 2^55 limbs. Requires `an >= bn >= 1`; `r` must not
+//! overlap the operands.
+void limb_mul_ntt(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+//! Set `r[0..2n) = a[0..n)^2`, choosing schoolbook, Karatsuba, Toom-3
+//! or NTT squaring from the operand size. Each takes about half to two
+//! thirds of the time of the matching multiplication. Requires `n >= 1`;
+//! `r` must not overlap `a`.
+void limb_sqr(uint64_t *r, const uint64_t *a, size_t n);
+
+//! Set `r[0..an+bn) = a[0..an) * b[0..bn)`, choosing schoolbook,
+//! Karatsuba, Toom-3 or NTT multiplication from the operand sizes, and
+//! limb_sqr when `a` and `b` are the same array.
+//! Requires `an >= bn >= 1`; `r` must not overlap the operands.
+void limb_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn);
+
+#endif // LIMB_OPS_H
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include "limb_vector.h"
+
+//Two views are equal when they have the same length and the same limbs
+bool LimbView::operator==(const LimbView &rhs) const {
+  return count == rhs.count && std::equal(begin(), end(), rhs.begin());
+}
+
+//Copy constructor, starts with the inline buffer and only allocates for larger values
+LimbVector::LimbVector(const LimbVector &other)
+  : limbs(inline_limbs), count(0), capacity_limbs(INLINE_LIMBS) {
+  assign(other.begin(), other.end());
+}
+
+//Move constructor, steals a heap buffer but has to copy inline limbs
+LimbVector::LimbVector(LimbVector &&other) noexcept
+  : limbs(inline_limbs), count(other.count), capacity_limbs(INLINE_LIMBS) {
+  if (other.is_inline()) {
+    std::copy(other.inline_limbs, other.inline_limbs + other.count, inline_limbs);
+  } else {
+    limbs = other.limbs;
+    capacity_limbs = other.capacity_limbs;
+    other.limbs = other.inline_limbs;
+    other.capacity_limbs = INLINE_LIMBS;
+  }
+  other.count = 0;
+}
+
+//Destructor, frees the heap buffer if the limbs spilled out of the inline buffer
+LimbVector::~LimbVector() {
+  if (!is_inline()) {
+    delete[] limbs;
+  }
+}
+
+//Copy assignment, reuses the existing buffer when it is large enough
+LimbVector &LimbVector::operator=(const LimbVector &rhs) {
+  if (this != &rhs) {
+    assign(rhs.begin(), rhs.end());
+  }
+  return *this;
+}
+
+//Move assignment, takes over a heap buffer from rhs and releases our own
+LimbVector &LimbVector::operator=(LimbVector &&rhs) noexcept {
+  if (this == &rhs) {
+    return *this;
+  }
+  if (rhs.is_inline()) {
+    //Copying at most INLINE_LIMBS limbs always fits in our current buffer
+    std::copy(rhs.inline_limbs, rhs.inline_limbs + rhs.count, limbs);
+    count = rhs.count;
+  } else {
+    if (!is_inline()) {
+      delete[] limbs;
+    }
+    limbs = rhs.limbs;
+    count = rhs.count;
+    capacity_limbs = rhs.capacity_limbs;
+    rhs.limbs = rhs.inline_limbs;
+    rhs.capacity_limbs = INLINE_LIMBS;
+  }
+  rhs.count = 0;
+  return *this;
+}
+
+//Assignment from an initializer list of limbs
+LimbVector &LimbVector::operator=(std::initializer_list<uint64_t> vals) {
+  assign(vals.begin(), vals.end());
+  return *this;
+}
+
+//Resizes the array, filling any new limbs with value
+void LimbVector::resize(size_t n, uint64_t value) {
+  if (n > capacity_limbs) { //grow geometrically so repeated resizes stay cheap
+    grow(std::max(n, 2 * capacity_limbs));
+  }
+  if (n > count) {
+    std::fill(limbs + count, limbs + n, value);
+  }
+  count = n;
+}
+
+//Replaces the contents with a copy of [first, last)
+void LimbVector::assign(const uint64_t *first, const uint64_t *last) {
+  size_t n = last - first;
+  count = 0; //nothing needs to survive a reallocation
+  reserve(n);
+  std::copy(first, last, limbs);
+  count = n;
+}
+
+//Moves the limbs into a new heap buffer of n limbs
+void LimbVector::grow(size_t n) {
+  uint64_t *buffer = new uint64_t[n];
+  std::copy(limbs, limbs + count, buffer);
+  if (!is_inline()) {
+    delete[] limbs;
+  }
+  limbs = buffer;
+  capacity_limbs = n;
+}
@@ -0,0 +1,144 @@
+#ifndef LIMB_VECTOR_H
+#define LIMB_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+//! @file
+//! Storage for the `uint64_t` limbs of a BigInt magnitude.
+
+//! Read-only view of a contiguous array of limbs, in order from
+//! less-significant to more-significant. The view does not own the
+//! limbs; it is only valid as long as the object it was taken from
+//! is alive and unmodified.
+class LimbView {
+private:
+  const uint64_t *limbs;
+  size_t count;
+
+public:
+  typedef const uint64_t *const_iterator;
+  typedef std::reverse_iterator<const uint64_t *> const_reverse_iterator;
+
+  //! Constructor.
+  //!
+  //! @param limbs pointer to the first (least significant) limb
+  //! @param count number of limbs
+  LimbView(const uint64_t *limbs, size_t count) : limbs(limbs), count(count) { }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const uint64_t *data() const { return limbs; }
+  uint64_t operator[](size_t index) const { return limbs[index]; }
+  const_iterator begin() const { return limbs; }
+  const_iterator end() const { return limbs + count; }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  //! Copy the limbs into a new `std::vector`, so code that expects
+  //! a vector of limbs can still be given a view.
+  operator std::vector<uint64_t>() const { return std::vector<uint64_t>(begin(), end()); }
+
+  //! Element-wise equality (views of different lengths are never equal).
+  bool operator==(const LimbView &rhs) const;
+  bool operator!=(const LimbView &rhs) const { return !(*this == rhs); }
+  bool operator==(const std::vector<uint64_t> &rhs) const { return *this == LimbView(rhs.data(), rhs.size()); }
+  bool operator!=(const std::vector<uint64_t> &rhs) const { return !(*this == rhs); }
+};
+
+//! Growable array of limbs with room for a few limbs inside the object
+//! itself. Values that fit in `INLINE_LIMBS` limbs never touch the heap;
+//! larger values spill into a heap buffer. The interface is the subset
+//! of `std::vector` that BigInt uses.
+class LimbVector {
+public:
+  //! Number of limbs stored without a heap allocation.
+  static const size_t INLINE_LIMBS = 4;
+
+  typedef uint64_t *iterator;
+  typedef const uint64_t *const_iterator;
+  typedef std::reverse_iterator<const uint64_t *> const_reverse_iterator;
+
+private:
+  uint64_t *limbs;     // points at inline_limbs or a heap buffer
+  size_t count;
+  size_t capacity_limbs;
+  uint64_t inline_limbs[INLINE_LIMBS];
+
+public:
+  //! Default constructor: an empty array using the inline buffer.
+  LimbVector() : limbs(inline_limbs), count(0), capacity_limbs(INLINE_LIMBS) { }
+
+  //! Copy constructor. The copy only allocates if the limbs do not
+  //! fit in the inline buffer.
+  LimbVector(const LimbVector &other);
+
+  //! Move constructor. A heap buffer is taken over; inline limbs are
+  //! copied. `other` is left empty.
+  LimbVector(LimbVector &&other) noexcept;
+
+  ~LimbVector();
+
+  LimbVector &operator=(const LimbVector &rhs);
+  LimbVector &operator=(LimbVector &&rhs) noexcept;
+  LimbVector &operator=(std::initializer_list<uint64_t> vals);
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  size_t capacity() const { return capacity_limbs; }
+
+  //! Check whether the limbs currently live in the inline buffer.
+  bool is_inline() const { return limbs == inline_limbs; }
+
+  uint64_t *data() { return limbs; }
+  const uint64_t *data() const { return limbs; }
+  uint64_t &operator[](size_t index) { return limbs[index]; }
+  uint64_t operator[](size_t index) const { return limbs[index]; }
+  uint64_t &back() { return limbs[count - 1]; }
+  uint64_t back() const { return limbs[count - 1]; }
+
+  iterator begin() { return limbs; }
+  iterator end() { return limbs + count; }
+  const_iterator begin() const { return limbs; }
+  const_iterator end() const { return limbs + count; }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  //! View of the current limbs.
+  LimbView view() const { return LimbView(limbs, count); }
+
+  //! Make sure there is room for at least `n` limbs without reallocating.
+  void reserve(size_t n) {
+    if (n > capacity_limbs) {
+      grow(n);
+    }
+  }
+
+  //! Change the number of limbs; new limbs are set to `value`.
+  void resize(size_t n, uint64_t value = 0);
+
+  void push_back(uint64_t value) {
+    if (count == capacity_limbs) {
+      grow(2 * capacity_limbs);
+    }
+    limbs[count++] = value;
+  }
+
+  void pop_back() { --count; }
+
+  //! Remove all limbs. Any heap buffer is kept for reuse.
+  void clear() { count = 0; }
+
+  //! Replace the contents with the limbs in `[first, last)`, which
+  //! must not point into this array.
+  void assign(const uint64_t *first, const uint64_t *last);
+
+private:
+  //! Move the limbs to a heap buffer with room for `n` limbs.
+  void grow(size_t n);
+};
+
+#endif // LIMB_VECTOR_H
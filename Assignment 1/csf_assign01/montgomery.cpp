@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <stdexcept>
+#include "montgomery.h"
+#include "limb_arena.h"
+#include "limb_ops.h"
+
+//Picks the sliding window width for an exponent of the given length,
+//balancing the 2^(k-1) precomputed powers against the multiplications saved
+static unsigned window_bits(size_t exponent_bits) {
+  static const size_t LIMITS[] = { 7, 25, 81, 241, 673, 1793 };
+  unsigned k = 1;
+  while (k <= 6 && exponent_bits > LIMITS[k - 1]) {
+    ++k;
+  }
+  return k;
+}
+
+//Returns bit i of a[]
+static unsigned limb_bit(const uint64_t *a, size_t i) {
+  return (a[i / 64] >> (i % 64)) & 1;
+}
+
+//Constructor, computes -m^-1 mod 2^64 and the powers of R used for conversions
+MontgomeryContext::MontgomeryContext(const BigInt &modulus) : modulus(modulus) {
+  if (modulus.is_negative() || modulus.is_zero() || (modulus.magnitude[0] & 1) == 0) {
+    throw std::invalid_argument("Montgomery modulus must be odd and positive");
+  }
+
+  n = limb_normalized_size(modulus.magnitude.data(), modulus.magnitude.size());
+  m.assign(modulus.magnitude.begin(), modulus.magnitude.begin() + n);
+
+  //Newton iteration for the inverse mod 2^64: each step doubles the
+  //number of correct low bits, and m0 is its own inverse mod 8
+  uint64_t inv = m[0];
+  for (int i = 0; i < 5; ++i) {
+    inv *= 2 - m[0] * inv;
+  }
+  m_inv = -inv;
+
+  BigInt r = BigInt(1) << unsigned(64 * n);
+  r_mod.resize(n);
+  reduce(r_mod.data(), r);
+  r2_mod.resize(n);
+  reduce(r2_mod.data(), r << unsigned(64 * n));
+}
+
+//Reduces value into [0, m) and zero-pads it to n limbs
+void MontgomeryContext::reduce(uint64_t *r, const BigInt &value) const {
+  BigInt reduced = value.mod(modulus);
+  size_t size = reduced.magnitude.size();
+  std::copy(reduced.magnitude.begin(), reduced.magnitude.end(), r);
+  std::fill(r + size, r + n, 0);
+}
+
+//Word-by-word Montgomery reduction. Each step clears t[i] by adding a
+//multiple of m; the carry out of that step belongs at t[i + n], so it is
+//parked in the now-zero t[i] and all carries are added in one pass at the end.
+void MontgomeryContext::redc(uint64_t *r, uint64_t *t) const {
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t u = t[i] * m_inv;
+    t[i] = limb_addmul_1(t + i, m.data(), n, u);
+  }
+
+  //The sum is below 2m, so one subtraction brings it into [0, m)
+  uint64_t carry = limb_add_n(r, t + n, t, n);
+  if (carry || limb_cmp(r, m.data(), n) >= 0) {
+    limb_sub_n(r, r, m.data(), n);
+  }
+}
+
+void MontgomeryContext::mont_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t *t) const {
+  limb_mul(t, a, n, b, n);
+  redc(r, t);
+}
+
+BigInt MontgomeryContext::to_bigint(const uint64_t *limbs) const {
+  BigInt result;
+  result.magnitude.assign(limbs, limbs + n);
+  result.trim_leading_zeroes();
+  return result;
+}
+
+//a * R * b * R^-1 = a * b, so one conversion into Montgomery form is enough
+BigInt MontgomeryContext::mul(const BigInt &a, const BigInt &b) const {
+  LimbScratchScope scratch;
+  uint64_t *x = scratch.allocate(n);
+  uint64_t *y = scratch.allocate(n);
+  uint64_t *t = scratch.allocate(2 * n);
+  reduce(x, a);
+  reduce(y, b);
+  mont_mul(x, x, r2_mod.data(), t);
+  mont_mul(x, x, y, t);
+  return to_bigint(x);
+}
+
+BigInt MontgomeryContext::modpow(const BigInt &base, const BigInt &exponent) const {
+  if (exponent.is_negative()) {
+    throw std::invalid_argument("Exponent must not be negative");
+  }
+
+  const uint64_t *e = exponent.magnitude.data();
+  size_t bits = limb_bit_length(e, exponent.magnitude.size());
+  unsigned k = window_bits(bits);
+
+  LimbScratchScope scratch;
+  uint64_t *t = scratch.allocate(2 * n);
+  uint64_t *acc = scratch.allocate(n);
+
+  //table[i] holds base^(2i+1) in Montgomery form
+  size_t table_size = size_t(1) << (k - 1);
+  uint64_t *table = scratch.allocate(table_size * n);
+  reduce(acc, base);
+  mont_mul(table, acc, r2_mod.data(), t);
+  if (table_size > 1) {
+    mont_mul(acc, table, table, t); //base^2
+    for (size_t i = 1; i < table_size; ++i) {
+      mont_mul(table + i * n, table + (i - 1) * n, acc, t);
+    }
+  }
+
+  std::copy(r_mod.begin(), r_mod.end(), acc); //1 in Montgomery form
+  bool started = false;
+  size_t i = bits;
+  while (i > 0) {
+    if (!limb_bit(e, i - 1)) { //zero bits outside a window only square
+      if (started) {
+        mont_mul(acc, acc, acc, t);
+      }
+      --i;
+      continue;
+    }
+
+    //The window is bits [low, i) and must end in a 1 so it is odd
+    size_t low = i > k ? i - k : 0;
+    while (!limb_bit(e, low)) {
+      ++low;
+    }
+    size_t value = 0;
+    for (size_t j = i; j > low; --j) {
+      value = (value << 1) | limb_bit(e, j - 1);
+    }
+
+    const uint64_t *power = table + (value >> 1) * n;
+    if (started) {
+      for (size_t j = low; j < i; ++j) {
+        mont_mul(acc, acc, acc, t);
+      }
+      mont_mul(acc, acc, power, t);
+    } else {
+      std::copy(power, power + n, acc);
+      started = true;
+    }
+    i = low;
+  }
+
+  //Convert out of Montgomery form
+  std::copy(acc, acc + n, t);
+  std::fill(t + n, t + 2 * n, 0);
+  redc(acc, t);
+  return to_bigint(acc);
+}
@@ -0,0 +1,70 @@
+#ifndef MONTGOMERY_H
+#define MONTGOMERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bigint.h"
+
+//! @file
+//! Montgomery arithmetic for repeated multiplication modulo a fixed
+//! odd modulus.
+
+//! Precomputed values for Montgomery multiplication modulo an odd
+//! modulus `m` of `n` limbs, with `R = 2^(64n)`. Building a context
+//! costs one division; after that every modular multiplication is a
+//! limb product plus a reduction that needs no division at all. Keep a
+//! context around and reuse it for every operation with the same
+//! modulus (BigInt::modpow caches the most recent one per thread).
+class MontgomeryContext {
+private:
+  BigInt modulus;
+  size_t n;                     // limbs in the modulus
+  uint64_t m_inv;               // -m^-1 mod 2^64
+  std::vector<uint64_t> m;      // modulus limbs
+  std::vector<uint64_t> r_mod;  // R mod m (1 in Montgomery form)
+  std::vector<uint64_t> r2_mod; // R^2 mod m, for converting into Montgomery form
+
+public:
+  //! Constructor.
+  //!
+  //! @param modulus the modulus, which must be odd and positive
+  //! @throw std::invalid_argument if the modulus is not odd and positive
+  explicit MontgomeryContext(const BigInt &modulus);
+
+  //! @return the modulus this context was built for
+  const BigInt &get_modulus() const { return modulus; }
+
+  //! Modular multiplication.
+  //!
+  //! @param a a BigInt value (any sign or size)
+  //! @param b a BigInt value (any sign or size)
+  //! @return `a * b mod m`, in the range `[0, m)`
+  BigInt mul(const BigInt &a, const BigInt &b) const;
+
+  //! Modular exponentiation using left-to-right sliding windows, with
+  //! the window width chosen from the exponent length.
+  //!
+  //! @param base the base (any sign or size)
+  //! @param exponent the exponent, which must not be negative
+  //! @return `base^exponent mod m`, in the range `[0, m)`
+  //! @throw std::invalid_argument if the exponent is negative
+  BigInt modpow(const BigInt &base, const BigInt &exponent) const;
+
+private:
+  //! Set `r[0..n)` to `value mod m`.
+  void reduce(uint64_t *r, const BigInt &value) const;
+
+  //! Montgomery reduction: set `r[0..n) = t * R^-1 mod m`. `t[0..2n)`
+  //! must be less than `m * R` and is overwritten.
+  void redc(uint64_t *r, uint64_t *t) const;
+
+  //! Montgomery product: set `r[0..n) = a * b * R^-1 mod m`, using
+  //! `t[0..2n)` as scratch space. `r` may alias `a` or `b`.
+  void mont_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t *t) const;
+
+  //! Build a BigInt from `n` limbs.
+  BigInt to_bigint(const uint64_t *limbs) const;
+};
+
+#endif // MONTGOMERY_H
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include "radix_powers.h"
+
+//The powers of one radix. The first `count` entries of `levels` are
+//published with a release store, so readers that load `count` with
+//acquire can use them without the lock; the deque owns the values and
+//never moves them as it grows
+struct RadixTable {
+  std::mutex mutex;
+  std::deque<BigInt> values;
+  const BigInt *levels[RadixPowers::MAX_LEVELS] = {};
+  std::atomic<size_t> count{0};
+};
+
+static RadixTable tables[37];
+
+//Multiplies by each radix until one more digit would overflow a limb
+struct RadixChunkTable {
+  RadixChunk chunks[37];
+
+  RadixChunkTable() {
+    chunks[0] = chunks[1] = { 1, 0 };
+    for (unsigned radix = 2; radix <= 36; ++radix) {
+      RadixChunk &c = chunks[radix];
+      c = { radix, 1 };
+      while (c.base <= UINT64_MAX / radix) {
+        c.base *= radix;
+        ++c.digits;
+      }
+    }
+  }
+};
+
+RadixChunk RadixPowers::chunk(unsigned radix) {
+  static const RadixChunkTable table;
+  return table.chunks[radix];
+}
+
+//Each power is the square of the previous one; they are computed under the
+//radix's lock, so a power is only ever computed once
+const BigInt *const *RadixPowers::get(unsigned radix, size_t levels) {
+  assert(levels <= MAX_LEVELS);
+  RadixTable &table = tables[radix];
+  if (table.count.load(std::memory_order_acquire) >= levels) {
+    return table.levels;
+  }
+
+  std::lock_guard<std::mutex> lock(table.mutex);
+  size_t count = table.count.load(std::memory_order_relaxed);
+  while (count < levels) {
+    if (count == 0) {
+      table.values.push_back(BigInt(chunk(radix).base));
+    } else {
+      table.values.push_back(table.levels[count - 1]->square());
+    }
+    table.levels[count] = &table.values.back();
+    table.count.store(++count, std::memory_order_release);
+  }
+  return table.levels;
+}
+
+size_t RadixPowers::cached_levels(unsigned radix) {
+  return tables[radix].count.load(std::memory_order_acquire);
+}
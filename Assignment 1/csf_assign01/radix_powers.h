@@ -0,0 +1,53 @@
+#ifndef RADIX_POWERS_H
+#define RADIX_POWERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bigint.h"
+
+//! @file
+//! Shared cache of the powers used for radix conversion.
+
+//! The largest power of a radix that fits in a limb: string conversion
+//! handles that many digits per single-limb division or multiplication.
+struct RadixChunk {
+  uint64_t base;  //!< radix^digits
+  size_t digits;  //!< number of digits per chunk
+};
+
+//! Powers `chunk^(2^k)` of each radix's chunk base, used by
+//! BigInt::to_string and BigInt::from_string to split large values in
+//! half. The tables are shared by all threads and grow on demand, so
+//! repeated conversions of values of similar size compute each power
+//! only once. Powers are never removed, and the pointers handed out stay
+//! valid for the life of the program.
+//!
+//! Each radix has its own lock, taken only to add levels; requests for
+//! levels that are already cached read a published level count and take
+//! no lock, so a thread computing a huge power never blocks conversions
+//! that need only smaller ones.
+class RadixPowers {
+public:
+  //! A value has fewer than 2^64 digits, so it never needs more levels
+  static constexpr size_t MAX_LEVELS = 64;
+
+  //! @param radix the radix, from 2 to 36
+  //! @return the chunk for the radix
+  static RadixChunk chunk(unsigned radix);
+
+  //! Get the powers `chunk^(2^k)` for `k = 0 .. levels - 1`, computing
+  //! any that are not cached yet. Safe to call from several threads.
+  //!
+  //! @param radix the radix, from 2 to 36
+  //! @param levels the number of powers needed, at most MAX_LEVELS
+  //! @return the shared table of powers, with `*result[k] == chunk^(2^k)`
+  //!         for every `k < levels`
+  static const BigInt *const *get(unsigned radix, size_t levels);
+
+  //! @param radix the radix, from 2 to 36
+  //! @return the number of powers currently cached for the radix
+  static size_t cached_levels(unsigned radix);
+};
+
+#endif // RADIX_POWERS_H